@@ -1,15 +1,45 @@
 LOCAL_PATH := $(call my-dir)
 
+LS_CPP=$(subst $(1)/,,$(wildcard $(1)/*.cpp))
+
+# Platform neutral engine core, shared with the iOS app and the Linux host
+# tools.
+ENGINE_PATH := ../../../Engine
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := snowflakes_engine
+LOCAL_SRC_FILES := $(addprefix $(ENGINE_PATH)/,$(call LS_CPP,$(LOCAL_PATH)/$(ENGINE_PATH)))
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/$(ENGINE_PATH)
+
+# Not every ARMv7 core has NEON, so on armeabi-v7a the engine is built
+# without it, apart from the NEON kernel variant, which is only used where
+# cpufeatures finds NEON. The x86 ABIs need no flags: the AVX2 variant marks
+# its own functions.
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON  := false
+LOCAL_SRC_FILES := $(patsubst %/kernels_neon.cpp,%/kernels_neon.cpp.neon,$(LOCAL_SRC_FILES))
+endif
+
+LOCAL_STATIC_LIBRARIES := cpufeatures
+
+include $(BUILD_STATIC_LIBRARY)
+
 include $(CLEAR_VARS)
 
-LS_CPP=$(subst $(1)/,,$(wildcard $(1)/*.cpp))
 LOCAL_MODULE    := snowflakes
 LOCAL_SRC_FILES := $(call LS_CPP,$(LOCAL_PATH))
 
 LOCAL_LDLIBS    := -llog -landroid -lEGL -lGLESv2
-LOCAL_STATIC_LIBRARIES := android_native_app_glue png
+
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON  := false
+endif
+
+LOCAL_STATIC_LIBRARIES := snowflakes_engine android_native_app_glue png
 
 include $(BUILD_SHARED_LIBRARY)
 
+$(call import-module,android/cpufeatures)
 $(call import-module,android/native_app_glue)
 $(call import-module,libpng)
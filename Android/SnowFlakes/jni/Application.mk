@@ -1 +1,19 @@
 APP_PLATFORM := android-9
+
+# One library per ABI in the APK. The 64 bit ABIs start at android-21, which
+# ndk-build uses for them regardless. The engine picks its NEON or AVX2
+# kernels at run time, see Engine/kernels.h.
+APP_ABI := armeabi-v7a arm64-v8a x86 x86_64
+APP_STL := c++_static
+APP_CPPFLAGS += -std=c++14
+
+# ndk-build SNOWFLAKES_PROFILER=1 compiles in the profiler zones.
+ifeq ($(SNOWFLAKES_PROFILER),1)
+APP_CPPFLAGS += -DGUILDHALL_PROFILER
+endif
+
+# ndk-build SNOWFLAKES_RECORD=1 records every run of the simulation, see
+# SimulationRecorder.
+ifeq ($(SNOWFLAKES_RECORD),1)
+APP_CPPFLAGS += -DGUILDHALL_RECORD
+endif
@@ -0,0 +1,222 @@
+#include "asset_loader.h"
+#include "log.h"
+#include "profiler.h"
+#include "timer.h"
+
+namespace guildhall {
+
+AssetLoader::AssetLoader( int32_t pWorkerCount ) :
+		m_workerCount( pWorkerCount > 0 ? pWorkerCount : 1 ),
+		m_busyCount( 0 ),
+		m_stopping( false ),
+		m_completed( NULL ),
+		m_outstanding( 0 )
+{
+}
+
+AssetLoader::~AssetLoader()
+{
+	stop();
+}
+
+status AssetLoader::start()
+{
+	if( !m_workers.empty() )
+		return STATUS_OK;
+
+	m_stopping = false;
+
+	for( int32_t i = 0; i < m_workerCount; ++i )
+	{
+		m_workers.push_back( std::thread( &AssetLoader::run, this ) );
+	}
+
+	return STATUS_OK;
+}
+
+void AssetLoader::stop()
+{
+	cancel();
+
+	{
+		std::lock_guard<std::mutex> lLock( m_requestMutex );
+		m_stopping = true;
+	}
+
+	m_requestCondition.notify_all();
+
+	for( size_t i = 0; i < m_workers.size(); ++i )
+	{
+		m_workers[i].join();
+	}
+
+	m_workers.clear();
+}
+
+status AssetLoader::enqueue( Texture* pTexture )
+{
+	if( pTexture->loadPlaceholder() != STATUS_OK )
+		return STATUS_ERROR;
+
+	Job* lJob = m_jobs.create();
+
+	if( lJob == NULL )
+	{
+		Log::error( "Unable to queue %s, %d textures are loading already.", pTexture->getPath(), MaxJobs );
+		return STATUS_ERROR;
+	}
+
+	lJob->m_texture = pTexture;
+	lJob->m_result = STATUS_ERROR;
+	lJob->m_next = NULL;
+
+	m_outstanding.fetch_add( 1, std::memory_order_relaxed );
+
+	{
+		std::lock_guard<std::mutex> lLock( m_requestMutex );
+		m_requests.push_back( lJob );
+	}
+
+	m_requestCondition.notify_one();
+	return STATUS_OK;
+}
+
+int32_t AssetLoader::update( double pBudget )
+{
+	collect();
+
+	int32_t lUploadCount = 0;
+	double lStart = getCurrentTimeInSeconds();
+
+	while( !m_pending.empty() )
+	{
+		if( lUploadCount > 0 && getCurrentTimeInSeconds() - lStart >= pBudget )
+			break;
+
+		Job* lJob = m_pending.front();
+		m_pending.pop_front();
+
+		if( lJob->m_result == STATUS_OK )
+		{
+			if( lJob->m_texture->upload() == STATUS_OK )
+				++lUploadCount;
+		}
+		else
+		{
+			// Keeps the placeholder rather than showing nothing.
+			Log::error( "Unable to decode %s", lJob->m_texture->getPath() );
+		}
+
+		m_jobs.destroy( lJob );
+		m_outstanding.fetch_sub( 1, std::memory_order_relaxed );
+	}
+
+	return lUploadCount;
+}
+
+void AssetLoader::cancel()
+{
+	std::unique_lock<std::mutex> lLock( m_requestMutex );
+
+	while( !m_requests.empty() )
+	{
+		m_jobs.destroy( m_requests.front() );
+		m_requests.pop_front();
+		m_outstanding.fetch_sub( 1, std::memory_order_relaxed );
+	}
+
+	// Workers signal when they go idle.
+	while( m_busyCount > 0 )
+	{
+		m_requestCondition.wait( lLock );
+	}
+
+	lLock.unlock();
+
+	collect();
+
+	while( !m_pending.empty() )
+	{
+		m_jobs.destroy( m_pending.front() );
+		m_pending.pop_front();
+		m_outstanding.fetch_sub( 1, std::memory_order_relaxed );
+	}
+}
+
+bool AssetLoader::isIdle()
+{
+	return m_outstanding.load( std::memory_order_relaxed ) == 0;
+}
+
+void AssetLoader::run()
+{
+	std::unique_lock<std::mutex> lLock( m_requestMutex );
+
+	GUILDHALL_PROFILE_THREAD( "Asset loader" );
+
+	while( true )
+	{
+		while( !m_stopping && m_requests.empty() )
+		{
+			m_requestCondition.wait( lLock );
+		}
+
+		if( m_stopping )
+			break;
+
+		Job* lJob = m_requests.front();
+		m_requests.pop_front();
+		++m_busyCount;
+		lLock.unlock();
+
+		{
+			GUILDHALL_PROFILE_ZONE( "Decode texture" );
+			lJob->m_result = lJob->m_texture->decode();
+		}
+
+		complete( lJob );
+
+		lLock.lock();
+		--m_busyCount;
+
+		// cancel() may be waiting for the pool to go idle.
+		if( m_busyCount == 0 )
+			m_requestCondition.notify_all();
+	}
+}
+
+void AssetLoader::complete( Job* pJob )
+{
+	Job* lHead = m_completed.load( std::memory_order_relaxed );
+
+	do
+	{
+		pJob->m_next = lHead;
+	}
+	while( !m_completed.compare_exchange_weak( lHead, pJob,
+			std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+void AssetLoader::collect()
+{
+	Job* lJob = m_completed.exchange( NULL, std::memory_order_acquire );
+
+	// The stack holds the newest job first; reverses it so that textures
+	// are uploaded in the order they finished decoding.
+	Job* lReversed = NULL;
+
+	while( lJob != NULL )
+	{
+		Job* lNext = lJob->m_next;
+		lJob->m_next = lReversed;
+		lReversed = lJob;
+		lJob = lNext;
+	}
+
+	for( ; lReversed != NULL; lReversed = lReversed->m_next )
+	{
+		m_pending.push_back( lReversed );
+	}
+}
+
+}
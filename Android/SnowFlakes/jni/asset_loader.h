@@ -0,0 +1,87 @@
+#ifndef _GUILDHALL_ASSET_LOADER_H_
+#define _GUILDHALL_ASSET_LOADER_H_
+
+#include "pool.h"
+#include "texture.h"
+#include "types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace guildhall {
+
+// Decodes textures on a pool of worker threads and uploads them on the GL
+// thread, a few per frame, so that the first frame never waits on PNG
+// decoding. Queued textures show a placeholder until they are uploaded.
+class AssetLoader
+{
+public:
+
+	static const int32_t MaxJobs = 64;
+
+	AssetLoader( int32_t pWorkerCount );
+	~AssetLoader();
+
+	status start();
+	void stop();
+
+	// GL thread only. Gives pTexture a placeholder and queues it for
+	// decoding. The texture must stay alive until it has been uploaded
+	// or cancel() has returned. At most MaxJobs textures can be queued,
+	// decoding or waiting for their upload at once.
+	status enqueue( Texture* pTexture );
+
+	// GL thread only. Uploads decoded textures until pBudget seconds have
+	// been spent; at least one texture is uploaded per call if any are
+	// ready. Returns the number of textures uploaded.
+	int32_t update( double pBudget );
+
+	// GL thread only. Waits for in-flight decodes to finish and drops
+	// every queued or decoded texture without uploading it.
+	void cancel();
+
+	bool isIdle();
+
+private:
+
+	struct Job
+	{
+		Texture* m_texture;
+		status m_result;
+		Job* m_next;
+	};
+
+	void run();
+	void complete( Job* pJob );
+	void collect();
+
+private:
+
+	int32_t m_workerCount;
+	std::vector<std::thread> m_workers;
+
+	// Jobs are only made and destroyed on the GL thread.
+	Pool<Job, MaxJobs> m_jobs;
+
+	// Requests are rare, so workers simply wait on a condition variable.
+	std::mutex m_requestMutex;
+	std::condition_variable m_requestCondition;
+	std::deque<Job*> m_requests;
+	int32_t m_busyCount;
+	bool m_stopping;
+
+	// Lock-free completion stack. Workers push with a CAS and the GL
+	// thread takes the whole stack at once, so there is no ABA hazard.
+	std::atomic<Job*> m_completed;
+
+	// Completed jobs waiting for their upload, oldest first. GL thread only.
+	std::deque<Job*> m_pending;
+	std::atomic<int32_t> m_outstanding;
+};
+
+}
+#endif // _GUILDHALL_ASSET_LOADER_H_
@@ -0,0 +1,195 @@
+#include "gpu_timer.h"
+#include "log.h"
+#include "profiler.h"
+#include "timer.h"
+
+#include <EGL/egl.h>
+#include <string.h>
+
+namespace guildhall {
+
+GpuTimer::GpuTimer( const char* pName ) :
+		m_name( pName ),
+		m_supported( false ),
+		m_measuring( false ),
+#ifdef GUILDHALL_PROFILER
+		m_track( -1 ),
+#endif
+		m_pending( 0 ),
+		m_submitted( 0 ),
+		m_lastTime( 0.0 ),
+		m_genQueries( NULL ),
+		m_deleteQueries( NULL ),
+		m_beginQuery( NULL ),
+		m_endQuery( NULL ),
+		m_getQueryObjectuiv( NULL ),
+		m_getQueryObjectui64v( NULL )
+{
+	memset( m_queries, 0, sizeof(m_queries) );
+	memset( m_submitTimes, 0, sizeof(m_submitTimes) );
+	resetStats();
+}
+
+status GpuTimer::initialize()
+{
+	release();
+
+	const char* lExtensions = (const char*) glGetString( GL_EXTENSIONS );
+
+	if( lExtensions == NULL || strstr( lExtensions, "GL_EXT_disjoint_timer_query" ) == NULL )
+	{
+		Log::info( "GL_EXT_disjoint_timer_query is not supported, GPU times are not measured." );
+		return STATUS_ERROR;
+	}
+
+	m_genQueries = (PFNGLGENQUERIESEXTPROC) eglGetProcAddress( "glGenQueriesEXT" );
+	m_deleteQueries = (PFNGLDELETEQUERIESEXTPROC) eglGetProcAddress( "glDeleteQueriesEXT" );
+	m_beginQuery = (PFNGLBEGINQUERYEXTPROC) eglGetProcAddress( "glBeginQueryEXT" );
+	m_endQuery = (PFNGLENDQUERYEXTPROC) eglGetProcAddress( "glEndQueryEXT" );
+	m_getQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVEXTPROC) eglGetProcAddress( "glGetQueryObjectuivEXT" );
+	m_getQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC) eglGetProcAddress( "glGetQueryObjectui64vEXT" );
+
+	if( m_genQueries == NULL || m_deleteQueries == NULL || m_beginQuery == NULL || m_endQuery == NULL ||
+			m_getQueryObjectuiv == NULL || m_getQueryObjectui64v == NULL )
+	{
+		Log::warn( "GL_EXT_disjoint_timer_query is advertised without its entry points." );
+		return STATUS_ERROR;
+	}
+
+	m_genQueries( QueryCount, m_queries );
+
+	// Clears a disjoint event from before the first pass.
+	GLint lDisjoint = 0;
+	glGetIntegerv( GL_GPU_DISJOINT_EXT, &lDisjoint );
+
+#ifdef GUILDHALL_PROFILER
+	m_track = Profiler::createTrack( "GPU" );
+#endif
+
+	m_supported = true;
+	return STATUS_OK;
+}
+
+void GpuTimer::release()
+{
+	if( m_supported )
+		m_deleteQueries( QueryCount, m_queries );
+
+	memset( m_queries, 0, sizeof(m_queries) );
+	m_supported = false;
+	m_measuring = false;
+	m_pending = 0;
+	m_submitted = 0;
+}
+
+void GpuTimer::begin()
+{
+	if( !m_supported )
+		return;
+
+	// Rather than wait for the oldest result, this pass goes unmeasured.
+	if( m_submitted - m_pending == (uint32_t) QueryCount )
+	{
+		++m_stats.m_discarded;
+		return;
+	}
+
+	int32_t lSlot = m_submitted % QueryCount;
+
+	m_submitTimes[lSlot] = getCurrentTimeInSeconds();
+
+#ifdef GUILDHALL_PROFILER
+	m_traceSubmitTimes[lSlot] = Profiler::getTimestamp();
+#endif
+
+	m_beginQuery( GL_TIME_ELAPSED_EXT, m_queries[lSlot] );
+	m_measuring = true;
+}
+
+void GpuTimer::end()
+{
+	if( !m_measuring )
+		return;
+
+	m_endQuery( GL_TIME_ELAPSED_EXT );
+	m_measuring = false;
+	++m_submitted;
+}
+
+void GpuTimer::collect()
+{
+	if( !m_supported )
+		return;
+
+	GLuint64 lElapsed[QueryCount];
+	uint32_t lReady = m_pending;
+
+	// Results arrive in submission order.
+	while( lReady != m_submitted )
+	{
+		GLuint lQuery = m_queries[lReady % QueryCount];
+		GLuint lAvailable = GL_FALSE;
+		m_getQueryObjectuiv( lQuery, GL_QUERY_RESULT_AVAILABLE_EXT, &lAvailable );
+
+		if( !lAvailable )
+			break;
+
+		m_getQueryObjectui64v( lQuery, GL_QUERY_RESULT_EXT, &lElapsed[lReady - m_pending] );
+		++lReady;
+	}
+
+	// A disjoint event (a clock change, a context switch on the GPU...)
+	// means that any of the results in flight may be meaningless, the ones
+	// just read included. Reading the flag also clears it.
+	GLint lDisjoint = 0;
+	glGetIntegerv( GL_GPU_DISJOINT_EXT, &lDisjoint );
+
+	if( lDisjoint )
+	{
+		discardPending();
+		return;
+	}
+
+	double lNow = getCurrentTimeInSeconds();
+
+	for( uint32_t i = m_pending; i != lReady; ++i )
+	{
+		double lTime = lElapsed[i - m_pending] * 1.0e-9;
+
+		if( lTime > lNow - m_submitTimes[i % QueryCount] )
+		{
+			++m_stats.m_discarded;
+			continue;
+		}
+
+		m_lastTime = lTime;
+		++m_stats.m_samples;
+		m_stats.m_timeTotal += lTime;
+
+		if( lTime > m_stats.m_timeMax )
+			m_stats.m_timeMax = lTime;
+
+#ifdef GUILDHALL_PROFILER
+		uint64_t lSubmitted = m_traceSubmitTimes[i % QueryCount];
+		Profiler::recordTrack( m_track, m_name, lSubmitted, lSubmitted + lElapsed[i - m_pending] );
+#endif
+	}
+
+	m_pending = lReady;
+}
+
+void GpuTimer::resetStats()
+{
+	memset( &m_stats, 0, sizeof(m_stats) );
+}
+
+void GpuTimer::discardPending()
+{
+	// Queries still running are left to finish; their objects are only
+	// reused once the ring comes round to them again, and beginning a new
+	// query on an object replaces its result.
+	m_stats.m_discarded += m_submitted - m_pending;
+	m_pending = m_submitted;
+}
+
+}
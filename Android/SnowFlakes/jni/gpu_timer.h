@@ -0,0 +1,110 @@
+#ifndef _GUILDHALL_GPU_TIMER_H_
+#define _GUILDHALL_GPU_TIMER_H_
+
+#include "types.h"
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+// Older NDK headers predate GL_EXT_disjoint_timer_query.
+#ifndef GL_EXT_disjoint_timer_query
+#define GL_QUERY_RESULT_EXT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE_EXT 0x8867
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+typedef void (GL_APIENTRYP PFNGLGENQUERIESEXTPROC) (GLsizei n, GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLDELETEQUERIESEXTPROC) (GLsizei n, const GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLBEGINQUERYEXTPROC) (GLenum target, GLuint id);
+typedef void (GL_APIENTRYP PFNGLENDQUERYEXTPROC) (GLenum target);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUIVEXTPROC) (GLuint id, GLenum pname, GLuint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUI64VEXTPROC) (GLuint id, GLenum pname, GLuint64 *params);
+#endif
+
+namespace guildhall {
+
+struct GpuTimerStats
+{
+	uint32_t m_samples;
+	uint32_t m_discarded;   // Lost to disjoint events, a full ring or bad results.
+	double m_timeTotal;
+	double m_timeMax;
+};
+
+// Measures the time the GPU spends on a pass with GL_EXT_disjoint_timer_query
+// (which Mesa exposes for desktop GPUs as well). Queries go into a ring and
+// are read back once their results are available, usually a frame or two
+// later, so measuring never stalls the pipeline. When the ring is full the
+// pass is not measured. A result longer than the time since its pass was
+// submitted cannot be right (Mesa's llvmpipe returns its clock for the
+// first query, thousands of seconds) and is discarded too.
+//
+// With GUILDHALL_PROFILER the passes also appear in the trace, on a "GPU"
+// track. Timer queries only measure durations, so each pass is shown from
+// the moment it was submitted; it ran somewhat later than that on the GPU.
+//
+// Everything must be called on the GL thread with a current context.
+class GpuTimer
+{
+public:
+
+	// Queries in flight.
+	static const int32_t QueryCount = 4;
+
+	// pName must outlive the timer.
+	GpuTimer( const char* pName );
+
+	// Returns STATUS_ERROR without the extension, in which case begin(),
+	// end() and collect() do nothing.
+	status initialize();
+	void release();
+
+	bool isSupported() const { return m_supported; }
+
+	// Around the GL calls of the pass, at most one pass at a time.
+	void begin();
+	void end();
+
+	// Reads back the passes whose results are available. Once per frame.
+	void collect();
+
+	// The most recent pass read back, in seconds.
+	double getLastTime() const { return m_lastTime; }
+
+	void getStats( GpuTimerStats* pStats ) const { *pStats = m_stats; }
+	void resetStats();
+
+private:
+
+	void discardPending();
+
+private:
+
+	const char* m_name;
+	bool m_supported;
+	bool m_measuring;
+
+	GLuint m_queries[QueryCount];
+	double m_submitTimes[QueryCount];
+
+#ifdef GUILDHALL_PROFILER
+	int32_t m_track;
+	uint64_t m_traceSubmitTimes[QueryCount];
+#endif
+
+	// Queries [m_pending, m_submitted) wait for their results.
+	uint32_t m_pending;
+	uint32_t m_submitted;
+
+	double m_lastTime;
+	GpuTimerStats m_stats;
+
+	PFNGLGENQUERIESEXTPROC m_genQueries;
+	PFNGLDELETEQUERIESEXTPROC m_deleteQueries;
+	PFNGLBEGINQUERYEXTPROC m_beginQuery;
+	PFNGLENDQUERYEXTPROC m_endQuery;
+	PFNGLGETQUERYOBJECTUIVEXTPROC m_getQueryObjectuiv;
+	PFNGLGETQUERYOBJECTUI64VEXTPROC m_getQueryObjectui64v;
+};
+
+}
+#endif // _GUILDHALL_GPU_TIMER_H_
@@ -5,13 +5,25 @@
 #include <errno.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#include "arena.h"
+#include "asset_loader.h"
 #include "matrix4x4f.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "program_cache.h"
+#include "shader_variants.h"
+#include "simulation_thread.h"
+#include "snow_renderer.h"
 #include "vector3f.h"
 #include "texture.h"
+#include "timer.h"
 
 using namespace guildhall;
 
@@ -20,32 +32,32 @@ using namespace guildhall;
 #define LOGW(...) ((void)__android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__))
 #define LOGE(...) ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
 
-// The Game's view size or area is 2 units wide and 3 units high.
-const float ViewMaxX = 2;
-const float ViewMaxY = 3;
-
 const int MaxSnowFlakes = 200;
 
-// Each snow flake will wait 3 seconds - then turn or change direction.
-const float TimeTillTurn = 3.0f;
-const float TimeTillTurnNormalizedUnit = 1.0f / TimeTillTurn;
+// Textures are decoded in the background and uploaded on the GL thread
+// with at most this many seconds spent per frame.
+const int TextureLoaderThreads = 1;
+const double TextureUploadBudget = 0.002;
 
-// Snow flake data.
-GLuint g_vertexBufferId;
-GLuint g_colorBufferId;
-GLuint g_pointSizeBufferId;
+// How often the simulation to render handoff stats are logged.
+const double HandoffStatsInterval = 5.0;
 
-float g_pos[MaxSnowFlakes][2];
-float g_vel[MaxSnowFlakes][2];
-float g_col[MaxSnowFlakes][4];
-float g_size[MaxSnowFlakes];
-float g_timeSinceLastTurn[MaxSnowFlakes];
+// What initGL() makes for a window fits in one block of the level arena.
+const size_t LevelArenaBlockSize = 4 * 1024;
 
-inline float RandomFloat( float min, float max )
-{
-	float r = (float)rand() / (float)RAND_MAX;
-	return min + r * (max - min);
-}
+#ifdef GUILDHALL_PROFILER
+// Profiler builds write a trace of the first frame slower than this, and
+// of the moment a three finger touch comes in.
+const double ProfilerFrameTimeTrigger = 0.05;
+const char* ProfilerTraceFile = "/snowflakes_trace.json";
+#endif
+
+#ifdef GUILDHALL_RECORD
+// Recording builds write every run to the internal data directory, and
+// replay the log there instead when one has been put in place.
+const char* SimulationRecordFile = "/last_run.sfr";
+const char* SimulationReplayFile = "/replay.sfr";
+#endif
 
 // Our saved state data.
 struct savedState
@@ -73,46 +85,22 @@ struct engine
 	struct savedState state;
 };
 
-double g_nowTime, g_prevTime;
+double g_statsTime;
 
 //
 // Shader related variables...
 //
 
+AssetLoader* g_assetLoader = NULL;
+ProgramCache* g_programCache = NULL;
+ShaderVariants* g_shaderVariants = NULL;
 Texture* g_texture = NULL;
-Matrix4x4f g_orthographicMatrix;
-
-GLuint g_program;
-GLuint g_a_positionHandle;
-GLuint g_a_colorHandle;
-GLuint g_a_pointSizeHandle;
-GLuint g_u_mvpMatrixHandle;
-GLuint g_u_texture0Handle;
-
-static const char g_vertexShader[] =
-	"attribute vec4 a_position;\n"
-	"attribute vec4 a_color;\n"
-	"attribute float a_pointSize;\n"
-	"uniform mat4 u_mvpMatrix;\n"
-	"varying vec4 v_color;\n"
-	"varying vec2 v_texCoord;\n"
-
-	"void main()\n"
-    "{\n"
-	"    gl_Position = u_mvpMatrix * a_position;"
-	"    v_color = a_color;"
-	"    gl_PointSize = a_pointSize;"
-	"}\n";
-
-static const char g_fragmentShader[] =
-	"precision mediump float;\n"
-	"varying vec4 v_color;"
-	"uniform sampler2D u_texture0;\n"
-
-	"void main()\n"
-	"{\n"
-	"    gl_FragColor = v_color * texture2D( u_texture0, gl_PointCoord );\n"
-	"}\n";
+
+// Objects that live as long as the window, from initGL() to shutdownGL().
+Arena g_levelArena( MEMORY_CATEGORY_LEVEL, LevelArenaBlockSize );
+
+SimulationThread* g_simulation = NULL;
+SnowRenderer g_snowRenderer;
 
 static void printGLString( const char *name, GLenum s )
 {
@@ -120,98 +108,6 @@ static void printGLString( const char *name, GLenum s )
 	LOGI( "GL %s = %s\n", name, v );
 }
 
-static double getCurrentTimeInSeconds()
-{
-   timespec lTimeVal;
-   clock_gettime( CLOCK_MONOTONIC, &lTimeVal );
-   return lTimeVal.tv_sec + (lTimeVal.tv_nsec * 1.0e-9);
-}
-
-GLuint loadShader( GLenum shaderType, const char* pSource )
-{
-	GLuint shader = glCreateShader( shaderType );
-
-	if( shader )
-	{
-		glShaderSource( shader, 1, &pSource, NULL );
-		glCompileShader( shader );
-
-		GLint compiled = 0;
-		glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
-
-		if( !compiled )
-		{
-			GLint infoLen = 0;
-			glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &infoLen );
-
-			if( infoLen )
-			{
-				char* buf = (char*) malloc( infoLen );
-
-				if( buf )
-				{
-					glGetShaderInfoLog( shader, infoLen, NULL, buf );
-					LOGE( "Could not compile shader %d:\n%s\n", shaderType, buf );
-					free( buf );
-				}
-
-				glDeleteShader( shader );
-				shader = 0;
-			}
-		}
-	}
-
-	return shader;
-}
-
-GLuint createProgram( const char* pVertexSource, const char* pFragmentSource )
-{
-	GLuint vertexShader = loadShader( GL_VERTEX_SHADER, pVertexSource );
-
-	if( !vertexShader )
-		return 0;
-
-	GLuint pixelShader = loadShader( GL_FRAGMENT_SHADER, pFragmentSource );
-
-	if( !pixelShader )
-		return 0;
-
-	GLuint program = glCreateProgram();
-
-	if( program )
-	{
-		glAttachShader( program, vertexShader );
-		glAttachShader( program, pixelShader );
-
-		glLinkProgram( program );
-		GLint linkStatus = GL_FALSE;
-		glGetProgramiv( program, GL_LINK_STATUS, &linkStatus );
-
-		if( linkStatus != GL_TRUE )
-		{
-			GLint bufLength = 0;
-			glGetProgramiv( program, GL_INFO_LOG_LENGTH, &bufLength );
-
-			if( bufLength )
-			{
-				char* buf = (char*) malloc( bufLength );
-
-				if( buf )
-				{
-					glGetProgramInfoLog( program, bufLength, NULL, buf );
-					LOGE( "Could not link program:\n%s\n", buf );
-					free( buf );
-				}
-			}
-
-			glDeleteProgram( program );
-			program = 0;
-		}
-	}
-
-	return program;
-}
-
 static int initGL( struct engine* engine )
 {
 	// initialize OpenGL ES and EGL
@@ -280,8 +176,14 @@ static int initGL( struct engine* engine )
 	eglQuerySurface( display, surface, EGL_WIDTH, &w );
 	eglQuerySurface( display, surface, EGL_HEIGHT, &h );
 
-	g_texture = new Texture( engine->app, "snow.png" );
-	g_texture->load();
+	// The snow texture shows up as a plain white texel until the loader
+	// has decoded and uploaded it.
+	g_texture = g_levelArena.create<Texture>( engine->app, "snow.png" );
+
+	if( g_texture == NULL )
+		return -1;
+
+	g_assetLoader->enqueue( g_texture );
 
 	engine->display = display;
 	engine->context = context;
@@ -290,127 +192,56 @@ static int initGL( struct engine* engine )
 	engine->height = h;
 	engine->state.angle = 0;
 
-	// Initialize GL state.
-	glHint( GL_PERSPECTIVE_CORRECTION_HINT, GL_FASTEST );
-	glDisable( GL_DEPTH_TEST );
-
 	printGLString( "Version", GL_VERSION );
 	printGLString( "Vendor", GL_VENDOR );
 	printGLString( "Renderer", GL_RENDERER );
 	printGLString( "Extensions", GL_EXTENSIONS );
 
-	g_program = createProgram( g_vertexShader, g_fragmentShader );
-
-	if( !g_program )
-	{
-		LOGE( "Could not create program." );
+	if( g_snowRenderer.initialize( g_shaderVariants, g_texture, w, h ) != STATUS_OK )
 		return false;
-	}
-
-	// Vertex shader variables
-	g_a_positionHandle = glGetAttribLocation( g_program, "a_position" );
-	g_a_colorHandle = glGetAttribLocation( g_program, "a_color" );
-	g_a_pointSizeHandle = glGetAttribLocation( g_program, "a_pointSize" );
-	g_u_mvpMatrixHandle = glGetUniformLocation ( g_program, "u_mvpMatrix" );
-
-	// Fragment shader variables
-	g_u_texture0Handle = glGetUniformLocation( g_program, "u_texture0" );
-
-	glViewport( 0, 0, w, h );
-
-	g_orthographicMatrix = Matrix4x4f::createOrthographicProjection( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY, -1.0f, 1.0f );
 
-	g_nowTime = getCurrentTimeInSeconds();
-	g_prevTime = g_nowTime;
+	// The flakes are stepped on their own thread from here on, see
+	// SimulationThread. Every run looks different, a recording can
+	// reproduce one.
+	g_simulation->start( (uint32_t) time( NULL ) );
+	g_simulation->resetStats();
+	g_statsTime = getCurrentTimeInSeconds();
 
-    //
-    // General Setup...
-    //
-
-    glEnable( GL_TEXTURE_2D );
-    glDisable( GL_LIGHTING );
-
-    //
-    // Point Sprites...
-    //
-
-    glEnable( GL_POINT_SPRITE_OES );
-    //glTexEnvi( GL_POINT_SPRITE_OES, GL_COORD_REPLACE_OES, GL_TRUE );
-    //glTexEnvi( GL_POINT_SPRITE_OES, GL_COORD_REPLACE_OES, GL_FALSE );
-    //glPointSize( 10.0f );
-
-    // This helps as a work around for order-dependency artifacts that can occur when sprites overlap.
-    glBlendFunc( GL_SRC_ALPHA, GL_ONE );
-
-    //
-    // Snow Flakes...
-    //
-
-    for( int i = 0; i < MaxSnowFlakes; ++i )
-    {
-		g_pos[i][0] = RandomFloat( -ViewMaxX, ViewMaxX );
-        g_pos[i][1] = RandomFloat( -ViewMaxY, ViewMaxY );
+	return 0;
+}
 
-		g_vel[i][0] = RandomFloat( -0.004f, 0.004f ); // Flakes move side to side
-		g_vel[i][1] = RandomFloat( -0.01f, -0.008f ); // Flakes fall down
+static void logHandoffStats()
+{
+	double lNow = getCurrentTimeInSeconds();
 
-		g_col[i][0] = 1.0f;
-		g_col[i][1] = 1.0f;
-		g_col[i][2] = 1.0f;
-		g_col[i][3] = 1.0f; //RandomFloat( 0.6f, 1.0f ); // It seems that Doodle Jump snow does not use alpha.
+	if( lNow - g_statsTime < HandoffStatsInterval )
+		return;
 
-        g_size[i] = RandomFloat( 3.0, 6.0f );
+	HandoffStats lStats;
+	g_simulation->getStats( &lStats );
 
-        // It looks strange if the flakes all turn at the same time, so
-        // lets vary their turn times with a random negative value.
-        g_timeSinceLastTurn[i] = RandomFloat( -5.0, 0.0f );
+	if( lStats.m_presented > 0 )
+	{
+		LOGI( "Snapshots: %u published, %u dropped; frames: %u presented, %u duplicated; age %.2f ms average, %.2f ms max",
+				lStats.m_published, lStats.m_dropped, lStats.m_presented, lStats.m_duplicated,
+				lStats.m_ageTotal * 1000.0 / lStats.m_presented, lStats.m_ageMax * 1000.0 );
 	}
 
-	return 0;
-}
+	g_simulation->resetStats();
 
-static void update( struct engine* engine )
-{
-	if( engine->display == NULL )
-	{
-		// No display.
-		return;
-	}
+	// Whether frames are bound by the GPU filling sprites or by the CPU.
+	GpuTimerStats lGpuStats;
+	g_snowRenderer.getGpuTimer().getStats( &lGpuStats );
 
-	g_nowTime = getCurrentTimeInSeconds();
-	double elapsed = g_nowTime - g_prevTime;
-
-	for( int i = 0; i < MaxSnowFlakes; ++i )
-    {
-        // Keep track of how long it has been since this flake turned
-        // or changed direction.
-        g_timeSinceLastTurn[i] += elapsed;
-
-        if( g_timeSinceLastTurn[i] >= TimeTillTurn )
-        {
-            // Change or invert direction!
-            g_vel[i][0] = -(g_vel[i][0]);
-            g_timeSinceLastTurn[i] = RandomFloat( -5.0, 0.0f );
-        }
-
-        // Speed up the flake up as it leaves the last turn and prepares for next turn.
-        float turnVelocityModifier = g_timeSinceLastTurn[i] * TimeTillTurnNormalizedUnit;
-
-        // Apply some velocity to simulate gravity and wind.
-		g_pos[i][0] += (g_vel[i][0] * turnVelocityModifier); // Side to side
-		g_pos[i][1] += g_vel[i][1]; // Gravity
-
-        // But, if the snow flake goes off the bottom or strays too far
-        // left or right - respawn it back to the top.
-        if( g_pos[i][1] < -(ViewMaxY + 0.2f) ||
-            g_pos[i][0] < -(ViewMaxX + 0.2f) || g_pos[i][0] > (ViewMaxX + 0.2f) )
-        {
-            g_pos[i][0] = RandomFloat( -ViewMaxX, ViewMaxX );
-            g_pos[i][1] = 3.1;
-        }
+	if( lGpuStats.m_samples > 0 )
+	{
+		LOGI( "GPU snow pass: %.2f ms average, %.2f ms max over %u frames, %u discarded",
+				lGpuStats.m_timeTotal * 1000.0 / lGpuStats.m_samples, lGpuStats.m_timeMax * 1000.0,
+				lGpuStats.m_samples, lGpuStats.m_discarded );
 	}
 
-	g_prevTime = g_nowTime;
+	g_snowRenderer.getGpuTimer().resetStats();
+	g_statsTime = lNow;
 }
 
 static void draw( struct engine* engine )
@@ -421,44 +252,55 @@ static void draw( struct engine* engine )
 		return;
 	}
 
-    // Doodle jump sky color (or something like it).
-    glClearColor( 0.31f, 0.43f, 0.63f, 1.0f );
-	glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
-
-    // We don't care about depth for point sprites.
-    glDepthMask( GL_FALSE ); // Turn off depth writes
-
-    glEnable( GL_BLEND );
-    glEnable( GL_POINT_SPRITE_OES );
-    //glTexEnvi( GL_POINT_SPRITE_OES, GL_COORD_REPLACE_OES, GL_TRUE );
-
-	glUseProgram( g_program );
-
-	glUniformMatrix4fv( g_u_mvpMatrixHandle, 1, GL_FALSE, g_orthographicMatrix.m );
-
-	glVertexAttribPointer( g_a_positionHandle, 2, GL_FLOAT, GL_FALSE, 0, g_pos );
-	glEnableVertexAttribArray( g_a_positionHandle );
-
-	glVertexAttribPointer( g_a_colorHandle, 4, GL_FLOAT, GL_FALSE, 0, g_col );
-	glEnableVertexAttribArray( g_a_colorHandle );
+	{
+		GUILDHALL_PROFILE_ZONE( "Upload assets" );
+		g_assetLoader->update( TextureUploadBudget );
+	}
 
-	glVertexAttribPointer( g_a_pointSizeHandle, 1, GL_FLOAT, GL_FALSE, 0, g_size );
-	glEnableVertexAttribArray( g_a_pointSizeHandle );
+	// Always the newest complete snapshot, however far the simulation
+	// has got in the meantime.
+	g_snowRenderer.draw( g_simulation->acquire() );
 
-	glUniform1i( g_u_texture0Handle, 0 );
-	g_texture->apply();
+	g_simulation->present();
 
-	glDrawArrays( GL_POINTS, 0, MaxSnowFlakes );
+#ifdef GUILDHALL_RECORD
+	// A replay is a check of the simulation, so a diverged one fails the
+	// run rather than carrying on with other flakes.
+	if( g_simulation->hasReplayDiverged() )
+	{
+		engine->animating = 0;
+		ANativeActivity_finish( engine->app->activity );
+	}
+#endif
 
-    glDepthMask( GL_TRUE ); // Turn back on depth writes
+	{
+		GUILDHALL_PROFILE_ZONE( "eglSwapBuffers" );
+		eglSwapBuffers( engine->display, engine->surface );
+	}
 
-	eglSwapBuffers( engine->display, engine->surface );
+	logHandoffStats();
+	GUILDHALL_PROFILE_FRAME();
 }
 
 static void shutdownGL( struct engine* engine )
 {
+	// Nothing may be uploaded once the context is gone.
+	g_assetLoader->cancel();
+
+	// There is nothing to show the flakes on until the window is back.
+	g_simulation->stop();
+
 	if( engine->display != EGL_NO_DISPLAY )
 	{
+		if( engine->context != EGL_NO_CONTEXT )
+			g_shaderVariants->release();
+
+		g_programCache->release();
+		g_snowRenderer.release();
+
+		if( engine->context != EGL_NO_CONTEXT && g_texture != NULL )
+			g_texture->unload();
+
 		eglMakeCurrent( engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
 
 		if( engine->context != EGL_NO_CONTEXT )
@@ -470,6 +312,17 @@ static void shutdownGL( struct engine* engine )
 		eglTerminate( engine->display );
 	}
 
+	// Nothing uses the window's objects any more. Called again when the
+	// app is destroyed, which then finds nothing to do.
+	if( g_texture != NULL )
+	{
+		g_levelArena.destroy( g_texture );
+		g_texture = NULL;
+		logMemoryStats();
+	}
+
+	g_levelArena.reset();
+
 	engine->animating = 0;
 	engine->display = EGL_NO_DISPLAY;
 	engine->context = EGL_NO_CONTEXT;
@@ -483,10 +336,30 @@ static int32_t handleInputEvent( struct android_app* app, AInputEvent* event )
 
 	if( AInputEvent_getType( event ) == AINPUT_EVENT_TYPE_MOTION )
 	{
+#ifdef GUILDHALL_PROFILER
+		if( AMotionEvent_getPointerCount( event ) >= 3 )
+			Profiler::requestCapture();
+#endif
+
 		engine->animating = 1;
 		engine->state.x = AMotionEvent_getX( event, 0 );
 		engine->state.y = AMotionEvent_getY( event, 0 );
 
+		int32_t lAction = AMotionEvent_getAction( event ) & AMOTION_EVENT_ACTION_MASK;
+		SimulationEvent lEvent;
+
+		if( lAction == AMOTION_EVENT_ACTION_DOWN )
+			lEvent.m_type = SimulationEvent::EVENT_TOUCH_DOWN;
+		else if( lAction == AMOTION_EVENT_ACTION_UP || lAction == AMOTION_EVENT_ACTION_CANCEL )
+			lEvent.m_type = SimulationEvent::EVENT_TOUCH_UP;
+		else
+			lEvent.m_type = SimulationEvent::EVENT_TOUCH_MOVE;
+
+		lEvent.m_values[0] = AMotionEvent_getX( event, 0 );
+		lEvent.m_values[1] = AMotionEvent_getY( event, 0 );
+		lEvent.m_values[2] = 0.0f;
+		g_simulation->postEvent( lEvent );
+
 		return 1;
 	}
 	return 0;
@@ -502,6 +375,7 @@ static void handleAppCmd( struct android_app* app, int32_t cmd )
 		case APP_CMD_SAVE_STATE:
 		{
 			// The system has asked us to save our current state.  Do so.
+			// The glue releases it with free(), so it stays a malloc().
 			engine->app->savedState = malloc( sizeof(struct savedState) );
 			*((struct savedState*) engine->app->savedState) = engine->state;
 			engine->app->savedStateSize = sizeof(struct savedState);
@@ -572,6 +446,31 @@ void android_main( struct android_app* app )
 	app->onAppCmd = handleAppCmd;
 	app->onInputEvent = handleInputEvent;
 
+	g_assetLoader = new AssetLoader( TextureLoaderThreads );
+	g_assetLoader->start();
+
+	// Linked programs are kept in the app's internal storage, so resuming
+	// does not have to compile the shaders again.
+	g_programCache = new ProgramCache( app->activity->internalDataPath );
+	g_shaderVariants = new ShaderVariants( g_programCache );
+
+	g_simulation = new SimulationThread( MaxSnowFlakes );
+
+#ifdef GUILDHALL_RECORD
+	std::string lDataPath( app->activity->internalDataPath );
+
+	if( access( (lDataPath + SimulationReplayFile).c_str(), R_OK ) == 0 )
+		g_simulation->setReplayPath( (lDataPath + SimulationReplayFile).c_str() );
+
+	g_simulation->setRecordPath( (lDataPath + SimulationRecordFile).c_str() );
+#endif
+
+#ifdef GUILDHALL_PROFILER
+	GUILDHALL_PROFILE_THREAD( "Main" );
+	Profiler::setCapturePath( (std::string( app->activity->internalDataPath ) + ProfilerTraceFile).c_str() );
+	Profiler::setFrameTimeTrigger( ProfilerFrameTimeTrigger );
+#endif
+
 	// Prepare to monitor accelerometer
 	engine.sensorManager = ASensorManager_getInstance();
 	engine.accelerometerSensor = ASensorManager_getDefaultSensor( engine.sensorManager, ASENSOR_TYPE_ACCELEROMETER );
@@ -592,34 +491,52 @@ void android_main( struct android_app* app )
 		int events;
 		struct android_poll_source* source;
 
-		// If not animating, we will block forever waiting for events.
-		// If animating, we loop until all events are read, then continue
-		// to draw the next frame of animation.
-		while( (ident = ALooper_pollAll( engine.animating ? 0 : -1, NULL, &events, (void**)&source ) ) >= 0 )
 		{
-			// Process this event.
-			if( source != NULL )
-				source->process( app, source );
+			GUILDHALL_PROFILE_ZONE( "Poll events" );
 
-			// If a sensor has data, process it now.
-			if( ident == LOOPER_ID_USER )
+			// If not animating, we will block forever waiting for events.
+			// If animating, we loop until all events are read, then continue
+			// to draw the next frame of animation.
+			while( (ident = ALooper_pollAll( engine.animating ? 0 : -1, NULL, &events, (void**)&source ) ) >= 0 )
 			{
-				if( engine.accelerometerSensor != NULL )
-				{
-					ASensorEvent event;
+				// Process this event.
+				if( source != NULL )
+					source->process( app, source );
 
-					while( ASensorEventQueue_getEvents( engine.sensorEventQueue, &event, 1 ) > 0 )
+				// If a sensor has data, process it now.
+				if( ident == LOOPER_ID_USER )
+				{
+					if( engine.accelerometerSensor != NULL )
 					{
-						//LOGI( "accelerometer: x=%f y=%f z=%f", event.acceleration.x, event.acceleration.y, event.acceleration.z );
+						ASensorEvent event;
+
+						while( ASensorEventQueue_getEvents( engine.sensorEventQueue, &event, 1 ) > 0 )
+						{
+							//LOGI( "accelerometer: x=%f y=%f z=%f", event.acceleration.x, event.acceleration.y, event.acceleration.z );
+							SimulationEvent lEvent;
+							lEvent.m_type = SimulationEvent::EVENT_ACCELEROMETER;
+							lEvent.m_values[0] = event.acceleration.x;
+							lEvent.m_values[1] = event.acceleration.y;
+							lEvent.m_values[2] = event.acceleration.z;
+							g_simulation->postEvent( lEvent );
+						}
 					}
 				}
-			}
 
-			// Check if we are exiting.
-			if( app->destroyRequested != 0 )
-			{
-				shutdownGL( &engine );
-				return;
+				// Check if we are exiting.
+				if( app->destroyRequested != 0 )
+				{
+					shutdownGL( &engine );
+					delete g_assetLoader;
+					g_assetLoader = NULL;
+					delete g_simulation;
+					g_simulation = NULL;
+					delete g_shaderVariants;
+					g_shaderVariants = NULL;
+					delete g_programCache;
+					g_programCache = NULL;
+					return;
+				}
 			}
 		}
 
@@ -631,10 +548,9 @@ void android_main( struct android_app* app )
 			if( engine.state.angle > 1 )
 				engine.state.angle = 0;
 
-			update( &engine );
-
 			// Drawing is throttled to the screen update rate, so there
-			// is no need to do timing here.
+			// is no need to do timing here. The simulation runs on its
+			// own thread.
 			draw( &engine );
 		}
 	}
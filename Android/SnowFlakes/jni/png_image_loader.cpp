@@ -0,0 +1,28 @@
+#include "png_image_loader.h"
+#include "texture.h"
+
+namespace guildhall {
+
+PngImageLoader::PngImageLoader( android_app* pApplication ) :
+		m_application( pApplication )
+{
+}
+
+status PngImageLoader::load( const char* pPath, Image* pImage )
+{
+	// decode() never touches OpenGL, so this is safe on any thread.
+	Texture lTexture( m_application, pPath );
+
+	if( lTexture.decode() != STATUS_OK )
+		return STATUS_ERROR;
+
+	pImage->m_width = lTexture.getWidth();
+	pImage->m_height = lTexture.getHeight();
+	pImage->m_texels.resize( pImage->m_width * pImage->m_height );
+	lTexture.expandToRgba( &pImage->m_texels[0] );
+
+	lTexture.unload();
+	return STATUS_OK;
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef _GUILDHALL_PNG_IMAGE_LOADER_H_
+#define _GUILDHALL_PNG_IMAGE_LOADER_H_
+
+#include "image.h"
+#include "resource.h"
+#include "types.h"
+
+namespace guildhall {
+
+// Decodes PNG assets with libpng, the same way Texture does, for the parts
+// of the engine which draw without OpenGL.
+class PngImageLoader : public ImageLoader
+{
+public:
+
+	PngImageLoader( android_app* pApplication );
+
+	virtual status load( const char* pPath, Image* pImage );
+
+private:
+
+	android_app* m_application;
+};
+
+}
+#endif // _GUILDHALL_PNG_IMAGE_LOADER_H_
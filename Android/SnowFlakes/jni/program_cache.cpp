@@ -0,0 +1,298 @@
+#include "program_cache.h"
+#include "log.h"
+#include "shader.h"
+#include "timer.h"
+
+#include <EGL/egl.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace guildhall {
+
+namespace {
+
+// Cache file layout: header followed by the driver's binary blob.
+struct BinaryHeader
+{
+	uint32_t m_magic;
+	uint32_t m_format;
+	uint32_t m_length;
+};
+
+const uint32_t BinaryMagic = 0x42504653; // "SFPB"
+
+uint64_t hashString( uint64_t pHash, const char* pString )
+{
+	// 64 bit FNV-1a, the terminator is hashed too so that concatenated
+	// strings cannot collide with each other.
+	if( pString == NULL )
+		pString = "";
+
+	do
+	{
+		pHash ^= (uint8_t) *pString;
+		pHash *= 0x100000001b3ULL;
+	}
+	while( *pString++ != '\0' );
+
+	return pHash;
+}
+
+}
+
+ProgramCache::ProgramCache( const char* pDirectory ) :
+		m_directory( pDirectory != NULL ? pDirectory : "" ),
+		m_supportChecked( false ),
+		m_supported( false ),
+		m_getProgramBinary( NULL ),
+		m_programBinary( NULL ),
+		m_programParameteri( NULL )
+{
+}
+
+void ProgramCache::release()
+{
+	m_supportChecked = false;
+	m_supported = false;
+	m_getProgramBinary = NULL;
+	m_programBinary = NULL;
+	m_programParameteri = NULL;
+}
+
+GLuint ProgramCache::createProgram( const char* pVertexSource, const char* pFragmentSource )
+{
+	double lStart = getCurrentTimeInSeconds();
+
+	if( !isSupported() )
+		return guildhall::createProgram( pVertexSource, pFragmentSource );
+
+	std::string lFileName = getFileName( computeKey( pVertexSource, pFragmentSource ) );
+	GLuint lProgram = loadBinary( lFileName );
+
+	if( lProgram != 0 )
+	{
+		Log::info( "Program cache hit in %.2f ms", (getCurrentTimeInSeconds() - lStart) * 1000.0 );
+		return lProgram;
+	}
+
+	lProgram = compileProgram( pVertexSource, pFragmentSource );
+
+	if( lProgram == 0 )
+		return 0;
+
+	Log::info( "Program cache miss, compiled in %.2f ms", (getCurrentTimeInSeconds() - lStart) * 1000.0 );
+
+	saveBinary( lFileName, lProgram );
+	return lProgram;
+}
+
+bool ProgramCache::isSupported()
+{
+	if( m_supportChecked )
+		return m_supported;
+
+	m_supportChecked = true;
+
+	if( m_directory.empty() )
+		return false;
+
+	// OpenGL ES 3.0 has program binaries in core, with the same entry
+	// point signatures and enums as the OES extension.
+	const char* lVersion = (const char*) glGetString( GL_VERSION );
+	const char* lExtensions = (const char*) glGetString( GL_EXTENSIONS );
+
+	if( lVersion != NULL && strncmp( lVersion, "OpenGL ES 3", 11 ) == 0 )
+	{
+		m_getProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC) eglGetProcAddress( "glGetProgramBinary" );
+		m_programBinary = (PFNGLPROGRAMBINARYOESPROC) eglGetProcAddress( "glProgramBinary" );
+		m_programParameteri = (PFNGLPROGRAMPARAMETERIPROC) eglGetProcAddress( "glProgramParameteri" );
+	}
+	else if( lExtensions != NULL && strstr( lExtensions, "GL_OES_get_program_binary" ) != NULL )
+	{
+		m_getProgramBinary = (PFNGLGETPROGRAMBINARYOESPROC) eglGetProcAddress( "glGetProgramBinaryOES" );
+		m_programBinary = (PFNGLPROGRAMBINARYOESPROC) eglGetProcAddress( "glProgramBinaryOES" );
+	}
+	else
+	{
+		// The format count query would leave GL_INVALID_ENUM behind for
+		// the next glGetError() to find.
+		Log::info( "Program binaries are not supported, shaders will be compiled." );
+		return false;
+	}
+
+	// A driver may expose the entry points without any binary format.
+	GLint lFormatCount = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS_OES, &lFormatCount );
+
+	if( lFormatCount <= 0 || m_getProgramBinary == NULL || m_programBinary == NULL )
+	{
+		Log::info( "Program binaries are not supported, shaders will be compiled." );
+		return false;
+	}
+
+	m_supported = true;
+	return m_supported;
+}
+
+GLuint ProgramCache::compileProgram( const char* pVertexSource, const char* pFragmentSource )
+{
+	GLuint lVertexShader = loadShader( GL_VERTEX_SHADER, pVertexSource );
+
+	if( !lVertexShader )
+		return 0;
+
+	GLuint lPixelShader = loadShader( GL_FRAGMENT_SHADER, pFragmentSource );
+
+	if( !lPixelShader )
+	{
+		glDeleteShader( lVertexShader );
+		return 0;
+	}
+
+	GLuint lProgram = glCreateProgram();
+
+	if( lProgram )
+	{
+		glAttachShader( lProgram, lVertexShader );
+		glAttachShader( lProgram, lPixelShader );
+
+		// Some OpenGL ES 3.0 drivers only keep a binary to give back
+		// when asked before linking.
+		if( m_programParameteri != NULL )
+			m_programParameteri( lProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+
+		glLinkProgram( lProgram );
+
+		if( !checkProgramLinked( lProgram ) )
+		{
+			glDeleteProgram( lProgram );
+			lProgram = 0;
+		}
+	}
+
+	glDeleteShader( lVertexShader );
+	glDeleteShader( lPixelShader );
+
+	return lProgram;
+}
+
+uint64_t ProgramCache::computeKey( const char* pVertexSource, const char* pFragmentSource )
+{
+	uint64_t lHash = 0xcbf29ce484222325ULL;
+
+	lHash = hashString( lHash, pVertexSource );
+	lHash = hashString( lHash, pFragmentSource );
+
+	// Driver updates invalidate binaries, so they are part of the key.
+	lHash = hashString( lHash, (const char*) glGetString( GL_RENDERER ) );
+	lHash = hashString( lHash, (const char*) glGetString( GL_VERSION ) );
+
+	return lHash;
+}
+
+std::string ProgramCache::getFileName( uint64_t pKey )
+{
+	char lName[32];
+	snprintf( lName, sizeof(lName), "/program_%016llx.bin", (unsigned long long) pKey );
+	return m_directory + lName;
+}
+
+GLuint ProgramCache::loadBinary( const std::string& pFileName )
+{
+	FILE* lFile = fopen( pFileName.c_str(), "rb" );
+
+	if( lFile == NULL )
+		return 0;
+
+	BinaryHeader lHeader;
+	std::vector<uint8_t> lBinary;
+
+	if( fread( &lHeader, sizeof(lHeader), 1, lFile ) == 1 && lHeader.m_magic == BinaryMagic && lHeader.m_length > 0 )
+	{
+		lBinary.resize( lHeader.m_length );
+
+		if( fread( &lBinary[0], lHeader.m_length, 1, lFile ) != 1 )
+			lBinary.clear();
+	}
+
+	fclose( lFile );
+
+	GLuint lProgram = 0;
+
+	if( !lBinary.empty() )
+	{
+		lProgram = glCreateProgram();
+		m_programBinary( lProgram, lHeader.m_format, &lBinary[0], lHeader.m_length );
+
+		GLint lLinkStatus = GL_FALSE;
+		glGetProgramiv( lProgram, GL_LINK_STATUS, &lLinkStatus );
+
+		if( lLinkStatus != GL_TRUE )
+		{
+			glDeleteProgram( lProgram );
+			lProgram = 0;
+		}
+	}
+
+	// Truncated, foreign or rejected binaries are dropped and rebuilt.
+	if( lProgram == 0 )
+	{
+		Log::warn( "Discarding cached program %s", pFileName.c_str() );
+		remove( pFileName.c_str() );
+	}
+
+	return lProgram;
+}
+
+status ProgramCache::saveBinary( const std::string& pFileName, GLuint pProgram )
+{
+	GLint lLength = 0;
+	glGetProgramiv( pProgram, GL_PROGRAM_BINARY_LENGTH_OES, &lLength );
+
+	if( lLength <= 0 )
+		return STATUS_ERROR;
+
+	std::vector<uint8_t> lBinary( lLength );
+	GLenum lFormat = 0;
+
+	// Clears errors left by earlier calls, so that only this one counts.
+	while( glGetError() != GL_NO_ERROR )
+	{
+	}
+
+	m_getProgramBinary( pProgram, lLength, &lLength, &lFormat, &lBinary[0] );
+
+	if( glGetError() != GL_NO_ERROR || lLength <= 0 )
+		return STATUS_ERROR;
+
+	BinaryHeader lHeader;
+	lHeader.m_magic = BinaryMagic;
+	lHeader.m_format = lFormat;
+	lHeader.m_length = lLength;
+
+	// Writes to a temporary file first so that a crash can never leave a
+	// half written binary behind under the real name.
+	std::string lTempName = pFileName + ".tmp";
+	FILE* lFile = fopen( lTempName.c_str(), "wb" );
+
+	if( lFile == NULL )
+	{
+		Log::warn( "Unable to write %s", lTempName.c_str() );
+		return STATUS_ERROR;
+	}
+
+	bool lWritten = fwrite( &lHeader, sizeof(lHeader), 1, lFile ) == 1 &&
+			fwrite( &lBinary[0], lLength, 1, lFile ) == 1;
+	lWritten = (fclose( lFile ) == 0) && lWritten;
+
+	if( !lWritten || rename( lTempName.c_str(), pFileName.c_str() ) != 0 )
+	{
+		remove( lTempName.c_str() );
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+}
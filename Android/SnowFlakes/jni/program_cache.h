@@ -0,0 +1,61 @@
+#ifndef _GUILDHALL_PROGRAM_CACHE_H_
+#define _GUILDHALL_PROGRAM_CACHE_H_
+
+#include "types.h"
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <string>
+
+// OpenGL ES 3.0's, which the ES 2.0 headers lack.
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+typedef void (GL_APIENTRYP PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+#endif
+
+namespace guildhall {
+
+// Keeps linked program binaries on disk (OpenGL ES 3.0 or
+// GL_OES_get_program_binary), keyed
+// by the shader sources and the driver's GL_RENDERER/GL_VERSION strings.
+// Binaries the driver rejects are recompiled from source and replaced.
+class ProgramCache
+{
+public:
+
+	// pDirectory may be NULL, in which case every program is compiled.
+	ProgramCache( const char* pDirectory );
+
+	// Must be called with a current context.
+	GLuint createProgram( const char* pVertexSource, const char* pFragmentSource );
+
+	// Forgets what it learned about the context, so that the next one is
+	// checked afresh; call when the context is destroyed.
+	void release();
+
+private:
+
+	bool isSupported();
+	uint64_t computeKey( const char* pVertexSource, const char* pFragmentSource );
+	std::string getFileName( uint64_t pKey );
+
+	GLuint compileProgram( const char* pVertexSource, const char* pFragmentSource );
+	GLuint loadBinary( const std::string& pFileName );
+	status saveBinary( const std::string& pFileName, GLuint pProgram );
+
+private:
+
+	std::string m_directory;
+
+	// Resolved on first use after construction or release().
+	bool m_supportChecked;
+	bool m_supported;
+	PFNGLGETPROGRAMBINARYOESPROC m_getProgramBinary;
+	PFNGLPROGRAMBINARYOESPROC m_programBinary;
+
+	// OpenGL ES 3.0 only, NULL otherwise.
+	PFNGLPROGRAMPARAMETERIPROC m_programParameteri;
+};
+
+}
+#endif // _GUILDHALL_PROGRAM_CACHE_H_
@@ -1,8 +1,17 @@
 #include "resource.h"
 #include "log.h"
 
+#ifndef __ANDROID__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace guildhall {
 
+#ifdef __ANDROID__
+
 Resource::Resource( android_app* pApplication, const char* pPath ) :
 		m_path( pPath ),
 		m_assetManager( pApplication->activity->assetManager ),
@@ -28,9 +37,111 @@ void Resource::close()
 status Resource::read( void* pBuffer, size_t pCount )
 {
 	int32_t lReadCount = AAsset_read( m_asset, pBuffer, pCount );
-	return (lReadCount == pCount) ? STATUS_OK : STATUS_ERROR;
+	return (lReadCount == (int32_t) pCount) ? STATUS_OK : STATUS_ERROR;
+}
+
+const void* Resource::bufferize()
+{
+	// Uncompressed assets (which includes PNGs, since aapt stores them
+	// as-is) are memory mapped straight out of the APK.
+	return (m_asset != NULL) ? AAsset_getBuffer( m_asset ) : NULL;
+}
+
+size_t Resource::getLength()
+{
+	return (m_asset != NULL) ? (size_t) AAsset_getLength( m_asset ) : 0;
 }
 
+#else
+
+Resource::Resource( android_app*, const char* pPath ) :
+		m_path( pPath ),
+		m_descriptor( -1 ),
+		m_mapping( NULL ),
+		m_mappingLength( 0 )
+{
+}
+
+status Resource::open()
+{
+	m_descriptor = ::open( m_path, O_RDONLY );
+	return (m_descriptor >= 0) ? STATUS_OK : STATUS_ERROR;
+}
+
+void Resource::close()
+{
+	if( m_mapping != NULL )
+	{
+		munmap( m_mapping, m_mappingLength );
+		m_mapping = NULL;
+		m_mappingLength = 0;
+	}
+
+	if( m_descriptor >= 0 )
+	{
+		::close( m_descriptor );
+		m_descriptor = -1;
+	}
+}
+
+status Resource::read( void* pBuffer, size_t pCount )
+{
+	uint8_t* lBuffer = (uint8_t*) pBuffer;
+
+	// Unlike assets, file reads may legitimately return less than
+	// requested, so keep reading until the request is satisfied.
+	while( pCount > 0 )
+	{
+		ssize_t lReadCount = ::read( m_descriptor, lBuffer, pCount );
+
+		if( lReadCount <= 0 )
+			return STATUS_ERROR;
+
+		lBuffer += lReadCount;
+		pCount -= lReadCount;
+	}
+
+	return STATUS_OK;
+}
+
+const void* Resource::bufferize()
+{
+	if( m_mapping != NULL )
+		return m_mapping;
+
+	struct stat lStat;
+
+	if( m_descriptor < 0 || fstat( m_descriptor, &lStat ) != 0 || lStat.st_size <= 0 )
+		return NULL;
+
+	void* lMapping = mmap( NULL, lStat.st_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0 );
+
+	if( lMapping == MAP_FAILED )
+	{
+		Log::warn( "Unable to map %s", m_path );
+		return NULL;
+	}
+
+	m_mapping = lMapping;
+	m_mappingLength = lStat.st_size;
+	return m_mapping;
+}
+
+size_t Resource::getLength()
+{
+	if( m_mapping != NULL )
+		return m_mappingLength;
+
+	struct stat lStat;
+
+	if( m_descriptor < 0 || fstat( m_descriptor, &lStat ) != 0 )
+		return 0;
+
+	return lStat.st_size;
+}
+
+#endif
+
 const char* Resource::getPath()
 {
 	return m_path;
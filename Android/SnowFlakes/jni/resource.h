@@ -3,7 +3,15 @@
 
 #include "types.h"
 
+#include <stddef.h>
+
+#ifdef __ANDROID__
 #include <android_native_app_glue.h>
+#else
+// Off-device builds (host tools and benchmarks) read resources straight
+// from the file system, so the application pointer is only a placeholder.
+struct android_app;
+#endif
 
 namespace guildhall {
 
@@ -17,13 +25,26 @@ public:
 	void close();
 	status read( void* pBuffer, size_t pCount );
 
+	// Returns the whole resource as one contiguous, read-only block of
+	// memory or NULL if the resource cannot be mapped. The buffer stays
+	// valid until close() is called.
+	const void* bufferize();
+	size_t getLength();
+
 	const char* getPath();
 
 private:
 
 	const char* m_path;
+
+#ifdef __ANDROID__
 	AAssetManager* m_assetManager;
 	AAsset* m_asset;
+#else
+	int m_descriptor;
+	void* m_mapping;
+	size_t m_mappingLength;
+#endif
 };
 
 }
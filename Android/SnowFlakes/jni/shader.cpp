@@ -0,0 +1,108 @@
+#include "shader.h"
+#include "log.h"
+#include "memory_tracker.h"
+
+namespace guildhall {
+
+GLuint loadShader( GLenum pShaderType, const char* pSource )
+{
+	GLuint lShader = glCreateShader( pShaderType );
+
+	if( lShader )
+	{
+		glShaderSource( lShader, 1, &pSource, NULL );
+		glCompileShader( lShader );
+
+		GLint lCompiled = 0;
+		glGetShaderiv( lShader, GL_COMPILE_STATUS, &lCompiled );
+
+		if( !lCompiled )
+		{
+			GLint lInfoLen = 0;
+			glGetShaderiv( lShader, GL_INFO_LOG_LENGTH, &lInfoLen );
+
+			if( lInfoLen )
+			{
+				char* lBuffer = allocateArray<char>( MEMORY_CATEGORY_SHADERS, lInfoLen );
+
+				if( lBuffer )
+				{
+					glGetShaderInfoLog( lShader, lInfoLen, NULL, lBuffer );
+					Log::error( "Could not compile shader %d:\n%s", pShaderType, lBuffer );
+					freeMemory( lBuffer );
+				}
+			}
+
+			glDeleteShader( lShader );
+			lShader = 0;
+		}
+	}
+
+	return lShader;
+}
+
+bool checkProgramLinked( GLuint pProgram )
+{
+	GLint lLinkStatus = GL_FALSE;
+	glGetProgramiv( pProgram, GL_LINK_STATUS, &lLinkStatus );
+
+	if( lLinkStatus == GL_TRUE )
+		return true;
+
+	GLint lBufLength = 0;
+	glGetProgramiv( pProgram, GL_INFO_LOG_LENGTH, &lBufLength );
+
+	if( lBufLength )
+	{
+		char* lBuffer = allocateArray<char>( MEMORY_CATEGORY_SHADERS, lBufLength );
+
+		if( lBuffer )
+		{
+			glGetProgramInfoLog( pProgram, lBufLength, NULL, lBuffer );
+			Log::error( "Could not link program:\n%s", lBuffer );
+			freeMemory( lBuffer );
+		}
+	}
+
+	return false;
+}
+
+GLuint createProgram( const char* pVertexSource, const char* pFragmentSource )
+{
+	GLuint lVertexShader = loadShader( GL_VERTEX_SHADER, pVertexSource );
+
+	if( !lVertexShader )
+		return 0;
+
+	GLuint lPixelShader = loadShader( GL_FRAGMENT_SHADER, pFragmentSource );
+
+	if( !lPixelShader )
+	{
+		glDeleteShader( lVertexShader );
+		return 0;
+	}
+
+	GLuint lProgram = glCreateProgram();
+
+	if( lProgram )
+	{
+		glAttachShader( lProgram, lVertexShader );
+		glAttachShader( lProgram, lPixelShader );
+
+		glLinkProgram( lProgram );
+
+		if( !checkProgramLinked( lProgram ) )
+		{
+			glDeleteProgram( lProgram );
+			lProgram = 0;
+		}
+	}
+
+	// The program keeps its own reference to attached shaders.
+	glDeleteShader( lVertexShader );
+	glDeleteShader( lPixelShader );
+
+	return lProgram;
+}
+
+}
@@ -0,0 +1,18 @@
+#ifndef _GUILDHALL_SHADER_H_
+#define _GUILDHALL_SHADER_H_
+
+#include <GLES2/gl2.h>
+
+namespace guildhall {
+
+// Compiles a single shader stage, returns 0 and logs the info log on failure.
+GLuint loadShader( GLenum pShaderType, const char* pSource );
+
+// Compiles and links a program from source, returns 0 on failure.
+GLuint createProgram( const char* pVertexSource, const char* pFragmentSource );
+
+// Returns true if pProgram linked, logging the info log otherwise.
+bool checkProgramLinked( GLuint pProgram );
+
+}
+#endif // _GUILDHALL_SHADER_H_
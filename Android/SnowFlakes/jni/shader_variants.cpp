@@ -0,0 +1,57 @@
+#include "shader_variants.h"
+#include "log.h"
+
+#include <string.h>
+
+namespace guildhall {
+
+ShaderVariants::ShaderVariants( ProgramCache* pProgramCache ) :
+		m_programCache( pProgramCache )
+{
+	memset( m_programs, 0, sizeof(m_programs) );
+}
+
+void ShaderVariants::release()
+{
+	for( uint32_t i = 0; i < ShaderVariantCount; ++i )
+	{
+		if( m_programs[i].m_program != 0 )
+			glDeleteProgram( m_programs[i].m_program );
+	}
+
+	memset( m_programs, 0, sizeof(m_programs) );
+}
+
+const ShaderProgram* ShaderVariants::build( uint32_t pMask, const char* pVertexSource, const char* pFragmentSource )
+{
+	GLuint lProgram = m_programCache->createProgram( pVertexSource, pFragmentSource );
+
+	if( lProgram == 0 )
+	{
+		Log::error( "Could not create shader variant 0x%x.", pMask );
+		return NULL;
+	}
+
+	ShaderProgram& lVariant = m_programs[pMask];
+	lVariant.m_program = lProgram;
+
+	// Vertex shader variables
+	lVariant.m_positionAttrib = glGetAttribLocation( lProgram, "a_position" );
+	lVariant.m_colorAttrib = glGetAttribLocation( lProgram, "a_color" );
+	lVariant.m_pointSizeAttrib = glGetAttribLocation( lProgram, "a_pointSize" );
+	lVariant.m_alphaAttrib = glGetAttribLocation( lProgram, "a_alpha" );
+	lVariant.m_atlasIndexAttrib = glGetAttribLocation( lProgram, "a_atlasIndex" );
+	lVariant.m_mvpMatrixUniform = glGetUniformLocation( lProgram, "u_mvpMatrix" );
+	lVariant.m_scaleOffsetUniform = glGetUniformLocation( lProgram, "u_scaleOffset" );
+	lVariant.m_atlasGridUniform = glGetUniformLocation( lProgram, "u_atlasGrid" );
+	lVariant.m_fogRangeUniform = glGetUniformLocation( lProgram, "u_fogRange" );
+
+	// Fragment shader variables
+	lVariant.m_texture0Uniform = glGetUniformLocation( lProgram, "u_texture0" );
+	lVariant.m_tintUniform = glGetUniformLocation( lProgram, "u_tint" );
+	lVariant.m_fogColorUniform = glGetUniformLocation( lProgram, "u_fogColor" );
+
+	return &lVariant;
+}
+
+}
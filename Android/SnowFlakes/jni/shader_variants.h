@@ -0,0 +1,215 @@
+#ifndef _GUILDHALL_SHADER_VARIANTS_H_
+#define _GUILDHALL_SHADER_VARIANTS_H_
+
+#include "program_cache.h"
+#include "types.h"
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+namespace guildhall {
+
+// Optional features of the point sprite shaders. Every combination is its
+// own program whose GLSL is put together at compile time, so a variant
+// only contains the code of the features it was built with.
+enum ShaderFeature
+{
+	SHADER_TINT = 1 << 0,        // Colour multiplied by the u_tint uniform.
+	SHADER_FLAKE_ALPHA = 1 << 1, // Per-flake alpha from the a_alpha attribute.
+	SHADER_ATLAS = 1 << 2,       // Sprite picked by a_atlasIndex from a u_atlasGrid atlas.
+	SHADER_DEPTH_FOG = 1 << 3,   // Faded towards u_fogColor by depth over u_fogRange.
+	SHADER_SCALE_OFFSET = 1 << 4 // x, y scale and offset from u_scaleOffset instead of u_mvpMatrix.
+};
+
+const uint32_t ShaderFeatureCount = 5;
+const uint32_t ShaderVariantCount = 1 << ShaderFeatureCount;
+
+// Fixed capacity string which can be appended to in constant expressions.
+template<size_t Capacity>
+struct ShaderText
+{
+	char m_text[Capacity];
+	size_t m_length;
+
+	constexpr ShaderText() : m_text(), m_length( 0 ) {}
+
+	template<size_t Length>
+	constexpr ShaderText& append( const char (&pText)[Length] )
+	{
+		for( size_t i = 0; i + 1 < Length; ++i )
+		{
+			m_text[m_length++] = pText[i];
+		}
+
+		m_text[m_length] = '\0';
+		return *this;
+	}
+
+	constexpr ShaderText& append( bool pCondition, const char* pText )
+	{
+		while( pCondition && *pText != '\0' )
+		{
+			m_text[m_length++] = *pText++;
+		}
+
+		m_text[m_length] = '\0';
+		return *this;
+	}
+};
+
+const size_t ShaderTextCapacity = 1024;
+
+constexpr ShaderText<ShaderTextCapacity> composeVertexShader( uint32_t pMask )
+{
+	ShaderText<ShaderTextCapacity> lText;
+
+	lText.append(
+		"attribute vec4 a_position;\n"
+		"attribute vec4 a_color;\n"
+		"attribute float a_pointSize;\n"
+		"varying vec4 v_color;\n" );
+	lText.append( (pMask & SHADER_SCALE_OFFSET) == 0,
+		"uniform mat4 u_mvpMatrix;\n" );
+	lText.append( (pMask & SHADER_SCALE_OFFSET) != 0,
+		"uniform vec4 u_scaleOffset;\n" );
+	lText.append( (pMask & SHADER_FLAKE_ALPHA) != 0,
+		"attribute float a_alpha;\n" );
+	lText.append( (pMask & SHADER_ATLAS) != 0,
+		"attribute float a_atlasIndex;\n"
+		"uniform vec2 u_atlasGrid;\n"
+		"varying vec2 v_atlasOffset;\n"
+		"varying vec2 v_atlasScale;\n" );
+	lText.append( (pMask & SHADER_DEPTH_FOG) != 0,
+		"uniform vec2 u_fogRange;\n"
+		"varying float v_fog;\n" );
+
+	lText.append(
+		"void main()\n"
+		"{\n" );
+	lText.append( (pMask & SHADER_SCALE_OFFSET) == 0,
+		"    gl_Position = u_mvpMatrix * a_position;\n" );
+	lText.append( (pMask & SHADER_SCALE_OFFSET) != 0,
+		"    gl_Position = vec4( a_position.xy * u_scaleOffset.xy + u_scaleOffset.zw, a_position.zw );\n" );
+	lText.append(
+		"    v_color = a_color;\n"
+		"    gl_PointSize = a_pointSize;\n" );
+	lText.append( (pMask & SHADER_FLAKE_ALPHA) != 0,
+		"    v_color.a *= a_alpha;\n" );
+	lText.append( (pMask & SHADER_ATLAS) != 0,
+		"    float lRow = floor( a_atlasIndex / u_atlasGrid.x );\n"
+		"    v_atlasScale = 1.0 / u_atlasGrid;\n"
+		"    v_atlasOffset = vec2( a_atlasIndex - lRow * u_atlasGrid.x, lRow ) * v_atlasScale;\n" );
+	lText.append( (pMask & SHADER_DEPTH_FOG) != 0,
+		"    v_fog = clamp( (a_position.z - u_fogRange.x) / (u_fogRange.y - u_fogRange.x), 0.0, 1.0 );\n" );
+	lText.append(
+		"}\n" );
+
+	return lText;
+}
+
+constexpr ShaderText<ShaderTextCapacity> composeFragmentShader( uint32_t pMask )
+{
+	ShaderText<ShaderTextCapacity> lText;
+
+	lText.append(
+		"precision mediump float;\n"
+		"varying vec4 v_color;\n"
+		"uniform sampler2D u_texture0;\n" );
+	lText.append( (pMask & SHADER_TINT) != 0,
+		"uniform vec4 u_tint;\n" );
+	lText.append( (pMask & SHADER_ATLAS) != 0,
+		"varying vec2 v_atlasOffset;\n"
+		"varying vec2 v_atlasScale;\n" );
+	lText.append( (pMask & SHADER_DEPTH_FOG) != 0,
+		"uniform vec4 u_fogColor;\n"
+		"varying float v_fog;\n" );
+
+	lText.append(
+		"void main()\n"
+		"{\n" );
+	lText.append( (pMask & SHADER_ATLAS) == 0,
+		"    vec4 lColor = v_color * texture2D( u_texture0, gl_PointCoord );\n" );
+	lText.append( (pMask & SHADER_ATLAS) != 0,
+		"    vec4 lColor = v_color * texture2D( u_texture0, v_atlasOffset + gl_PointCoord * v_atlasScale );\n" );
+	lText.append( (pMask & SHADER_TINT) != 0,
+		"    lColor *= u_tint;\n" );
+	lText.append( (pMask & SHADER_DEPTH_FOG) != 0,
+		"    lColor.rgb = mix( lColor.rgb, u_fogColor.rgb, v_fog );\n" );
+	lText.append(
+		"    gl_FragColor = lColor;\n"
+		"}\n" );
+
+	return lText;
+}
+
+// Sources of one variant, baked into the binary only for the masks which
+// are actually requested.
+template<uint32_t Mask>
+struct ShaderVariantSource
+{
+	static_assert( Mask < ShaderVariantCount, "Unknown shader feature." );
+
+	static constexpr ShaderText<ShaderTextCapacity> Vertex = composeVertexShader( Mask );
+	static constexpr ShaderText<ShaderTextCapacity> Fragment = composeFragmentShader( Mask );
+};
+
+template<uint32_t Mask>
+constexpr ShaderText<ShaderTextCapacity> ShaderVariantSource<Mask>::Vertex;
+
+template<uint32_t Mask>
+constexpr ShaderText<ShaderTextCapacity> ShaderVariantSource<Mask>::Fragment;
+
+// A linked variant with its locations, resolved once at link time. Inputs
+// the variant does not use are -1.
+struct ShaderProgram
+{
+	GLuint m_program;
+
+	GLint m_positionAttrib;
+	GLint m_colorAttrib;
+	GLint m_pointSizeAttrib;
+	GLint m_alphaAttrib;
+	GLint m_atlasIndexAttrib;
+
+	GLint m_mvpMatrixUniform;
+	GLint m_scaleOffsetUniform;
+	GLint m_texture0Uniform;
+	GLint m_tintUniform;
+	GLint m_atlasGridUniform;
+	GLint m_fogColorUniform;
+	GLint m_fogRangeUniform;
+};
+
+// Compiles variants on first use and keeps them by feature mask.
+class ShaderVariants
+{
+public:
+
+	ShaderVariants( ProgramCache* pProgramCache );
+
+	// GL thread only. Returns NULL if the variant does not compile.
+	template<uint32_t Mask>
+	const ShaderProgram* get()
+	{
+		if( m_programs[Mask].m_program != 0 )
+			return &m_programs[Mask];
+
+		return build( Mask, ShaderVariantSource<Mask>::Vertex.m_text,
+				ShaderVariantSource<Mask>::Fragment.m_text );
+	}
+
+	// Deletes every compiled variant; must run while the context is current.
+	void release();
+
+private:
+
+	const ShaderProgram* build( uint32_t pMask, const char* pVertexSource, const char* pFragmentSource );
+
+private:
+
+	ProgramCache* m_programCache;
+	ShaderProgram m_programs[ShaderVariantCount];
+};
+
+}
+#endif // _GUILDHALL_SHADER_VARIANTS_H_
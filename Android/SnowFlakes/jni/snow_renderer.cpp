@@ -0,0 +1,109 @@
+#include "snow_renderer.h"
+#include "log.h"
+#include "profiler.h"
+
+namespace guildhall {
+
+// Features of the snow shader variant, see ShaderFeature. The projection
+// is only a scale and offset, so the shader takes it as one vec4.
+const uint32_t SnowShaderFeatures = SHADER_SCALE_OFFSET;
+
+SnowRenderer::SnowRenderer() :
+		m_program( NULL ),
+		m_texture( NULL ),
+		m_width( 0 ),
+		m_height( 0 ),
+		m_gpuTimer( "Snow pass" )
+{
+}
+
+status SnowRenderer::initialize( ShaderVariants* pShaderVariants, Texture* pTexture, int32_t pWidth, int32_t pHeight )
+{
+	m_texture = pTexture;
+	m_program = pShaderVariants->get<SnowShaderFeatures>();
+
+	if( !m_program )
+	{
+		Log::error( "Could not create program." );
+		return STATUS_ERROR;
+	}
+
+	glDisable( GL_DEPTH_TEST );
+	glViewport( 0, 0, pWidth, pHeight );
+
+	m_width = pWidth;
+	m_height = pHeight;
+
+	m_projection = Affine2f::createOrthographicProjection( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY );
+
+	// This helps as a work around for order-dependency artifacts that can occur when sprites overlap.
+	glBlendFunc( GL_SRC_ALPHA, GL_ONE );
+
+	// Drawing works without GPU times.
+	m_gpuTimer.initialize();
+
+	return STATUS_OK;
+}
+
+void SnowRenderer::release()
+{
+	// Programs belong to the ShaderVariants.
+	m_program = NULL;
+	m_texture = NULL;
+	m_gpuTimer.release();
+}
+
+void SnowRenderer::draw( const SnowFlakes& pSnowFlakes )
+{
+	GUILDHALL_PROFILE_ZONE( "SnowRenderer::draw" );
+
+	int32_t lCount = m_culler.cull( pSnowFlakes, m_projection, m_width, m_height );
+
+	m_gpuTimer.collect();
+	m_gpuTimer.begin();
+
+	// Doodle jump sky color (or something like it).
+	glClearColor( 0.31f, 0.43f, 0.63f, 1.0f );
+	glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
+
+	// We don't care about depth for point sprites.
+	glDepthMask( GL_FALSE ); // Turn off depth writes
+
+	// Point sprites are always enabled in OpenGL ES 2.0.
+	glEnable( GL_BLEND );
+
+	glUseProgram( m_program->m_program );
+
+	if( (SnowShaderFeatures & SHADER_SCALE_OFFSET) != 0 )
+	{
+		Vector4f lScaleOffset = m_projection.getScaleOffset();
+		glUniform4f( m_program->m_scaleOffsetUniform, lScaleOffset.x, lScaleOffset.y, lScaleOffset.z, lScaleOffset.w );
+	}
+	else
+	{
+		glUniformMatrix4fv( m_program->m_mvpMatrixUniform, 1, GL_FALSE, m_projection.toMat4().m );
+	}
+
+	glVertexAttribPointer( m_program->m_positionAttrib, 2, GL_FLOAT, GL_FALSE, 0, m_culler.getPositions() );
+	glEnableVertexAttribArray( m_program->m_positionAttrib );
+
+	glVertexAttribPointer( m_program->m_colorAttrib, 4, GL_FLOAT, GL_FALSE, 0, m_culler.getColors() );
+	glEnableVertexAttribArray( m_program->m_colorAttrib );
+
+	glVertexAttribPointer( m_program->m_pointSizeAttrib, 1, GL_FLOAT, GL_FALSE, 0, m_culler.getSizes() );
+	glEnableVertexAttribArray( m_program->m_pointSizeAttrib );
+
+	glUniform1i( m_program->m_texture0Uniform, 0 );
+	m_texture->apply();
+
+	{
+		GUILDHALL_PROFILE_ZONE( "glDrawArrays" );
+		glDrawArrays( GL_POINTS, 0, lCount );
+	}
+
+	m_gpuTimer.end();
+
+	glDepthMask( GL_TRUE ); // Turn back on depth writes
+}
+
+}
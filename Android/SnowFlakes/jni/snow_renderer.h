@@ -0,0 +1,47 @@
+#ifndef _GUILDHALL_SNOW_RENDERER_H_
+#define _GUILDHALL_SNOW_RENDERER_H_
+
+#include "flake_culler.h"
+#include "gpu_timer.h"
+#include "renderer.h"
+#include "shader_variants.h"
+#include "snowflakes.h"
+#include "texture.h"
+#include "types.h"
+#include "vecmath.h"
+
+namespace guildhall {
+
+// Draws snow flakes as textured point sprites with OpenGL ES 2.0, over
+// the sky clear colour and with additive blending.
+class SnowRenderer : public Renderer
+{
+public:
+
+	SnowRenderer();
+
+	// GL thread only, with a current context. pTexture may still be
+	// loading, see AssetLoader.
+	status initialize( ShaderVariants* pShaderVariants, Texture* pTexture, int32_t pWidth, int32_t pHeight );
+	virtual void release();
+	virtual void draw( const SnowFlakes& pSnowFlakes );
+
+	// Only the flakes that overlap the viewport are drawn.
+	int32_t getDrawCount() const { return m_culler.getCount(); }
+	virtual float getCulledPercentage() const { return m_culler.getCulledPercentage(); }
+
+	// GPU time of the draw pass, from the clear to the last flake.
+	GpuTimer& getGpuTimer() { return m_gpuTimer; }
+
+private:
+
+	const ShaderProgram* m_program;
+	Texture* m_texture;
+	Affine2f m_projection;
+	int32_t m_width, m_height;
+	FlakeCuller m_culler;
+	GpuTimer m_gpuTimer;
+};
+
+}
+#endif // _GUILDHALL_SNOW_RENDERER_H_
@@ -1,17 +1,29 @@
 #include "texture.h"
 #include "log.h"
+#include "memory_tracker.h"
 #include "types.h"
 
+#include <string.h>
+
 namespace guildhall {
 
 Texture::Texture( android_app* pApplication, const char* pPath ) :
 		m_resource( pApplication, pPath ),
+		m_inMemoryDecode( true ),
+		m_streamBandRows( 0 ),
 		m_textureId( 0 ),
 		m_width( 0 ),
-		m_height( 0 )
+		m_height( 0 ),
+		m_format( 0 ),
+		m_pixels( NULL )
 {
 }
 
+Texture::~Texture()
+{
+	freeMemory( m_pixels );
+}
+
 const char* Texture::getPath()
 {
 	return m_resource.getPath();
@@ -27,28 +39,63 @@ int32_t Texture::getWidth()
 	return m_width;
 }
 
-uint8_t* Texture::loadImage()
+void Texture::setInMemoryDecode( bool pEnabled )
+{
+	m_inMemoryDecode = pEnabled;
+}
+
+void Texture::setStreamBandRows( int32_t pRows )
+{
+	m_streamBandRows = pRows;
+}
+
+status Texture::openImage( ImageReader* pReader )
 {
 	Log::info( "Loading texture %s", m_resource.getPath() );
 
 	png_byte lHeader[8];
+	const png_byte* lSignature = lHeader;
 	png_structp lPngPtr = NULL;
 	png_infop lInfoPtr = NULL;
-	png_byte* lImageBuffer = NULL;
-	png_bytep* lRowPtrs = NULL;
-	png_int_32 lRowSize;
+	png_size_t lRowSize;
 	bool lTransparency;
 
+	pReader->m_pngPtr = NULL;
+	pReader->m_infoPtr = NULL;
+	pReader->m_memory.m_data = NULL;
+	pReader->m_memory.m_length = 0;
+	pReader->m_memory.m_offset = 0;
+	pReader->m_rowSize = 0;
+	pReader->m_interlaced = false;
+
 	// Opens and checks image signature (first 8 bytes).
 	if( m_resource.open() != STATUS_OK )
 		goto ERROR;
 
+	// Prefers decoding from the whole resource in memory, which saves a
+	// read call and a copy for every chunk libpng asks for.
+	if( m_inMemoryDecode )
+	{
+		pReader->m_memory.m_data = (const png_byte*) m_resource.bufferize();
+		pReader->m_memory.m_length = m_resource.getLength();
+	}
+
 	guildhall_Log_debug("Checking signature.");
 
-	if( m_resource.read( lHeader, sizeof(lHeader) ) != STATUS_OK )
+	if( pReader->m_memory.m_data != NULL )
+	{
+		if( pReader->m_memory.m_length < sizeof(lHeader) )
+			goto ERROR;
+
+		lSignature = pReader->m_memory.m_data;
+		pReader->m_memory.m_offset = sizeof(lHeader);
+	}
+	else if( m_resource.read( lHeader, sizeof(lHeader) ) != STATUS_OK )
+	{
 		goto ERROR;
+	}
 
-	if( png_sig_cmp( lHeader, 0, 8 ) != 0 )
+	if( png_sig_cmp( (png_bytep) lSignature, 0, 8 ) != 0 )
 		goto ERROR;
 
 	// Creates required structures.
@@ -63,11 +110,18 @@ uint8_t* Texture::loadImage()
 	if( !lInfoPtr )
 		goto ERROR;
 
+	pReader->m_pngPtr = lPngPtr;
+	pReader->m_infoPtr = lInfoPtr;
+
 	// Prepares reading operation by setting-up a read callback.
-	png_set_read_fn( lPngPtr, &m_resource, callback_read );
+	if( pReader->m_memory.m_data != NULL )
+		png_set_read_fn( lPngPtr, &pReader->m_memory, callback_read_memory );
+	else
+		png_set_read_fn( lPngPtr, &m_resource, callback_read );
 
 	// Set-up error management. If an error occurs while reading,
-	// code will come back here and jump
+	// code will come back here and jump. Callers reading the image
+	// content must set up their own jump buffer.
 	if( setjmp( png_jmpbuf(lPngPtr) ) )
 		goto ERROR;
 
@@ -76,12 +130,13 @@ uint8_t* Texture::loadImage()
 	png_read_info( lPngPtr, lInfoPtr );
 
 	// Retrieves PNG info and updates PNG struct accordingly.
-	png_int_32 lDepth, lColorType;
+	png_int_32 lDepth, lColorType, lInterlaceType;
 	png_uint_32 lWidth, lHeight;
 	png_get_IHDR( lPngPtr, lInfoPtr, &lWidth, &lHeight, &lDepth, &lColorType,
-			NULL, NULL, NULL );
+			&lInterlaceType, NULL, NULL );
 	m_width = lWidth;
 	m_height = lHeight;
+	pReader->m_interlaced = (lInterlaceType != PNG_INTERLACE_NONE);
 
 	// Creates a full alpha channel if transparency is encoded as
 	// an array of palate entries or a single transparent color.
@@ -132,6 +187,10 @@ uint8_t* Texture::loadImage()
 			break;
 	}
 
+	// Interlaced images are read pass by pass.
+	if( pReader->m_interlaced )
+		png_set_interlace_handling( lPngPtr );
+
 	// Validates all transformations.
 	png_read_update_info( lPngPtr, lInfoPtr );
 
@@ -140,15 +199,57 @@ uint8_t* Texture::loadImage()
 	if( lRowSize <= 0 )
 		goto ERROR;
 
+	pReader->m_rowSize = lRowSize;
+	return STATUS_OK;
+
+	ERROR: Log::error( "Error while reading PNG file" );
+	closeImage( pReader );
+
+	if( pReader->m_pngPtr == NULL && lPngPtr != NULL )
+	{
+		png_infop* lInfoPtrP = lInfoPtr != NULL ? &lInfoPtr : NULL;
+		png_destroy_read_struct( &lPngPtr, lInfoPtrP, NULL );
+	}
+
+	return STATUS_ERROR;
+}
+
+void Texture::closeImage( ImageReader* pReader )
+{
+	m_resource.close();
+
+	if( pReader->m_pngPtr != NULL )
+	{
+		png_infop* lInfoPtrP = pReader->m_infoPtr != NULL ? &pReader->m_infoPtr : NULL;
+		png_destroy_read_struct( &pReader->m_pngPtr, lInfoPtrP, NULL );
+		pReader->m_pngPtr = NULL;
+		pReader->m_infoPtr = NULL;
+	}
+}
+
+uint8_t* Texture::loadImage()
+{
+	ImageReader lReader;
+
+	// Volatile since the error path reads them after libpng's longjmp.
+	png_byte* volatile lImageBuffer = NULL;
+	png_bytep* volatile lRowPtrs = NULL;
+
+	if( openImage( &lReader ) != STATUS_OK )
+		return NULL;
+
+	png_size_t lRowSize = lReader.m_rowSize;
+	int32_t lHeight = m_height;
+
 	// Creates the image buffer that will be sent to OpenGL.
-	lImageBuffer = new png_byte[lRowSize * lHeight];
+	lImageBuffer = allocateArray<png_byte>( MEMORY_CATEGORY_TEXTURES, lRowSize * lHeight );
 	if( !lImageBuffer )
 		goto ERROR;
 
 	// Pointers to each row of the image buffer. Row order is
 	// inverted because different coordinate systems are used by
 	// OpenGL (1st pixel is at bottom left) and PNGs (top-left).
-	lRowPtrs = new png_bytep[lHeight];
+	lRowPtrs = allocateArray<png_bytep>( MEMORY_CATEGORY_TEXTURES, lHeight );
 	if( !lRowPtrs )
 		goto ERROR;
 
@@ -157,27 +258,79 @@ uint8_t* Texture::loadImage()
 		lRowPtrs[lHeight - (i + 1)] = lImageBuffer + i * lRowSize;
 	}
 
+	if( setjmp( png_jmpbuf(lReader.m_pngPtr) ) )
+		goto ERROR;
+
 	// Reads image content.
-	png_read_image( lPngPtr, lRowPtrs );
+	png_read_image( lReader.m_pngPtr, lRowPtrs );
 
 	// Frees memory and resources.
-	m_resource.close();
-	png_destroy_read_struct( &lPngPtr, &lInfoPtr, NULL );
-	delete[] lRowPtrs;
+	closeImage( &lReader );
+	freeMemory( lRowPtrs );
 	return lImageBuffer;
 
 	ERROR: Log::error( "Error while reading PNG file" );
-	m_resource.close();
-	delete[] lRowPtrs;
-	delete[] lImageBuffer;
+	closeImage( &lReader );
+	freeMemory( lRowPtrs );
+	freeMemory( lImageBuffer );
+	return NULL;
+}
+
+status Texture::loadStreamed()
+{
+	ImageReader lReader;
+	png_byte* lBandBuffer = NULL;
 
-	if( lPngPtr != NULL )
+	if( openImage( &lReader ) != STATUS_OK )
+		return STATUS_ERROR;
+
+	// Interlaced rows only become final on the last pass, so these
+	// images need the whole image in memory anyway.
+	if( lReader.m_interlaced )
 	{
-		png_infop* lInfoPtrP = lInfoPtr != NULL ? &lInfoPtr : NULL;
-		png_destroy_read_struct( &lPngPtr, lInfoPtrP, NULL );
+		closeImage( &lReader );
+		return STATUS_EXIT;
 	}
 
-	return NULL;
+	png_size_t lRowSize = lReader.m_rowSize;
+	int32_t lHeight = m_height;
+	int32_t lBandRows = (m_streamBandRows < lHeight) ? m_streamBandRows : lHeight;
+
+	lBandBuffer = allocateArray<png_byte>( MEMORY_CATEGORY_TEXTURES, lRowSize * lBandRows );
+	if( !lBandBuffer )
+		goto ERROR;
+
+	// Allocates texture storage, bands are filled in below.
+	glTexImage2D( GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, NULL );
+
+	if( setjmp( png_jmpbuf(lReader.m_pngPtr) ) )
+		goto ERROR;
+
+	// PNG rows come top-down while OpenGL's first row is the bottom one,
+	// so each band is stored upside down and uploaded from the top of the
+	// texture towards the bottom.
+	for( int32_t lRow = 0; lRow < lHeight; lRow += lBandRows )
+	{
+		int32_t lCount = (lHeight - lRow < lBandRows) ? lHeight - lRow : lBandRows;
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			png_read_row( lReader.m_pngPtr, lBandBuffer + (lCount - (i + 1)) * lRowSize, NULL );
+		}
+
+		glTexSubImage2D( GL_TEXTURE_2D, 0, 0, lHeight - (lRow + lCount), m_width, lCount,
+				m_format, GL_UNSIGNED_BYTE, lBandBuffer );
+	}
+
+	png_read_end( lReader.m_pngPtr, NULL );
+	closeImage( &lReader );
+	freeMemory( lBandBuffer );
+	return STATUS_OK;
+
+	ERROR: Log::error( "Error while reading PNG file" );
+	closeImage( &lReader );
+	freeMemory( lBandBuffer );
+	return STATUS_ERROR;
 }
 
 void Texture::callback_read( png_structp pStruct, png_bytep pData, png_size_t pSize )
@@ -187,21 +340,27 @@ void Texture::callback_read( png_structp pStruct, png_bytep pData, png_size_t pS
 	if( lResource->read( pData, pSize ) != STATUS_OK )
 	{
 		lResource->close();
+		png_error( pStruct, "Error while reading PNG file" );
 	}
 }
 
-status Texture::load()
+void Texture::callback_read_memory( png_structp pStruct, png_bytep pData, png_size_t pSize )
 {
-	uint8_t* lImageBuffer = loadImage();
+	MemoryReader* lReader = ((MemoryReader*) png_get_io_ptr( pStruct ));
 
-	if( lImageBuffer == NULL )
-	{
-		return STATUS_ERROR;
-	}
+	if( pSize > lReader->m_length - lReader->m_offset )
+		png_error( pStruct, "Unexpected end of PNG data" );
 
+	memcpy( pData, lReader->m_data + lReader->m_offset, pSize );
+	lReader->m_offset += pSize;
+}
+
+void Texture::createTexture()
+{
 	// Creates a new OpenGL texture.
-	GLenum lErrorResult;
-	glGenTextures( 1, &m_textureId );
+	if( m_textureId == 0 )
+		glGenTextures( 1, &m_textureId );
+
 	glBindTexture( GL_TEXTURE_2D, m_textureId );
 
 	// Set-up texture properties.
@@ -209,10 +368,48 @@ status Texture::load()
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+}
+
+status Texture::load()
+{
+	uint8_t* lImageBuffer = NULL;
+
+	createTexture();
+
+	// PNG rows are tightly packed, whatever their width.
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
 
-	// Loads image data into OpenGL.
-	glTexImage2D( GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, lImageBuffer );
-	delete[] lImageBuffer;
+	status lResult = STATUS_EXIT;
+
+	if( m_streamBandRows > 0 )
+		lResult = loadStreamed();
+
+	// Falls back to decoding the whole image when streaming is disabled
+	// or not possible for this image.
+	if( lResult == STATUS_EXIT )
+	{
+		lImageBuffer = loadImage();
+
+		if( lImageBuffer != NULL )
+		{
+			// Loads image data into OpenGL.
+			glTexImage2D( GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, lImageBuffer );
+			freeMemory( lImageBuffer );
+			lResult = STATUS_OK;
+		}
+		else
+		{
+			lResult = STATUS_ERROR;
+		}
+	}
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	if( lResult != STATUS_OK )
+	{
+		unload();
+		return STATUS_ERROR;
+	}
 
 	if( glGetError() != GL_NO_ERROR )
 	{
@@ -224,6 +421,121 @@ status Texture::load()
 	return STATUS_OK;
 }
 
+status Texture::decode()
+{
+	freeMemory( m_pixels );
+	m_pixels = loadImage();
+
+	return (m_pixels != NULL) ? STATUS_OK : STATUS_ERROR;
+}
+
+status Texture::upload()
+{
+	if( m_pixels == NULL )
+		return STATUS_ERROR;
+
+	createTexture();
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	glTexImage2D( GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, m_pixels );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	freeMemory( m_pixels );
+	m_pixels = NULL;
+
+	if( glGetError() != GL_NO_ERROR )
+	{
+		Log::error( "Error loading texture into OpenGL." );
+		unload();
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+size_t Texture::getDecodedSize()
+{
+	if( m_pixels == NULL )
+		return 0;
+
+	size_t lChannels = 4;
+
+	switch( m_format )
+	{
+		case GL_LUMINANCE: lChannels = 1; break;
+		case GL_LUMINANCE_ALPHA: lChannels = 2; break;
+		case GL_RGB: lChannels = 3; break;
+	}
+
+	return lChannels * m_width * m_height;
+}
+
+const uint8_t* Texture::getPixels()
+{
+	return m_pixels;
+}
+
+GLint Texture::getFormat()
+{
+	return m_format;
+}
+
+void Texture::expandToRgba( uint32_t* pTexels )
+{
+	int32_t lChannels = 4;
+
+	switch( m_format )
+	{
+		case GL_LUMINANCE: lChannels = 1; break;
+		case GL_LUMINANCE_ALPHA: lChannels = 2; break;
+		case GL_RGB: lChannels = 3; break;
+	}
+
+	int32_t lCount = m_width * m_height;
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		const uint8_t* lTexel = m_pixels + i * lChannels;
+		uint32_t r, g, b, a = 0xff;
+
+		if( lChannels <= 2 )
+		{
+			r = g = b = lTexel[0];
+
+			if( lChannels == 2 )
+				a = lTexel[1];
+		}
+		else
+		{
+			r = lTexel[0];
+			g = lTexel[1];
+			b = lTexel[2];
+
+			if( lChannels == 4 )
+				a = lTexel[3];
+		}
+
+		pTexels[i] = r | (g << 8) | (b << 16) | (a << 24);
+	}
+}
+
+status Texture::loadPlaceholder()
+{
+	const uint8_t lWhite[4] = { 0xff, 0xff, 0xff, 0xff };
+
+	createTexture();
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, lWhite );
+
+	if( glGetError() != GL_NO_ERROR )
+	{
+		Log::error( "Error creating placeholder texture." );
+		unload();
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
 void Texture::unload()
 {
 	if( m_textureId != 0 )
@@ -232,6 +544,9 @@ void Texture::unload()
 		m_textureId = 0;
 	}
 
+	freeMemory( m_pixels );
+	m_pixels = NULL;
+
 	m_width = 0;
 	m_height = 0;
 	m_format = 0;
@@ -4,7 +4,6 @@
 #include "resource.h"
 #include "types.h"
 
-#include <android_native_app_glue.h>
 #include <GLES/gl.h>
 #include <png.h>
 
@@ -16,6 +15,10 @@ public:
 
 	Texture( android_app* pApplication, const char* pPath );
 
+	// Frees decoded pixels that were never uploaded. The OpenGL texture
+	// needs unload(), with the context current.
+	~Texture();
+
 	const char* getPath();
 	int32_t getHeight();
 	int32_t getWidth();
@@ -24,20 +27,77 @@ public:
 	void unload();
 	void apply();
 
+	// Two step loading for background decoding. decode() only works on
+	// the CPU side and may run on any thread, while upload() hands the
+	// decoded pixels to OpenGL and must run on the GL thread.
+	status decode();
+	status upload();
+	size_t getDecodedSize();
+
+	// Decoded pixels between decode() and upload(), bottom row first.
+	const uint8_t* getPixels();
+	GLint getFormat();
+
+	// Writes the decoded pixels as width * height RGBA texels (red in the
+	// lowest byte), whatever the decoded format.
+	void expandToRgba( uint32_t* pTexels );
+
+	// Creates the texture as a single white texel, so that it can be
+	// applied while the real image is still being decoded.
+	status loadPlaceholder();
+
+	// When enabled (the default), PNGs are decoded straight out of the
+	// resource's memory mapped buffer instead of being read chunk by chunk.
+	void setInMemoryDecode( bool pEnabled );
+
+	// When pRows is positive, load() decodes the image pRows rows at a
+	// time into a reusable band buffer and uploads each band on its own,
+	// which bounds the extra memory needed to one band. Zero (the default)
+	// decodes the whole image and uploads it at once.
+	void setStreamBandRows( int32_t pRows );
+
 protected:
 
+	// The decoded image, or NULL. Released with freeMemory().
 	uint8_t* loadImage();
+	status loadStreamed();
 
 private:
 
+	// Read cursor over a resource which has been bufferized.
+	struct MemoryReader
+	{
+		const png_byte* m_data;
+		size_t m_length;
+		size_t m_offset;
+	};
+
+	// libpng state of an image being decoded.
+	struct ImageReader
+	{
+		png_structp m_pngPtr;
+		png_infop m_infoPtr;
+		MemoryReader m_memory;
+		png_size_t m_rowSize;
+		bool m_interlaced;
+	};
+
+	void createTexture();
+	status openImage( ImageReader* pReader );
+	void closeImage( ImageReader* pReader );
+
 	static void callback_read( png_structp pStruct, png_bytep pData, png_size_t pSize );
+	static void callback_read_memory( png_structp pStruct, png_bytep pData, png_size_t pSize );
 
 private:
 
 	Resource m_resource;
+	bool m_inMemoryDecode;
+	int32_t m_streamBandRows;
 	GLuint m_textureId;
 	int32_t m_width, m_height;
 	GLint m_format;
+	uint8_t* m_pixels;
 };
 
 }
@@ -0,0 +1,32 @@
+#ifndef _GUILDHALL_ALIGNED_MEMORY_H_
+#define _GUILDHALL_ALIGNED_MEMORY_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+
+namespace guildhall {
+
+// Every ARM and x86 core the game runs on has 64 byte cache lines, which is
+// also more than any SIMD load needs.
+const size_t CacheLineSize = 64;
+
+// Heap memory starting on a multiple of pAlignment, a power of two no
+// smaller than sizeof(void*). NULL if there is not enough memory. Only
+// freeAligned() may release it.
+inline void* allocateAligned( size_t pBytes, size_t pAlignment )
+{
+	void* lMemory = NULL;
+
+	if( posix_memalign( &lMemory, pAlignment, pBytes ) != 0 )
+		return NULL;
+
+	return lMemory;
+}
+
+inline void freeAligned( void* pMemory )
+{
+	free( pMemory );
+}
+
+}
+#endif // _GUILDHALL_ALIGNED_MEMORY_H_
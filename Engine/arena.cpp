@@ -0,0 +1,96 @@
+#include "arena.h"
+
+#include <stdint.h>
+
+namespace guildhall {
+
+Arena::Arena( MemoryCategory pCategory, size_t pBlockSize ) :
+		m_category( pCategory ),
+		m_blockSize( pBlockSize ),
+		m_blocks( NULL ),
+		m_offset( 0 ),
+		m_used( 0 ),
+		m_highWater( 0 ),
+		m_capacity( 0 )
+{
+}
+
+Arena::~Arena()
+{
+	freeBlocks();
+}
+
+void* Arena::allocate( size_t pBytes, size_t pAlignment )
+{
+	if( m_blocks != NULL )
+	{
+		uintptr_t lStart = (uintptr_t) (m_blocks + 1);
+		uintptr_t lAddress = (lStart + m_offset + pAlignment - 1) & ~(uintptr_t) (pAlignment - 1);
+
+		if( lAddress + pBytes <= lStart + m_blocks->m_size )
+		{
+			m_offset = lAddress + pBytes - lStart;
+			m_used += pBytes;
+
+			if( m_used > m_highWater )
+				m_highWater = m_used;
+
+			return (void*) lAddress;
+		}
+	}
+
+	// What is left of the current block is given up.
+	size_t lSize = (pBytes + pAlignment > m_blockSize) ? pBytes + pAlignment : m_blockSize;
+
+	if( addBlock( lSize ) != STATUS_OK )
+		return NULL;
+
+	return allocate( pBytes, pAlignment );
+}
+
+void Arena::reset()
+{
+	// Next time everything fits in one block.
+	if( m_blocks != NULL && m_blocks->m_next != NULL )
+	{
+		size_t lCapacity = m_capacity;
+		freeBlocks();
+
+		// On failure the next allocate() tries again.
+		addBlock( lCapacity );
+	}
+
+	m_offset = 0;
+	m_used = 0;
+}
+
+status Arena::addBlock( size_t pSize )
+{
+	Block* lBlock = (Block*) allocateMemory( m_category, sizeof(Block) + pSize );
+
+	if( lBlock == NULL )
+		return STATUS_ERROR;
+
+	lBlock->m_next = m_blocks;
+	lBlock->m_size = pSize;
+
+	m_blocks = lBlock;
+	m_offset = 0;
+	m_capacity += pSize;
+	return STATUS_OK;
+}
+
+void Arena::freeBlocks()
+{
+	while( m_blocks != NULL )
+	{
+		Block* lNext = m_blocks->m_next;
+		freeMemory( m_blocks );
+		m_blocks = lNext;
+	}
+
+	m_offset = 0;
+	m_capacity = 0;
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef _GUILDHALL_ARENA_H_
+#define _GUILDHALL_ARENA_H_
+
+#include "memory_tracker.h"
+#include "types.h"
+
+#include <new>
+#include <utility>
+
+namespace guildhall {
+
+// Linear allocator for memory that is all released at once: a frame arena
+// is reset every frame, a level arena when its level (for the game, a GL
+// session) ends. allocate() only moves a pointer; when the current block
+// is full another one comes from allocateMemory(). reset() keeps the
+// memory, merging the blocks into one as large as all of them, so after
+// its first busy frame an arena makes no more allocations.
+//
+// reset() does not run destructors; objects made with create() that need
+// theirs are destroyed with destroy() first. Not thread safe.
+class Arena
+{
+public:
+
+	// pBlockSize is the size of the first block, and the least of later
+	// ones.
+	Arena( MemoryCategory pCategory, size_t pBlockSize );
+	~Arena();
+
+	// pAlignment is a power of two. NULL if there is not enough memory.
+	void* allocate( size_t pBytes, size_t pAlignment );
+
+	template<typename T>
+	T* allocateArray( int32_t pCount )
+	{
+		return (T*) allocate( pCount * sizeof(T), alignof(T) );
+	}
+
+	template<typename T, typename... Arguments>
+	T* create( Arguments&&... pArguments )
+	{
+		void* lMemory = allocate( sizeof(T), alignof(T) );
+		return (lMemory != NULL) ? new( lMemory ) T( std::forward<Arguments>( pArguments )... ) : NULL;
+	}
+
+	template<typename T>
+	void destroy( T* pObject )
+	{
+		if( pObject != NULL )
+			pObject->~T();
+	}
+
+	void reset();
+
+	// Bytes handed out since the last reset(), and the most ever.
+	size_t getUsed() const { return m_used; }
+	size_t getHighWater() const { return m_highWater; }
+
+	// Bytes of all blocks.
+	size_t getCapacity() const { return m_capacity; }
+
+private:
+
+	Arena( const Arena& );
+	Arena& operator = ( const Arena& );
+
+	struct Block
+	{
+		Block* m_next;
+		size_t m_size;
+	};
+
+	status addBlock( size_t pSize );
+	void freeBlocks();
+
+private:
+
+	MemoryCategory m_category;
+	size_t m_blockSize;
+
+	// Newest first; allocations come from the first.
+	Block* m_blocks;
+	size_t m_offset;
+
+	size_t m_used;
+	size_t m_highWater;
+	size_t m_capacity;
+};
+
+}
+#endif // _GUILDHALL_ARENA_H_
@@ -0,0 +1,129 @@
+#include "block_snowflakes.h"
+#include "aligned_memory.h"
+#include "kernels.h"
+#include "profiler.h"
+
+#include <string.h>
+
+namespace guildhall {
+
+BlockSnowFlakes::BlockSnowFlakes( int32_t pCount ) :
+		m_count( pCount ),
+		m_blockCount( (pCount + FlakeBlockSize - 1) / FlakeBlockSize ),
+		m_hot( NULL ),
+		m_cold( NULL )
+{
+	m_hot = (FlakeHotBlock*) allocateAligned( m_blockCount * sizeof(FlakeHotBlock), CacheLineSize );
+	m_cold = (FlakeColdBlock*) allocateAligned( m_blockCount * sizeof(FlakeColdBlock), CacheLineSize );
+
+	// So that the unused lanes of the last block hold numbers.
+	memset( m_hot, 0, m_blockCount * sizeof(FlakeHotBlock) );
+	memset( m_cold, 0, m_blockCount * sizeof(FlakeColdBlock) );
+}
+
+BlockSnowFlakes::~BlockSnowFlakes()
+{
+	freeAligned( m_hot );
+	freeAligned( m_cold );
+}
+
+void BlockSnowFlakes::spawn( uint32_t pSeed )
+{
+	m_random.seed( pSeed );
+
+	// The same draws in the same order as SnowFlakes::spawn().
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		FlakeHotBlock& lHot = m_hot[i / FlakeBlockSize];
+		FlakeColdBlock& lCold = m_cold[i / FlakeBlockSize];
+		int32_t lLane = i % FlakeBlockSize;
+
+		lHot.x[lLane] = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+		lHot.y[lLane] = m_random.nextFloat( -ViewMaxY, ViewMaxY );
+
+		lHot.velX[lLane] = m_random.nextFloat( -0.004f, 0.004f );
+		lHot.velY[lLane] = m_random.nextFloat( -0.01f, -0.008f );
+
+		lCold.color[lLane * 4 + 0] = 1.0f;
+		lCold.color[lLane * 4 + 1] = 1.0f;
+		lCold.color[lLane * 4 + 2] = 1.0f;
+		lCold.color[lLane * 4 + 3] = 1.0f;
+
+		lCold.size[lLane] = m_random.nextFloat( 3.0, 6.0f );
+
+		lHot.timeSinceLastTurn[lLane] = m_random.nextFloat( -5.0, 0.0f );
+	}
+}
+
+void BlockSnowFlakes::update( float pElapsed )
+{
+	GUILDHALL_PROFILE_ZONE( "BlockSnowFlakes::update" );
+
+	const Kernels& lKernels = getKernels();
+	int32_t lFullBlocks = m_count / FlakeBlockSize;
+	int32_t b = 0;
+
+	// The kernel stops at blocks where a flake turns or respawns. Those
+	// draw random numbers, which has to happen in flake order, so they
+	// are done here one flake at a time.
+	while( b < lFullBlocks )
+	{
+		b += lKernels.m_stepFlakeBlocks( &m_hot[b], lFullBlocks - b, pElapsed );
+
+		if( b < lFullBlocks )
+		{
+			for( int32_t lLane = 0; lLane < FlakeBlockSize; ++lLane )
+				updateFlake( &m_hot[b], lLane, pElapsed );
+
+			++b;
+		}
+	}
+
+	for( int32_t lLane = 0; lLane < m_count - lFullBlocks * FlakeBlockSize; ++lLane )
+		updateFlake( &m_hot[lFullBlocks], lLane, pElapsed );
+}
+
+void BlockSnowFlakes::updateFlake( FlakeHotBlock* pBlock, int32_t pLane, float pElapsed )
+{
+	float& lTimer = pBlock->timeSinceLastTurn[pLane];
+	lTimer += pElapsed;
+
+	if( lTimer >= TimeTillTurn )
+	{
+		pBlock->velX[pLane] = -pBlock->velX[pLane];
+		lTimer = m_random.nextFloat( -5.0, 0.0f );
+	}
+
+	float lModifier = lTimer * TimeTillTurnNormalizedUnit;
+	float x = pBlock->x[pLane] + pBlock->velX[pLane] * lModifier;
+	float y = pBlock->y[pLane] + pBlock->velY[pLane];
+
+	if( y < -(ViewMaxY + 0.2f) || x < -(ViewMaxX + 0.2f) || x > (ViewMaxX + 0.2f) )
+	{
+		x = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+		y = 3.1f;
+	}
+
+	pBlock->x[pLane] = x;
+	pBlock->y[pLane] = y;
+}
+
+void BlockSnowFlakes::copyRenderState( float* pPositions, float* pColors, float* pSizes ) const
+{
+	for( int32_t b = 0; b < m_blockCount; ++b )
+	{
+		int32_t lFirst = b * FlakeBlockSize;
+		int32_t lCount = (m_count - lFirst < FlakeBlockSize) ? m_count - lFirst : FlakeBlockSize;
+
+		for( int32_t lLane = 0; lLane < lCount; ++lLane )
+		{
+			pPositions[(lFirst + lLane) * 2 + 0] = m_hot[b].x[lLane];
+			pPositions[(lFirst + lLane) * 2 + 1] = m_hot[b].y[lLane];
+		}
+
+		memcpy( &pColors[lFirst * 4], m_cold[b].color, lCount * 4 * sizeof(float) );
+		memcpy( &pSizes[lFirst], m_cold[b].size, lCount * sizeof(float) );
+	}
+}
+
+}
@@ -0,0 +1,94 @@
+#ifndef _GUILDHALL_BLOCK_SNOWFLAKES_H_
+#define _GUILDHALL_BLOCK_SNOWFLAKES_H_
+
+#include "random.h"
+#include "snowflakes.h"
+#include "types.h"
+
+namespace guildhall {
+
+// The SnowFlakes simulation with its state in blocks of FlakeBlockSize
+// flakes (an array of structures of arrays). What update() reads and
+// writes is in one array of blocks and what only drawing needs in
+// another, so the update streams 20 bytes a flake and never brings colours
+// or sizes into the cache, and each field of a block is four aligned
+// SIMD vectors:
+//
+//     FlakeHotBlock    x, y, velocity x and y, time since the last turn
+//                      (320 bytes, five cache lines)
+//     FlakeColdBlock   RGBA colours and sizes (320 bytes)
+//
+// Flake i is lane i % FlakeBlockSize of block i / FlakeBlockSize. Lanes of
+// the last block past the count are never read.
+//
+// update() steps whole blocks with the kernel kernels.h picks for the CPU.
+// spawn() and update() give the same flakes, bit for bit, as SnowFlakes
+// does with the same seed and timesteps, unless the compiler fuses the
+// latter's multiply-adds.
+
+const int32_t FlakeBlockSize = 16;
+
+struct FlakeHotBlock
+{
+	float x[FlakeBlockSize];
+	float y[FlakeBlockSize];
+	float velX[FlakeBlockSize];
+	float velY[FlakeBlockSize];
+	float timeSinceLastTurn[FlakeBlockSize];
+};
+
+struct FlakeColdBlock
+{
+	float color[FlakeBlockSize * 4];
+	float size[FlakeBlockSize];
+};
+
+class BlockSnowFlakes
+{
+public:
+
+	BlockSnowFlakes( int32_t pCount );
+	~BlockSnowFlakes();
+
+	void spawn( uint32_t pSeed );
+	void update( float pElapsed );
+
+	// Writes the positions, colours and sizes in SnowFlakes' layout, for
+	// renderers that take those.
+	void copyRenderState( float* pPositions, float* pColors, float* pSizes ) const;
+
+	int32_t getCount() const { return m_count; }
+	int32_t getBlockCount() const { return m_blockCount; }
+
+	// Cache line aligned.
+	FlakeHotBlock* getHotBlocks() { return m_hot; }
+	const FlakeHotBlock* getHotBlocks() const { return m_hot; }
+	FlakeColdBlock* getColdBlocks() { return m_cold; }
+	const FlakeColdBlock* getColdBlocks() const { return m_cold; }
+
+	// One flake at a time.
+	float getX( int32_t pIndex ) const { return m_hot[pIndex / FlakeBlockSize].x[pIndex % FlakeBlockSize]; }
+	float getY( int32_t pIndex ) const { return m_hot[pIndex / FlakeBlockSize].y[pIndex % FlakeBlockSize]; }
+	float getSize( int32_t pIndex ) const { return m_cold[pIndex / FlakeBlockSize].size[pIndex % FlakeBlockSize]; }
+	const float* getColor( int32_t pIndex ) const { return &m_cold[pIndex / FlakeBlockSize].color[(pIndex % FlakeBlockSize) * 4]; }
+
+private:
+
+	BlockSnowFlakes( const BlockSnowFlakes& );
+	BlockSnowFlakes& operator = ( const BlockSnowFlakes& );
+
+	void updateFlake( FlakeHotBlock* pBlock, int32_t pLane, float pElapsed );
+
+private:
+
+	int32_t m_count;
+	int32_t m_blockCount;
+
+	FlakeHotBlock* m_hot;
+	FlakeColdBlock* m_cold;
+
+	Random m_random;
+};
+
+}
+#endif // _GUILDHALL_BLOCK_SNOWFLAKES_H_
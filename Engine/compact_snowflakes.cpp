@@ -0,0 +1,238 @@
+#include "compact_snowflakes.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "simd.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace guildhall {
+
+namespace {
+
+// TimeTillTurn in ticks of the turn clock.
+const int16_t TurnAge = (int16_t) (TimeTillTurn * (1 << CompactSnowFlakes::TimeShift));
+
+// TimeTillTurnNormalizedUnit, 1/3, in Q16 for mulHigh().
+const int16_t OneThird = 21845;
+
+// The respawn bounds in Q13, rounded towards zero so that comparing with
+// them is the same as comparing with the float bounds.
+const int16_t RespawnX = (int16_t) ((ViewMaxX + 0.2f) * (1 << CompactSnowFlakes::PositionShift));
+const int16_t RespawnY = (int16_t) ((ViewMaxY + 0.2f) * (1 << CompactSnowFlakes::PositionShift));
+
+inline int16_t toFixed( float pValue, int32_t pShift )
+{
+	return (int16_t) lrintf( pValue * (float) (1 << pShift) );
+}
+
+inline float fromFixed( int32_t pValue, int32_t pShift )
+{
+	return (float) pValue * (1.0f / (float) (1 << pShift));
+}
+
+// What int16x8MulHigh() does to each lane.
+inline int16_t mulHigh( int16_t a, int16_t b )
+{
+	return (int16_t) (((int32_t) a * b) >> 16);
+}
+
+// Time since the turn, from the clock and the turn start.
+inline int16_t turnAge( uint16_t pTime, int16_t pTurnStart )
+{
+	return (int16_t) (uint16_t) (pTime - (uint16_t) pTurnStart);
+}
+
+}
+
+CompactSnowFlakes::CompactSnowFlakes( int32_t pCount ) :
+		m_count( pCount ),
+		m_x( allocateArray<int16_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_y( allocateArray<int16_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_velX( allocateArray<int8_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_velY( allocateArray<int8_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_turnStart( allocateArray<int16_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_paletteIndex( allocateArray<uint8_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_size( allocateArray<uint8_t>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_time( 0 )
+{
+	memset( m_palette, 0, sizeof(m_palette) );
+}
+
+CompactSnowFlakes::~CompactSnowFlakes()
+{
+	freeMemory( m_x );
+	freeMemory( m_y );
+	freeMemory( m_velX );
+	freeMemory( m_velY );
+	freeMemory( m_turnStart );
+	freeMemory( m_paletteIndex );
+	freeMemory( m_size );
+}
+
+void CompactSnowFlakes::spawn( uint32_t pSeed )
+{
+	m_random.seed( pSeed );
+	m_time = 0;
+
+	memset( m_palette, 0, sizeof(m_palette) );
+	m_palette[0] = 1.0f;
+	m_palette[1] = 1.0f;
+	m_palette[2] = 1.0f;
+	m_palette[3] = 1.0f;
+
+	// The same draws in the same order as SnowFlakes::spawn().
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		m_x[i] = toFixed( m_random.nextFloat( -ViewMaxX, ViewMaxX ), PositionShift );
+		m_y[i] = toFixed( m_random.nextFloat( -ViewMaxY, ViewMaxY ), PositionShift );
+
+		m_velX[i] = (int8_t) toFixed( m_random.nextFloat( -0.004f, 0.004f ), VelocityXShift );
+		m_velY[i] = (int8_t) toFixed( m_random.nextFloat( -0.01f, -0.008f ), VelocityYShift );
+
+		m_paletteIndex[i] = 0;
+		m_size[i] = (uint8_t) toFixed( m_random.nextFloat( 3.0, 6.0f ), SizeShift );
+
+		m_turnStart[i] = (int16_t) -toFixed( m_random.nextFloat( -5.0, 0.0f ), TimeShift );
+	}
+}
+
+void CompactSnowFlakes::assign( const SnowFlakes& pFlakes )
+{
+	const float* lPositions = pFlakes.getPositions();
+	const float* lVelocities = pFlakes.getVelocities();
+	const float* lColors = pFlakes.getColors();
+	const float* lSizes = pFlakes.getSizes();
+	const float* lTimers = pFlakes.getTurnTimers();
+	int32_t lPaletteCount = 0;
+
+	m_random = pFlakes.getRandom();
+	m_time = 0;
+	memset( m_palette, 0, sizeof(m_palette) );
+
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		m_x[i] = toFixed( lPositions[i * 2 + 0], PositionShift );
+		m_y[i] = toFixed( lPositions[i * 2 + 1], PositionShift );
+		m_velX[i] = (int8_t) toFixed( lVelocities[i * 2 + 0], VelocityXShift );
+		m_velY[i] = (int8_t) toFixed( lVelocities[i * 2 + 1], VelocityYShift );
+		m_size[i] = (uint8_t) toFixed( lSizes[i], SizeShift );
+		m_turnStart[i] = (int16_t) -toFixed( lTimers[i], TimeShift );
+
+		// Colours go into the palette as they are found; past 256 of them
+		// the rest take colour 0.
+		const float* lColor = &lColors[i * 4];
+		int32_t lIndex = 0;
+
+		while( lIndex < lPaletteCount && memcmp( &m_palette[lIndex * 4], lColor, 4 * sizeof(float) ) != 0 )
+			++lIndex;
+
+		if( lIndex == lPaletteCount )
+		{
+			if( lPaletteCount < PaletteSize )
+				memcpy( &m_palette[lPaletteCount++ * 4], lColor, 4 * sizeof(float) );
+			else
+				lIndex = 0;
+		}
+
+		m_paletteIndex[i] = (uint8_t) lIndex;
+	}
+}
+
+void CompactSnowFlakes::update( float pElapsed )
+{
+	GUILDHALL_PROFILE_ZONE( "CompactSnowFlakes::update" );
+
+	float lElapsed = (pElapsed < 1.0f) ? pElapsed : 1.0f;
+	m_time = (uint16_t) (m_time + toFixed( (lElapsed > 0.0f) ? lElapsed : 0.0f, TimeShift ));
+
+	const Int16x8 lTime = int16x8Splat( (int16_t) m_time );
+	const Int16x8 lLastAgeBeforeTurn = int16x8Splat( TurnAge - 1 );
+	const Int16x8 lOneThird = int16x8Splat( OneThird );
+	const Int16x8 lRounding = int16x8Splat( 32 );
+	const Int16x8 lRespawnX = int16x8Splat( RespawnX );
+	const Int16x8 lRespawnLeft = int16x8Splat( -RespawnX );
+	const Int16x8 lRespawnBottom = int16x8Splat( -RespawnY );
+
+	int32_t i = 0;
+
+	for( ; i + 8 <= m_count; i += 8 )
+	{
+		Int16x8 x = int16x8Load( &m_x[i] );
+		Int16x8 y = int16x8Load( &m_y[i] );
+		Int16x8 lVelX = int16x8LoadInt8( &m_velX[i] );
+		Int16x8 lVelY = int16x8LoadInt8( &m_velY[i] );
+		Int16x8 lAge = int16x8Sub( lTime, int16x8Load( &m_turnStart[i] ) );
+
+		// The same steps as updateFlake().
+		Int16x8 lModifier = int16x8Add( lAge, int16x8MulHigh( lAge, lOneThird ) );
+		Int16x8 lDx = int16x8ShiftRight<6>( int16x8Add( int16x8MulHigh( int16x8ShiftLeft<7>( lVelX ), lModifier ), lRounding ) );
+
+		x = int16x8Add( x, lDx );
+		y = int16x8Add( y, lVelY );
+
+		// Turns and respawns draw random numbers, which has to happen in
+		// flake order, so groups with any of them are redone one by one.
+		Int16x8 lEvents = int16x8Or( int16x8Greater( lAge, lLastAgeBeforeTurn ),
+				int16x8Or( int16x8Greater( lRespawnBottom, y ),
+				int16x8Or( int16x8Greater( lRespawnLeft, x ), int16x8Greater( x, lRespawnX ) ) ) );
+
+		if( int16x8Any( lEvents ) )
+		{
+			for( int32_t j = 0; j < 8; ++j )
+				updateFlake( i + j );
+
+			continue;
+		}
+
+		int16x8Store( &m_x[i], x );
+		int16x8Store( &m_y[i], y );
+	}
+
+	for( ; i < m_count; ++i )
+		updateFlake( i );
+}
+
+void CompactSnowFlakes::updateFlake( int32_t pIndex )
+{
+	int16_t lAge = turnAge( m_time, m_turnStart[pIndex] );
+
+	if( lAge >= TurnAge )
+	{
+		m_velX[pIndex] = (int8_t) -m_velX[pIndex];
+
+		lAge = toFixed( m_random.nextFloat( -5.0, 0.0f ), TimeShift );
+		m_turnStart[pIndex] = (int16_t) (uint16_t) (m_time - (uint16_t) lAge);
+	}
+
+	// Age * 4/3 is the time since the turn over TimeTillTurn in Q14, and
+	// the velocity goes to Q21 so that the product keeps Q13 after >> 16
+	// and a rounded >> 6.
+	int16_t lModifier = (int16_t) (lAge + mulHigh( lAge, OneThird ));
+	int16_t lDx = (int16_t) ((mulHigh( (int16_t) (m_velX[pIndex] * 128), lModifier ) + 32) >> 6);
+
+	int16_t x = (int16_t) (m_x[pIndex] + lDx);
+	int16_t y = (int16_t) (m_y[pIndex] + m_velY[pIndex]);
+
+	if( y < -RespawnY || x < -RespawnX || x > RespawnX )
+	{
+		x = toFixed( m_random.nextFloat( -ViewMaxX, ViewMaxX ), PositionShift );
+		y = toFixed( 3.1f, PositionShift );
+	}
+
+	m_x[pIndex] = x;
+	m_y[pIndex] = y;
+}
+
+void CompactSnowFlakes::decodeRenderState( float* pPositions, float* pColors, float* pSizes ) const
+{
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		pPositions[i * 2 + 0] = fromFixed( m_x[i], PositionShift );
+		pPositions[i * 2 + 1] = fromFixed( m_y[i], PositionShift );
+		memcpy( &pColors[i * 4], &m_palette[m_paletteIndex[i] * 4], 4 * sizeof(float) );
+		pSizes[i] = fromFixed( m_size[i], SizeShift );
+	}
+}
+
+}
@@ -0,0 +1,105 @@
+#ifndef _GUILDHALL_COMPACT_SNOWFLAKES_H_
+#define _GUILDHALL_COMPACT_SNOWFLAKES_H_
+
+#include "random.h"
+#include "snowflakes.h"
+#include "types.h"
+
+namespace guildhall {
+
+// The SnowFlakes simulation in fixed point, 10 bytes a flake instead of 56,
+// for flake counts where streaming the float state every frame is what
+// limits the update:
+//
+//     x, y        int16, view units * 2^13 (Q13, 1/8192 of a unit)
+//     velocity    int8 x in Q14 and int8 y in Q13, per step like SnowFlakes'
+//     turn start  int16, when the flake last turned, in 1/4096 s
+//     colour      uint8 index into a palette of 256 RGBA colours
+//     size        uint8, pixels * 32
+//
+// Instead of a timer that every step writes back, each flake keeps the
+// time it turned on a clock that update() advances, wrapping around at 16
+// seconds; its time since the turn is the wrapped difference. So a step
+// only writes x and y, except for the flakes that turn or respawn.
+//
+// update() works on eight flakes at a time with 16 bit integer SSE2 or
+// NEON. It makes the same decisions as SnowFlakes::update() and takes
+// random numbers in the same order, so from the same state (see assign())
+// a step lands within 1/16 of a pixel of the float one for every flake but
+// those whose timer is within a tick of turning. Q13 is 1/68 of a pixel
+// across the 480 pixel wide reference view.
+//
+// That holds for one step only. The quantised velocities are off by up to
+// half their last bit every step, in the same direction, so left to run a
+// flake drifts from the float one by about 1/120 of a pixel a step, half a
+// pixel a second, and a turn a tick early or late makes the two take
+// different random numbers from then on. The state is the same kind of
+// snow, not the same flakes.
+class CompactSnowFlakes
+{
+public:
+
+	static const int32_t PositionShift = 13;
+	static const int32_t VelocityXShift = 14;
+	static const int32_t VelocityYShift = 13;
+	static const int32_t TimeShift = 12;
+	static const int32_t SizeShift = 5;
+	static const int32_t PaletteSize = 256;
+
+	CompactSnowFlakes( int32_t pCount );
+	~CompactSnowFlakes();
+
+	// The flakes SnowFlakes::spawn( pSeed ) makes, rounded to fixed point.
+	// Every flake takes palette colour 0, white.
+	void spawn( uint32_t pSeed );
+
+	// Rounds the whole state of pFlakes, random generator included, which
+	// must have the same count.
+	void assign( const SnowFlakes& pFlakes );
+
+	// Timesteps over a second are taken as a second.
+	void update( float pElapsed );
+
+	// Writes the positions, colours and sizes in SnowFlakes' float layout,
+	// for renderers that take those.
+	void decodeRenderState( float* pPositions, float* pColors, float* pSizes ) const;
+
+	int32_t getCount() const { return m_count; }
+	const int16_t* getX() const { return m_x; }
+	const int16_t* getY() const { return m_y; }
+	const uint8_t* getPaletteIndices() const { return m_paletteIndex; }
+	const uint8_t* getSizes() const { return m_size; }
+
+	// PaletteSize RGBA colours.
+	float* getPalette() { return m_palette; }
+	const float* getPalette() const { return m_palette; }
+
+private:
+
+	CompactSnowFlakes( const CompactSnowFlakes& );
+	CompactSnowFlakes& operator = ( const CompactSnowFlakes& );
+
+	void updateFlake( int32_t pIndex );
+
+private:
+
+	int32_t m_count;
+
+	// Hot: read every step.
+	int16_t* m_x;
+	int16_t* m_y;
+	int8_t* m_velX;
+	int8_t* m_velY;
+	int16_t* m_turnStart;
+
+	// Cold: only read to draw.
+	uint8_t* m_paletteIndex;
+	uint8_t* m_size;
+	float m_palette[PaletteSize * 4];
+
+	uint16_t m_time;
+	Random m_random;
+};
+
+}
+#endif // _GUILDHALL_COMPACT_SNOWFLAKES_H_
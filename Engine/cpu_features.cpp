@@ -0,0 +1,99 @@
+#include "cpu_features.h"
+
+#if defined(__ANDROID__)
+#include <cpu-features.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <stddef.h>
+#endif
+
+namespace guildhall {
+
+namespace {
+
+#if defined(__ANDROID__)
+
+uint32_t detectCpuFeatures()
+{
+	AndroidCpuFamily lFamily = android_getCpuFamily();
+	uint64_t lFeatures = android_getCpuFeatures();
+	uint32_t lResult = 0;
+
+	if( lFamily == ANDROID_CPU_FAMILY_ARM && (lFeatures & ANDROID_CPU_ARM_FEATURE_NEON) != 0 )
+		lResult |= CPU_FEATURE_NEON;
+
+	if( lFamily == ANDROID_CPU_FAMILY_ARM64 )
+		lResult |= CPU_FEATURE_NEON;
+
+	// Every x86 Android ABI requires at least SSSE3.
+	if( lFamily == ANDROID_CPU_FAMILY_X86 || lFamily == ANDROID_CPU_FAMILY_X86_64 )
+	{
+		lResult |= CPU_FEATURE_SSE2;
+
+		if( (lFeatures & ANDROID_CPU_X86_FEATURE_AVX2) != 0 )
+			lResult |= CPU_FEATURE_AVX2;
+	}
+
+	return lResult;
+}
+
+#elif defined(__i386__) || defined(__x86_64__)
+
+uint32_t detectCpuFeatures()
+{
+	uint32_t a, b, c, d;
+	uint32_t lResult = 0;
+
+	if( __get_cpuid( 1, &a, &b, &c, &d ) == 0 )
+		return 0;
+
+	if( (d & bit_SSE2) != 0 )
+		lResult |= CPU_FEATURE_SSE2;
+
+	// AVX2 needs the CPU to have AVX and the OS to save the XMM and YMM
+	// registers on a context switch, which it says in XCR0.
+	bool lHasAvx = (c & bit_OSXSAVE) != 0 && (c & bit_AVX) != 0;
+
+	if( lHasAvx )
+	{
+		uint32_t lLow, lHigh;
+		__asm__( "xgetbv" : "=a"( lLow ), "=d"( lHigh ) : "c"( 0 ) );
+		lHasAvx = (lLow & 6) == 6;
+	}
+
+	if( lHasAvx && __get_cpuid_max( 0, NULL ) >= 7 )
+	{
+		__cpuid_count( 7, 0, a, b, c, d );
+
+		if( (b & bit_AVX2) != 0 )
+			lResult |= CPU_FEATURE_AVX2;
+	}
+
+	return lResult;
+}
+
+#elif defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+uint32_t detectCpuFeatures()
+{
+	return CPU_FEATURE_NEON;
+}
+
+#else
+
+uint32_t detectCpuFeatures()
+{
+	return 0;
+}
+
+#endif
+
+}
+
+uint32_t getCpuFeatures()
+{
+	static const uint32_t lFeatures = detectCpuFeatures();
+	return lFeatures;
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef _GUILDHALL_CPU_FEATURES_H_
+#define _GUILDHALL_CPU_FEATURES_H_
+
+#include "types.h"
+
+namespace guildhall {
+
+// Instruction set extensions of the CPU the game is running on, as far as
+// the kernels in kernels.h care about them. On Android they come from the
+// NDK's cpufeatures library, on other x86 targets from cpuid (AVX2 only
+// counts when the OS saves the AVX registers too), and 64 bit ARM always
+// has NEON.
+enum CpuFeature
+{
+	CPU_FEATURE_SSE2 = 1 << 0,
+	CPU_FEATURE_AVX2 = 1 << 1,
+	CPU_FEATURE_NEON = 1 << 2
+};
+
+// A mask of CpuFeature. Detected on the first call.
+uint32_t getCpuFeatures();
+
+}
+#endif // _GUILDHALL_CPU_FEATURES_H_
@@ -0,0 +1,34 @@
+#include "flake_culler.h"
+#include "kernels.h"
+#include "profiler.h"
+
+namespace guildhall {
+
+FlakeCuller::FlakeCuller() :
+		m_count( 0 ),
+		m_culledPercentage( 0.0f )
+{
+}
+
+int32_t FlakeCuller::cull( const SnowFlakes& pSnowFlakes, const Affine2f& pProjection, int32_t pWidth, int32_t pHeight )
+{
+	GUILDHALL_PROFILE_ZONE( "FlakeCuller::cull" );
+
+	int32_t lCount = pSnowFlakes.getCount();
+
+	if( (int32_t) m_size.size() < lCount )
+	{
+		m_pos.resize( lCount * 2 );
+		m_col.resize( lCount * 4 );
+		m_size.resize( lCount );
+	}
+
+	m_count = getKernels().m_packVisibleFlakes( pSnowFlakes.getPositions(), pSnowFlakes.getColors(),
+			pSnowFlakes.getSizes(), lCount, pProjection.m, pWidth, pHeight, m_pos.data(), m_col.data(), m_size.data() );
+
+	m_culledPercentage = (lCount > 0) ? 100.0f * (lCount - m_count) / lCount : 0.0f;
+
+	return m_count;
+}
+
+}
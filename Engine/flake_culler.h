@@ -0,0 +1,48 @@
+#ifndef _GUILDHALL_FLAKE_CULLER_H_
+#define _GUILDHALL_FLAKE_CULLER_H_
+
+#include "snowflakes.h"
+#include "types.h"
+#include "vecmath.h"
+
+#include <vector>
+
+namespace guildhall {
+
+// Copies the flakes that can touch the viewport into packed draw arrays,
+// so flakes waiting above the view or drifting off its sides are neither
+// uploaded nor rasterized. A flake counts as visible while any part of its
+// point sprite overlaps the viewport.
+class FlakeCuller
+{
+public:
+
+	FlakeCuller();
+
+	// pProjection takes flake positions to clip space, such as the
+	// orthographic projection the renderers use. Returns the number of
+	// visible flakes.
+	int32_t cull( const SnowFlakes& pSnowFlakes, const Affine2f& pProjection, int32_t pWidth, int32_t pHeight );
+
+	// Visible flakes from the last cull(), in simulation order.
+	int32_t getCount() const { return m_count; }
+	const float* getPositions() const { return m_pos.data(); }
+	const float* getColors() const { return m_col.data(); }
+	const float* getSizes() const { return m_size.data(); }
+
+	// Share of flakes the last cull() dropped, 0 to 100.
+	float getCulledPercentage() const { return m_culledPercentage; }
+
+private:
+
+	int32_t m_count;
+	float m_culledPercentage;
+
+	// Grown to the flake count once and reused.
+	std::vector<float> m_pos;
+	std::vector<float> m_col;
+	std::vector<float> m_size;
+};
+
+}
+#endif // _GUILDHALL_FLAKE_CULLER_H_
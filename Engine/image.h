@@ -0,0 +1,36 @@
+#ifndef _GUILDHALL_IMAGE_H_
+#define _GUILDHALL_IMAGE_H_
+
+#include "types.h"
+
+#include <vector>
+
+namespace guildhall {
+
+// A decoded image, whatever format it was stored in.
+struct Image
+{
+	int32_t m_width;
+	int32_t m_height;
+
+	// RGBA texels (red in the lowest byte), bottom row first like
+	// glTexImage2D() takes them.
+	std::vector<uint32_t> m_texels;
+};
+
+// Asset interface of the engine, modelled on the iOS IResourceLoader: each
+// platform decodes images its own way (libpng on Android and the host,
+// UIKit on iOS) and hands the engine the same Image.
+class ImageLoader
+{
+public:
+
+	virtual ~ImageLoader() {}
+
+	// Decodes the image at pPath, relative to the application's resources.
+	// May be called from any thread.
+	virtual status load( const char* pPath, Image* pImage ) = 0;
+};
+
+}
+#endif // _GUILDHALL_IMAGE_H_
@@ -0,0 +1,117 @@
+#include "kernels.h"
+#include "cpu_features.h"
+#include "log.h"
+
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+
+namespace guildhall {
+
+namespace {
+
+const char* const KernelVariantNames[KERNEL_VARIANT_COUNT] = { "scalar", "sse2", "avx2", "neon" };
+
+// Most preferred first.
+const KernelVariant KernelVariantPreference[KERNEL_VARIANT_COUNT] =
+{
+	KERNEL_VARIANT_AVX2,
+	KERNEL_VARIANT_NEON,
+	KERNEL_VARIANT_SSE2,
+	KERNEL_VARIANT_SCALAR
+};
+
+std::atomic<const Kernels*> g_kernels( NULL );
+
+const Kernels* chooseKernels()
+{
+	const char* lOverride = getenv( "GUILDHALL_KERNELS" );
+
+	if( lOverride != NULL && lOverride[0] != '\0' )
+	{
+		const Kernels* lKernels = getKernelsForVariant( findKernelVariant( lOverride ) );
+
+		if( lKernels != NULL )
+			return lKernels;
+
+		Log::warn( "GUILDHALL_KERNELS=%s is not available here, picking the kernels by CPU.", lOverride );
+	}
+
+	for( int32_t i = 0; i < KERNEL_VARIANT_COUNT; ++i )
+	{
+		const Kernels* lKernels = getKernelsForVariant( KernelVariantPreference[i] );
+
+		if( lKernels != NULL )
+			return lKernels;
+	}
+
+	return getScalarKernels();
+}
+
+}
+
+const Kernels& getKernels()
+{
+	const Kernels* lKernels = g_kernels.load( std::memory_order_acquire );
+
+	// Threads that get here together all choose the same.
+	if( lKernels == NULL )
+	{
+		lKernels = chooseKernels();
+		g_kernels.store( lKernels, std::memory_order_release );
+	}
+
+	return *lKernels;
+}
+
+const Kernels* getKernelsForVariant( KernelVariant pVariant )
+{
+	uint32_t lFeatures = getCpuFeatures();
+
+	switch( pVariant )
+	{
+	case KERNEL_VARIANT_SCALAR:
+		return getScalarKernels();
+
+	case KERNEL_VARIANT_SSE2:
+		return ((lFeatures & CPU_FEATURE_SSE2) != 0) ? getSse2Kernels() : NULL;
+
+	case KERNEL_VARIANT_AVX2:
+		return ((lFeatures & CPU_FEATURE_AVX2) != 0) ? getAvx2Kernels() : NULL;
+
+	case KERNEL_VARIANT_NEON:
+		return ((lFeatures & CPU_FEATURE_NEON) != 0) ? getNeonKernels() : NULL;
+
+	default:
+		return NULL;
+	}
+}
+
+status selectKernelVariant( KernelVariant pVariant )
+{
+	const Kernels* lKernels = getKernelsForVariant( pVariant );
+
+	if( lKernels == NULL )
+		return STATUS_ERROR;
+
+	g_kernels.store( lKernels, std::memory_order_release );
+	return STATUS_OK;
+}
+
+const char* getKernelVariantName( KernelVariant pVariant )
+{
+	return (pVariant >= 0 && pVariant < KERNEL_VARIANT_COUNT) ? KernelVariantNames[pVariant] : "unknown";
+}
+
+KernelVariant findKernelVariant( const char* pName )
+{
+	for( int32_t i = 0; i < KERNEL_VARIANT_COUNT; ++i )
+	{
+		if( strcmp( pName, KernelVariantNames[i] ) == 0 )
+			return (KernelVariant) i;
+	}
+
+	return KERNEL_VARIANT_COUNT;
+}
+
+}
@@ -0,0 +1,83 @@
+#ifndef _GUILDHALL_KERNELS_H_
+#define _GUILDHALL_KERNELS_H_
+
+#include "block_snowflakes.h"
+#include "types.h"
+
+namespace guildhall {
+
+// The per flake and per pixel loops that dominate a frame, built several
+// times for different instruction sets and picked once at run time for
+// the CPU the game is on, so that one APK (or one Linux binary) gets NEON
+// where the core has it and AVX2 on x86 machines that do:
+//
+//     KERNEL_VARIANT_SCALAR   plain C++, on every target
+//     KERNEL_VARIANT_SSE2     x86 and x86_64
+//     KERNEL_VARIANT_AVX2     x86 and x86_64 with AVX2, eight lanes
+//     KERNEL_VARIANT_NEON     arm64-v8a, and armeabi-v7a cores with NEON
+//
+// The simulation and culling kernels give the same results, bit for bit,
+// in every variant. Blends may differ by one in a channel where a result
+// is exactly halfway, since SSE rounds those to even.
+//
+// Setting GUILDHALL_KERNELS to a variant's name (scalar, sse2, avx2 or
+// neon) in the environment overrides the choice, as does
+// selectKernelVariant(), for testing each path on one machine.
+
+enum KernelVariant
+{
+	KERNEL_VARIANT_SCALAR,
+	KERNEL_VARIANT_SSE2,
+	KERNEL_VARIANT_AVX2,
+	KERNEL_VARIANT_NEON,
+	KERNEL_VARIANT_COUNT
+};
+
+struct Kernels
+{
+	KernelVariant m_variant;
+
+	// BlockSnowFlakes::update() for whole blocks, as long as no flake in a
+	// block turns or respawns. Returns the index of the first block where
+	// one does, which is left as it was, or pBlockCount.
+	int32_t (*m_stepFlakeBlocks)( FlakeHotBlock* pBlocks, int32_t pBlockCount, float pElapsed );
+
+	// FlakeCuller::cull(): copies the flakes whose point sprites can touch
+	// the viewport into the output arrays, in order, and returns how many
+	// there were. pProjection is an Affine2f's six floats.
+	int32_t (*m_packVisibleFlakes)( const float* pPositions, const float* pColors, const float* pSizes,
+			int32_t pCount, const float* pProjection, int32_t pWidth, int32_t pHeight,
+			float* pOutPositions, float* pOutColors, float* pOutSizes );
+
+	// One row of a SoftwareRenderer sprite, pixels pX0 to pX1 - 1 of pRow:
+	// the texel under each pixel centre, modulated by pColor (0..1 over
+	// 255) and blended additively by its alpha.
+	void (*m_blendSpriteRow)( uint32_t* pRow, int32_t pX0, int32_t pX1, const uint32_t* pTexelRow,
+			int32_t pTextureWidth, float pSpriteX, float pInvSize, const float* pColor );
+};
+
+// The kernels in use: the best variant for the CPU, unless overridden.
+const Kernels& getKernels();
+
+// The kernels of one variant, or NULL if it is not built for this target
+// or the CPU lacks what it needs.
+const Kernels* getKernelsForVariant( KernelVariant pVariant );
+
+// Switches every later getKernels() to pVariant. Only safe while no other
+// thread is running kernels. STATUS_ERROR, changing nothing, if the
+// variant is not available.
+status selectKernelVariant( KernelVariant pVariant );
+
+const char* getKernelVariantName( KernelVariant pVariant );
+
+// KERNEL_VARIANT_COUNT if pName is not a variant's name.
+KernelVariant findKernelVariant( const char* pName );
+
+// The variant table of each kernels_*.cpp, NULL where it is not built.
+const Kernels* getScalarKernels();
+const Kernels* getSse2Kernels();
+const Kernels* getAvx2Kernels();
+const Kernels* getNeonKernels();
+
+}
+#endif // _GUILDHALL_KERNELS_H_
@@ -0,0 +1,214 @@
+#include "kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+// Written with AVX2 intrinsics directly, in functions marked for AVX2, so
+// that this file builds with the same flags as the rest of the engine and
+// nothing outside these functions can end up using AVX. FMA is left off:
+// the results match the other variants because every multiply and add is
+// rounded on its own, as theirs are.
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#define GUILDHALL_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace guildhall {
+
+#if GUILDHALL_KERNELS_AVX2
+
+#define GUILDHALL_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+
+namespace {
+
+GUILDHALL_TARGET_AVX2
+int32_t lessEqualMask( __m256 a, __m256 b )
+{
+	return _mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_LE_OQ ) );
+}
+
+GUILDHALL_TARGET_AVX2
+int32_t stepFlakeBlocksAvx2( FlakeHotBlock* pBlocks, int32_t pBlockCount, float pElapsed )
+{
+	const __m256 lElapsed = _mm256_set1_ps( pElapsed );
+	const __m256 lTimeTillTurn = _mm256_set1_ps( TimeTillTurn );
+	const __m256 lNormalizedUnit = _mm256_set1_ps( TimeTillTurnNormalizedUnit );
+	const __m256 lRespawnX = _mm256_set1_ps( ViewMaxX + 0.2f );
+	const __m256 lRespawnLeft = _mm256_set1_ps( -(ViewMaxX + 0.2f) );
+	const __m256 lRespawnBottom = _mm256_set1_ps( -(ViewMaxY + 0.2f) );
+
+	for( int32_t b = 0; b < pBlockCount; ++b )
+	{
+		FlakeHotBlock* lBlock = &pBlocks[b];
+		__m256 x[FlakeBlockSize / 8];
+		__m256 y[FlakeBlockSize / 8];
+		__m256 lTimer[FlakeBlockSize / 8];
+		int32_t lEvents = 0;
+
+		for( int32_t j = 0; j < FlakeBlockSize / 8; ++j )
+		{
+			lTimer[j] = _mm256_add_ps( _mm256_loadu_ps( &lBlock->timeSinceLastTurn[j * 8] ), lElapsed );
+
+			__m256 lModifier = _mm256_mul_ps( lTimer[j], lNormalizedUnit );
+			x[j] = _mm256_add_ps( _mm256_loadu_ps( &lBlock->x[j * 8] ),
+					_mm256_mul_ps( _mm256_loadu_ps( &lBlock->velX[j * 8] ), lModifier ) );
+			y[j] = _mm256_add_ps( _mm256_loadu_ps( &lBlock->y[j * 8] ), _mm256_loadu_ps( &lBlock->velY[j * 8] ) );
+
+			lEvents |= lessEqualMask( lTimeTillTurn, lTimer[j] ) |
+					lessEqualMask( y[j], lRespawnBottom ) |
+					lessEqualMask( x[j], lRespawnLeft ) |
+					lessEqualMask( lRespawnX, x[j] );
+		}
+
+		if( lEvents != 0 )
+			return b;
+
+		for( int32_t j = 0; j < FlakeBlockSize / 8; ++j )
+		{
+			_mm256_storeu_ps( &lBlock->x[j * 8], x[j] );
+			_mm256_storeu_ps( &lBlock->y[j * 8], y[j] );
+			_mm256_storeu_ps( &lBlock->timeSinceLastTurn[j * 8], lTimer[j] );
+		}
+	}
+
+	return pBlockCount;
+}
+
+inline void packFlake( const float* pPositions, const float* pColors, const float* pSizes, int32_t pIndex,
+		float* pOutPositions, float* pOutColors, float* pOutSizes, int32_t pOutIndex )
+{
+	pOutPositions[pOutIndex * 2 + 0] = pPositions[pIndex * 2 + 0];
+	pOutPositions[pOutIndex * 2 + 1] = pPositions[pIndex * 2 + 1];
+	memcpy( &pOutColors[pOutIndex * 4], &pColors[pIndex * 4], 4 * sizeof(float) );
+	pOutSizes[pOutIndex] = pSizes[pIndex];
+}
+
+GUILDHALL_TARGET_AVX2
+int32_t packVisibleFlakesAvx2( const float* pPositions, const float* pColors, const float* pSizes,
+		int32_t pCount, const float* pProjection, int32_t pWidth, int32_t pHeight,
+		float* pOutPositions, float* pOutColors, float* pOutSizes )
+{
+	const float* m = pProjection;
+	const float lInvWidth = 1.0f / pWidth;
+	const float lInvHeight = 1.0f / pHeight;
+	int32_t lVisibleCount = 0;
+
+	const __m256 lOne = _mm256_set1_ps( 1.0f );
+	const __m256 lInvWidth8 = _mm256_set1_ps( lInvWidth );
+	const __m256 lInvHeight8 = _mm256_set1_ps( lInvHeight );
+	const __m256 lSignBit = _mm256_set1_ps( -0.0f );
+	const __m256 m0 = _mm256_set1_ps( m[0] ), m1 = _mm256_set1_ps( m[1] );
+	const __m256 m2 = _mm256_set1_ps( m[2] ), m3 = _mm256_set1_ps( m[3] );
+	const __m256 m4 = _mm256_set1_ps( m[4] ), m5 = _mm256_set1_ps( m[5] );
+
+	int32_t i = 0;
+
+	for( ; i + 8 <= pCount; i += 8 )
+	{
+		// x0 y0 .. x3 y3 and x4 y4 .. x7 y7 to x0 .. x7 and y0 .. y7. The
+		// shuffle works within 128 bit halves, leaving 64 bit pairs to put
+		// back in order.
+		__m256 lLow = _mm256_loadu_ps( &pPositions[i * 2] );
+		__m256 lHigh = _mm256_loadu_ps( &pPositions[i * 2 + 8] );
+		__m256 x = _mm256_castpd_ps( _mm256_permute4x64_pd( _mm256_castps_pd(
+				_mm256_shuffle_ps( lLow, lHigh, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+		__m256 y = _mm256_castpd_ps( _mm256_permute4x64_pd( _mm256_castps_pd(
+				_mm256_shuffle_ps( lLow, lHigh, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+		__m256 lSize = _mm256_loadu_ps( &pSizes[i] );
+
+		__m256 lClipX = _mm256_andnot_ps( lSignBit,
+				_mm256_add_ps( _mm256_mul_ps( x, m0 ), _mm256_add_ps( _mm256_mul_ps( y, m2 ), m4 ) ) );
+		__m256 lClipY = _mm256_andnot_ps( lSignBit,
+				_mm256_add_ps( _mm256_mul_ps( x, m1 ), _mm256_add_ps( _mm256_mul_ps( y, m3 ), m5 ) ) );
+
+		int32_t lVisible = lessEqualMask( lClipX, _mm256_add_ps( _mm256_mul_ps( lSize, lInvWidth8 ), lOne ) ) &
+				lessEqualMask( lClipY, _mm256_add_ps( _mm256_mul_ps( lSize, lInvHeight8 ), lOne ) );
+
+		for( ; lVisible != 0; lVisible &= lVisible - 1 )
+		{
+			packFlake( pPositions, pColors, pSizes, i + __builtin_ctz( lVisible ),
+					pOutPositions, pOutColors, pOutSizes, lVisibleCount++ );
+		}
+	}
+
+	// The last few one at a time, summed and rounded as the loop above
+	// does them, so that none is culled differently for being among them.
+	for( ; i < pCount; ++i )
+	{
+		float x = pPositions[i * 2 + 0];
+		float y = pPositions[i * 2 + 1];
+		bool lVisible = fabsf( x * m[0] + (y * m[2] + m[4]) ) <= pSizes[i] * lInvWidth + 1.0f &&
+				fabsf( x * m[1] + (y * m[3] + m[5]) ) <= pSizes[i] * lInvHeight + 1.0f;
+
+		if( lVisible )
+			packFlake( pPositions, pColors, pSizes, i, pOutPositions, pOutColors, pOutSizes, lVisibleCount++ );
+	}
+
+	return lVisibleCount;
+}
+
+inline int32_t texelIndex( int32_t x, float pSpriteX, float pInvSize, int32_t pTextureWidth )
+{
+	float s = ((x + 0.5f) - pSpriteX) * pInvSize + 0.5f;
+	int32_t lTexelX = (int32_t) floorf( s * pTextureWidth );
+	return (lTexelX < 0) ? 0 : (lTexelX > pTextureWidth - 1) ? pTextureWidth - 1 : lTexelX;
+}
+
+// Two pixels at a time, one in each 128 bit half, with the same arithmetic
+// as the four lane kernels; an odd last pixel takes the lower half alone.
+GUILDHALL_TARGET_AVX2
+void blendSpriteRowAvx2( uint32_t* pRow, int32_t pX0, int32_t pX1, const uint32_t* pTexelRow,
+		int32_t pTextureWidth, float pSpriteX, float pInvSize, const float* pColor )
+{
+	const __m256 lOne = _mm256_set1_ps( 255.0f );
+	const __m256 lColor = _mm256_broadcast_ps( (const __m128*) pColor );
+
+	for( int32_t x = pX0; x < pX1; x += 2 )
+	{
+		bool lPair = (x + 1 < pX1);
+		uint32_t lTexel1 = lPair ? pTexelRow[texelIndex( x + 1, pSpriteX, pInvSize, pTextureWidth )] : 0;
+		uint32_t lDestination1 = lPair ? pRow[x + 1] : 0;
+
+		__m128i lTexels = _mm_setr_epi32( (int32_t) pTexelRow[texelIndex( x, pSpriteX, pInvSize, pTextureWidth )],
+				(int32_t) lTexel1, 0, 0 );
+		__m128i lDestinations = _mm_setr_epi32( (int32_t) pRow[x], (int32_t) lDestination1, 0, 0 );
+
+		// src = colour * texel, dst = src * src.a + dst.
+		__m256 lSource = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( lTexels ) ), lColor );
+		__m256 lResult = _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( lSource, lOne ),
+				_mm256_permute_ps( lSource, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ),
+				_mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( lDestinations ) ) );
+
+		__m256i lInt = _mm256_cvtps_epi32( _mm256_min_ps( lResult, lOne ) );
+		__m256i lShort = _mm256_packs_epi32( lInt, lInt );
+		__m256i lByte = _mm256_packus_epi16( lShort, lShort );
+
+		pRow[x] = (uint32_t) _mm_cvtsi128_si32( _mm256_castsi256_si128( lByte ) );
+
+		if( lPair )
+			pRow[x + 1] = (uint32_t) _mm_cvtsi128_si32( _mm256_extracti128_si256( lByte, 1 ) );
+	}
+}
+
+}
+
+#endif
+
+const Kernels* getAvx2Kernels()
+{
+#if GUILDHALL_KERNELS_AVX2
+	static const Kernels lKernels =
+	{
+		KERNEL_VARIANT_AVX2,
+		stepFlakeBlocksAvx2,
+		packVisibleFlakesAvx2,
+		blendSpriteRowAvx2
+	};
+
+	return &lKernels;
+#else
+	return NULL;
+#endif
+}
+
+}
@@ -0,0 +1,162 @@
+#ifndef _GUILDHALL_KERNELS_GENERIC_H_
+#define _GUILDHALL_KERNELS_GENERIC_H_
+
+#include "kernels.h"
+#include "simd.h"
+
+#include <math.h>
+
+namespace guildhall {
+
+// The kernels of kernels.h written once over simd.h's Float4, for the
+// kernels_*.cpp files that build the scalar, SSE2 and NEON variants. Each
+// of those picks what simd.h compiles to before including this, and the
+// functions here have internal linkage so that the variants do not clash.
+
+namespace {
+
+int32_t stepFlakeBlocksGeneric( FlakeHotBlock* pBlocks, int32_t pBlockCount, float pElapsed )
+{
+	const Float4 lElapsed = float4Splat( pElapsed );
+	const Float4 lTimeTillTurn = float4Splat( TimeTillTurn );
+	const Float4 lNormalizedUnit = float4Splat( TimeTillTurnNormalizedUnit );
+	const Float4 lRespawnX = float4Splat( ViewMaxX + 0.2f );
+	const Float4 lRespawnLeft = float4Splat( -(ViewMaxX + 0.2f) );
+	const Float4 lRespawnBottom = float4Splat( -(ViewMaxY + 0.2f) );
+
+	for( int32_t b = 0; b < pBlockCount; ++b )
+	{
+		FlakeHotBlock* lBlock = &pBlocks[b];
+		Float4 x[FlakeBlockSize / 4];
+		Float4 y[FlakeBlockSize / 4];
+		Float4 lTimer[FlakeBlockSize / 4];
+		int32_t lEvents = 0;
+
+		for( int32_t j = 0; j < FlakeBlockSize / 4; ++j )
+		{
+			lTimer[j] = float4Add( float4Load( &lBlock->timeSinceLastTurn[j * 4] ), lElapsed );
+
+			Float4 lModifier = float4Mul( lTimer[j], lNormalizedUnit );
+			x[j] = float4Add( float4Load( &lBlock->x[j * 4] ), float4Mul( float4Load( &lBlock->velX[j * 4] ), lModifier ) );
+			y[j] = float4Add( float4Load( &lBlock->y[j * 4] ), float4Load( &lBlock->velY[j * 4] ) );
+
+			// The respawn tests also catch flakes exactly on the bounds,
+			// which the scalar step then leaves alone.
+			lEvents |= float4LessEqualMask( lTimeTillTurn, lTimer[j] ) |
+					float4LessEqualMask( y[j], lRespawnBottom ) |
+					float4LessEqualMask( x[j], lRespawnLeft ) |
+					float4LessEqualMask( lRespawnX, x[j] );
+		}
+
+		if( lEvents != 0 )
+			return b;
+
+		for( int32_t j = 0; j < FlakeBlockSize / 4; ++j )
+		{
+			float4Store( &lBlock->x[j * 4], x[j] );
+			float4Store( &lBlock->y[j * 4], y[j] );
+			float4Store( &lBlock->timeSinceLastTurn[j * 4], lTimer[j] );
+		}
+	}
+
+	return pBlockCount;
+}
+
+inline void packFlake( const float* pPositions, const float* pColors, const float* pSizes, int32_t pIndex,
+		float* pOutPositions, float* pOutColors, float* pOutSizes, int32_t pOutIndex )
+{
+	pOutPositions[pOutIndex * 2 + 0] = pPositions[pIndex * 2 + 0];
+	pOutPositions[pOutIndex * 2 + 1] = pPositions[pIndex * 2 + 1];
+	pOutColors[pOutIndex * 4 + 0] = pColors[pIndex * 4 + 0];
+	pOutColors[pOutIndex * 4 + 1] = pColors[pIndex * 4 + 1];
+	pOutColors[pOutIndex * 4 + 2] = pColors[pIndex * 4 + 2];
+	pOutColors[pOutIndex * 4 + 3] = pColors[pIndex * 4 + 3];
+	pOutSizes[pOutIndex] = pSizes[pIndex];
+}
+
+int32_t packVisibleFlakesGeneric( const float* pPositions, const float* pColors, const float* pSizes,
+		int32_t pCount, const float* pProjection, int32_t pWidth, int32_t pHeight,
+		float* pOutPositions, float* pOutColors, float* pOutSizes )
+{
+	const float* m = pProjection;
+	int32_t lVisibleCount = 0;
+
+	// In clip space the viewport spans -1 to 1, and a point of size s
+	// pixels reaches s / width further out horizontally (s / height
+	// vertically). A flake is visible when |clip| <= 1 + s / dimension.
+	const Float4 lOne = float4Splat( 1.0f );
+	const Float4 lInvWidth = float4Splat( 1.0f / pWidth );
+	const Float4 lInvHeight = float4Splat( 1.0f / pHeight );
+	const Float4 m0 = float4Splat( m[0] ), m1 = float4Splat( m[1] );
+	const Float4 m2 = float4Splat( m[2] ), m3 = float4Splat( m[3] );
+	const Float4 m4 = float4Splat( m[4] ), m5 = float4Splat( m[5] );
+
+	int32_t i = 0;
+
+	for( ; i + 4 <= pCount; i += 4 )
+	{
+		Float4 x, y;
+		float4LoadXY( &pPositions[i * 2], &x, &y );
+		Float4 lSize = float4Load( &pSizes[i] );
+
+		Float4 lClipX = float4Abs( float4Madd( x, m0, float4Madd( y, m2, m4 ) ) );
+		Float4 lClipY = float4Abs( float4Madd( x, m1, float4Madd( y, m3, m5 ) ) );
+
+		int32_t lVisible = float4LessEqualMask( lClipX, float4Madd( lSize, lInvWidth, lOne ) ) &
+				float4LessEqualMask( lClipY, float4Madd( lSize, lInvHeight, lOne ) );
+
+		// One bit per visible flake, lowest first.
+		for( ; lVisible != 0; lVisible &= lVisible - 1 )
+		{
+			packFlake( pPositions, pColors, pSizes, i + __builtin_ctz( lVisible ),
+					pOutPositions, pOutColors, pOutSizes, lVisibleCount++ );
+		}
+	}
+
+	// The same operations in the same order as the loop above, so that a
+	// flake on the edge is kept or dropped wherever it falls in the array.
+	const float lInvWidthScalar = 1.0f / pWidth;
+	const float lInvHeightScalar = 1.0f / pHeight;
+
+	for( ; i < pCount; ++i )
+	{
+		float x = pPositions[i * 2 + 0];
+		float y = pPositions[i * 2 + 1];
+
+		if( fabsf( x * m[0] + (y * m[2] + m[4]) ) <= pSizes[i] * lInvWidthScalar + 1.0f &&
+			fabsf( x * m[1] + (y * m[3] + m[5]) ) <= pSizes[i] * lInvHeightScalar + 1.0f )
+			packFlake( pPositions, pColors, pSizes, i, pOutPositions, pOutColors, pOutSizes, lVisibleCount++ );
+	}
+
+	return lVisibleCount;
+}
+
+inline int32_t clampTexel( int32_t pValue, int32_t pMax )
+{
+	return (pValue < 0) ? 0 : (pValue > pMax) ? pMax : pValue;
+}
+
+void blendSpriteRowGeneric( uint32_t* pRow, int32_t pX0, int32_t pX1, const uint32_t* pTexelRow,
+		int32_t pTextureWidth, float pSpriteX, float pInvSize, const float* pColor )
+{
+	const Float4 lOne = float4Splat( 255.0f );
+	const Float4 lColor = float4Load( pColor );
+
+	for( int32_t x = pX0; x < pX1; ++x )
+	{
+		float s = ((x + 0.5f) - pSpriteX) * pInvSize + 0.5f;
+		int32_t lTexelX = clampTexel( (int32_t) floorf( s * pTextureWidth ), pTextureWidth - 1 );
+
+		// src = colour * texel, dst = src * src.a + dst.
+		Float4 lSource = float4Mul( float4FromRgba8( pTexelRow[lTexelX] ), lColor );
+		Float4 lResult = float4Madd( float4Mul( lSource, lOne ), float4Lane<3>( lSource ),
+				float4FromRgba8( pRow[x] ) );
+
+		pRow[x] = float4ToRgba8( float4Min( lResult, lOne ) );
+	}
+}
+
+}
+
+}
+#endif // _GUILDHALL_KERNELS_GENERIC_H_
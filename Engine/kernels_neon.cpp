@@ -0,0 +1,29 @@
+#include "kernels.h"
+#include "simd.h"
+
+// On armeabi-v7a the engine is built without NEON and Android.mk builds
+// just this file with it, as kernels_neon.cpp.neon.
+#if GUILDHALL_SIMD_NEON
+#include "kernels_generic.h"
+#endif
+
+namespace guildhall {
+
+const Kernels* getNeonKernels()
+{
+#if GUILDHALL_SIMD_NEON
+	static const Kernels lKernels =
+	{
+		KERNEL_VARIANT_NEON,
+		stepFlakeBlocksGeneric,
+		packVisibleFlakesGeneric,
+		blendSpriteRowGeneric
+	};
+
+	return &lKernels;
+#else
+	return NULL;
+#endif
+}
+
+}
@@ -0,0 +1,21 @@
+// Plain C++ whatever the target, see simd.h.
+#define GUILDHALL_SIMD_FORCE_SCALAR 1
+
+#include "kernels_generic.h"
+
+namespace guildhall {
+
+const Kernels* getScalarKernels()
+{
+	static const Kernels lKernels =
+	{
+		KERNEL_VARIANT_SCALAR,
+		stepFlakeBlocksGeneric,
+		packVisibleFlakesGeneric,
+		blendSpriteRowGeneric
+	};
+
+	return &lKernels;
+}
+
+}
@@ -0,0 +1,27 @@
+#include "kernels.h"
+#include "simd.h"
+
+#if GUILDHALL_SIMD_SSE
+#include "kernels_generic.h"
+#endif
+
+namespace guildhall {
+
+const Kernels* getSse2Kernels()
+{
+#if GUILDHALL_SIMD_SSE
+	static const Kernels lKernels =
+	{
+		KERNEL_VARIANT_SSE2,
+		stepFlakeBlocksGeneric,
+		packVisibleFlakesGeneric,
+		blendSpriteRowGeneric
+	};
+
+	return &lKernels;
+#else
+	return NULL;
+#endif
+}
+
+}
@@ -1,7 +1,23 @@
 #include "log.h"
 
 #include <stdarg.h>
+
+#ifdef __ANDROID__
 #include <android/log.h>
+#else
+#include <stdio.h>
+
+// iOS and host builds have no logcat, so route everything to the console
+// in the same "priority/tag" layout adb prints.
+#define ANDROID_LOG_DEBUG "D"
+#define ANDROID_LOG_INFO "I"
+#define ANDROID_LOG_WARN "W"
+#define ANDROID_LOG_ERROR "E"
+#define __android_log_vprint( pPriority, pTag, pMessage, pVarArgs ) \
+	( fprintf( stderr, "%s/%s: ", pPriority, pTag ), vfprintf( stderr, pMessage, pVarArgs ) )
+#define __android_log_print( pPriority, pTag, pMessage ) \
+	fprintf( stderr, pMessage )
+#endif
 
 namespace guildhall {
 
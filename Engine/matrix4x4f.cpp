@@ -0,0 +1,204 @@
+#include "matrix4x4f.h"
+#include "simd.h"
+
+namespace guildhall {
+
+#if !GUILDHALL_SIMD_SCALAR
+
+namespace {
+
+// Lanes ( a, a, b, c ) of the 2x2 determinants of rows pI and pJ taken
+// from columns 2 and 3 (a), 1 and 3 (b), and 1 and 2 (c).
+template<int pI, int pJ>
+inline Float4 subDeterminants( Float4 c1, Float4 c2, Float4 c3 )
+{
+    Float4 lA = float4Shuffle<pI, pI, pI, pI>( c2, c1 );
+    Float4 lB = float4Swizzle<0, 0, 0, 2>( float4Shuffle<pJ, pJ, pJ, pJ>( c3, c2 ) );
+    Float4 lC = float4Swizzle<0, 0, 0, 2>( float4Shuffle<pI, pI, pI, pI>( c3, c2 ) );
+    Float4 lD = float4Shuffle<pJ, pJ, pJ, pJ>( c2, c1 );
+
+    return float4Sub( float4Mul( lA, lB ), float4Mul( lC, lD ) );
+}
+
+// Lanes ( m[1][pK], m[0][pK], m[0][pK], m[0][pK] ), by column and row.
+template<int pK>
+inline Float4 leadingRow( Float4 c0, Float4 c1 )
+{
+    return float4Swizzle<0, 2, 2, 2>( float4Shuffle<pK, pK, pK, pK>( c1, c0 ) );
+}
+
+// Of the x, y and z lanes. The w lane is a.w * b.w - a.w * b.w.
+inline Float4 cross3( Float4 a, Float4 b )
+{
+    return float4Sub( float4Mul( float4Swizzle<1, 2, 0, 3>( a ), float4Swizzle<2, 0, 1, 3>( b ) ),
+                      float4Mul( float4Swizzle<2, 0, 1, 3>( a ), float4Swizzle<1, 2, 0, 3>( b ) ) );
+}
+
+}
+
+#endif
+
+template<>
+Matrix4x4f Matrix4x4f::operator * ( const Matrix4x4f &other ) const noexcept
+{
+#if GUILDHALL_SIMD_SCALAR
+    return multiplyReference( this, &other );
+#else
+    Matrix4x4f result;
+
+    Float4 c0 = float4Load( &m[0] );
+    Float4 c1 = float4Load( &m[4] );
+    Float4 c2 = float4Load( &m[8] );
+    Float4 c3 = float4Load( &m[12] );
+
+    // Each column of the result is a mix of our columns. Summed in the
+    // same order as the reference, so SSE matches it bit for bit.
+    for( int i = 0; i < 16; i += 4 )
+    {
+        Float4 b = float4Load( &other.m[i] );
+        Float4 column = float4Mul( c0, float4Lane<0>( b ) );
+        column = float4Madd( c1, float4Lane<1>( b ), column );
+        column = float4Madd( c2, float4Lane<2>( b ), column );
+        column = float4Madd( c3, float4Lane<3>( b ), column );
+        float4Store( &result.m[i], column );
+    }
+
+    return result;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Name: invertMatrix()
+// Desc: Inverts a general 4x4 matrix from its cofactors, four at a time.
+//       The same math as GLM's SSE path, for SSE and NEON alike.
+//-----------------------------------------------------------------------------
+template<>
+Matrix4x4f Matrix4x4f::invertMatrix( const Matrix4x4f *matIn ) noexcept
+{
+#if GUILDHALL_SIMD_SCALAR
+    return invertMatrixReference( matIn );
+#else
+    Float4 c0 = float4Load( &matIn->m[0] );
+    Float4 c1 = float4Load( &matIn->m[4] );
+    Float4 c2 = float4Load( &matIn->m[8] );
+    Float4 c3 = float4Load( &matIn->m[12] );
+
+    Float4 fac0 = subDeterminants<2, 3>( c1, c2, c3 );
+    Float4 fac1 = subDeterminants<1, 3>( c1, c2, c3 );
+    Float4 fac2 = subDeterminants<1, 2>( c1, c2, c3 );
+    Float4 fac3 = subDeterminants<0, 3>( c1, c2, c3 );
+    Float4 fac4 = subDeterminants<0, 2>( c1, c2, c3 );
+    Float4 fac5 = subDeterminants<0, 1>( c1, c2, c3 );
+
+    Float4 vec0 = leadingRow<0>( c0, c1 );
+    Float4 vec1 = leadingRow<1>( c0, c1 );
+    Float4 vec2 = leadingRow<2>( c0, c1 );
+    Float4 vec3 = leadingRow<3>( c0, c1 );
+
+    Float4 signA = float4Set( 1.0f, -1.0f, 1.0f, -1.0f );
+    Float4 signB = float4Set( -1.0f, 1.0f, -1.0f, 1.0f );
+
+    // Columns of the adjugate.
+    Float4 inv0 = float4Mul( signA, float4Add( float4Sub( float4Mul( vec1, fac0 ), float4Mul( vec2, fac1 ) ), float4Mul( vec3, fac2 ) ) );
+    Float4 inv1 = float4Mul( signB, float4Add( float4Sub( float4Mul( vec0, fac0 ), float4Mul( vec2, fac3 ) ), float4Mul( vec3, fac4 ) ) );
+    Float4 inv2 = float4Mul( signA, float4Add( float4Sub( float4Mul( vec0, fac1 ), float4Mul( vec1, fac3 ) ), float4Mul( vec3, fac5 ) ) );
+    Float4 inv3 = float4Mul( signB, float4Add( float4Sub( float4Mul( vec0, fac2 ), float4Mul( vec1, fac4 ) ), float4Mul( vec2, fac5 ) ) );
+
+    // The first row of the adjugate against the first column gives the
+    // determinant.
+    Float4 row0 = float4Shuffle<0, 2, 0, 2>( float4Shuffle<0, 0, 0, 0>( inv0, inv1 ), float4Shuffle<0, 0, 0, 0>( inv2, inv3 ) );
+    float dot[4];
+    float4Store( dot, float4Mul( c0, row0 ) );
+
+    float det = (dot[0] + dot[1]) + (dot[2] + dot[3]);
+
+    Matrix4x4f result;
+
+    if( det == 0.0f )
+        return result;
+
+    Float4 invDet = float4Splat( 1.0f / det );
+
+    float4Store( &result.m[0], float4Mul( inv0, invDet ) );
+    float4Store( &result.m[4], float4Mul( inv1, invDet ) );
+    float4Store( &result.m[8], float4Mul( inv2, invDet ) );
+    float4Store( &result.m[12], float4Mul( inv3, invDet ) );
+
+    return result;
+#endif
+}
+
+template<>
+Matrix4x4f Matrix4x4f::invertAffine( const Matrix4x4f *matIn ) noexcept
+{
+#if GUILDHALL_SIMD_SCALAR
+    return invertAffineReference( matIn );
+#else
+    Float4 c0 = float4Load( &matIn->m[0] );
+    Float4 c1 = float4Load( &matIn->m[4] );
+    Float4 c2 = float4Load( &matIn->m[8] );
+    Float4 c3 = float4Load( &matIn->m[12] );
+
+    // The rows of the inverse of the upper 3x3 are the cross products of
+    // its columns, over its determinant.
+    Float4 r0 = cross3( c1, c2 );
+    Float4 r1 = cross3( c2, c0 );
+    Float4 r2 = cross3( c0, c1 );
+
+    float dot[4];
+    float4Store( dot, float4Mul( c0, r0 ) );
+
+    float det = dot[0] + dot[1] + dot[2];
+
+    Matrix4x4f result;
+
+    if( det == 0.0f )
+        return result;
+
+    Float4 invDet = float4Splat( 1.0f / det );
+    Float4 r3 = float4Splat( 0.0f );
+
+    r0 = float4Mul( r0, invDet );
+    r1 = float4Mul( r1, invDet );
+    r2 = float4Mul( r2, invDet );
+    float4Transpose( &r0, &r1, &r2, &r3 );
+
+    // The translation, moved back by the inverse.
+    Float4 translation = float4Mul( r0, float4Lane<0>( c3 ) );
+    translation = float4Madd( r1, float4Lane<1>( c3 ), translation );
+    translation = float4Madd( r2, float4Lane<2>( c3 ), translation );
+
+    float4Store( &result.m[0], r0 );
+    float4Store( &result.m[4], r1 );
+    float4Store( &result.m[8], r2 );
+    float4Store( &result.m[12], float4Sub( float4Set( 0.0f, 0.0f, 0.0f, 1.0f ), translation ) );
+
+    return result;
+#endif
+}
+
+template<>
+Matrix4x4f Matrix4x4f::transpose( const Matrix4x4f *matIn ) noexcept
+{
+#if GUILDHALL_SIMD_SCALAR
+    return transposeReference( matIn );
+#else
+    Matrix4x4f result;
+
+    Float4 c0 = float4Load( &matIn->m[0] );
+    Float4 c1 = float4Load( &matIn->m[4] );
+    Float4 c2 = float4Load( &matIn->m[8] );
+    Float4 c3 = float4Load( &matIn->m[12] );
+
+    float4Transpose( &c0, &c1, &c2, &c3 );
+
+    float4Store( &result.m[0], c0 );
+    float4Store( &result.m[4], c1 );
+    float4Store( &result.m[8], c2 );
+    float4Store( &result.m[12], c3 );
+
+    return result;
+#endif
+}
+
+}
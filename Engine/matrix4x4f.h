@@ -0,0 +1,19 @@
+//-----------------------------------------------------------------------------
+//           Name: matrix4x4f.h
+//         Author: Kevin Harris
+//  Last Modified: 06/04/12
+//    Description: OpenGL compatible utility class for a 4x4 matrix of floats.
+//                 Matrix4x4f is now Mat4<float>, which vecmath.h defines.
+//                 Multiplication, inversion and transposition use SSE or
+//                 NEON where simd.h finds them (see matrix4x4f.cpp). The
+//                 readable scalar versions are kept as the constexpr
+//                 *Reference() methods, which the SIMD ones are checked
+//                 against (see micro_bench).
+//-----------------------------------------------------------------------------
+
+#ifndef _GUILDHALL_MATRIX4X4F_H_
+#define _GUILDHALL_MATRIX4X4F_H_
+
+#include "vecmath.h"
+
+#endif // _GUILDHALL_MATRIX4X4F_H_
@@ -0,0 +1,137 @@
+#include "memory_tracker.h"
+#include "log.h"
+
+#include <atomic>
+#include <stdlib.h>
+
+namespace guildhall {
+
+namespace {
+
+const char* const MemoryCategoryNames[MEMORY_CATEGORY_COUNT] =
+{
+	"simulation",
+	"textures",
+	"shaders",
+	"frame",
+	"level"
+};
+
+// In front of every allocation. Padded so that what follows keeps
+// malloc()'s alignment.
+union AllocationHeader
+{
+	struct
+	{
+		size_t m_bytes;
+		int32_t m_category;
+	} m_info;
+
+	max_align_t m_alignment;
+};
+
+struct CategoryCounters
+{
+	std::atomic<uint64_t> m_bytes;
+	std::atomic<uint64_t> m_highWater;
+	std::atomic<uint64_t> m_allocations;
+};
+
+CategoryCounters g_counters[MEMORY_CATEGORY_COUNT];
+std::atomic<AllocationHook> g_hook( NULL );
+
+void raiseHighWater( CategoryCounters* pCounters, uint64_t pBytes )
+{
+	uint64_t lHighWater = pCounters->m_highWater.load( std::memory_order_relaxed );
+
+	while( pBytes > lHighWater &&
+			!pCounters->m_highWater.compare_exchange_weak( lHighWater, pBytes, std::memory_order_relaxed ) )
+	{
+	}
+}
+
+}
+
+void* allocateMemory( MemoryCategory pCategory, size_t pBytes )
+{
+	AllocationHook lHook = g_hook.load( std::memory_order_acquire );
+
+	if( lHook != NULL )
+		lHook( pCategory, pBytes );
+
+	AllocationHeader* lHeader = (AllocationHeader*) malloc( sizeof(AllocationHeader) + pBytes );
+
+	if( lHeader == NULL )
+		return NULL;
+
+	lHeader->m_info.m_bytes = pBytes;
+	lHeader->m_info.m_category = pCategory;
+
+	CategoryCounters& lCounters = g_counters[pCategory];
+	uint64_t lInUse = lCounters.m_bytes.fetch_add( pBytes, std::memory_order_relaxed ) + pBytes;
+	lCounters.m_allocations.fetch_add( 1, std::memory_order_relaxed );
+	raiseHighWater( &lCounters, lInUse );
+
+	return lHeader + 1;
+}
+
+void freeMemory( void* pMemory )
+{
+	if( pMemory == NULL )
+		return;
+
+	AllocationHeader* lHeader = (AllocationHeader*) pMemory - 1;
+	g_counters[lHeader->m_info.m_category].m_bytes.fetch_sub( lHeader->m_info.m_bytes, std::memory_order_relaxed );
+
+	free( lHeader );
+}
+
+void getMemoryStats( MemoryCategory pCategory, MemoryStats* pStats )
+{
+	const CategoryCounters& lCounters = g_counters[pCategory];
+
+	pStats->m_bytes = lCounters.m_bytes.load( std::memory_order_relaxed );
+	pStats->m_highWater = lCounters.m_highWater.load( std::memory_order_relaxed );
+	pStats->m_allocations = lCounters.m_allocations.load( std::memory_order_relaxed );
+}
+
+uint64_t getAllocationCount()
+{
+	uint64_t lCount = 0;
+
+	for( int32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i )
+		lCount += g_counters[i].m_allocations.load( std::memory_order_relaxed );
+
+	return lCount;
+}
+
+void resetMemoryHighWater()
+{
+	for( int32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i )
+		g_counters[i].m_highWater.store( g_counters[i].m_bytes.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+}
+
+const char* getMemoryCategoryName( MemoryCategory pCategory )
+{
+	return (pCategory >= 0 && pCategory < MEMORY_CATEGORY_COUNT) ? MemoryCategoryNames[pCategory] : "unknown";
+}
+
+void logMemoryStats()
+{
+	for( int32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i )
+	{
+		MemoryStats lStats;
+		getMemoryStats( (MemoryCategory) i, &lStats );
+
+		Log::info( "Memory %-10s %10llu bytes in use, %10llu at most, %8llu allocations",
+				MemoryCategoryNames[i], (unsigned long long) lStats.m_bytes,
+				(unsigned long long) lStats.m_highWater, (unsigned long long) lStats.m_allocations );
+	}
+}
+
+void setAllocationHook( AllocationHook pHook )
+{
+	g_hook.store( pHook, std::memory_order_release );
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef _GUILDHALL_MEMORY_TRACKER_H_
+#define _GUILDHALL_MEMORY_TRACKER_H_
+
+#include "types.h"
+
+#include <stddef.h>
+
+namespace guildhall {
+
+// Heap memory the engine allocates, counted per category: the bytes in use,
+// the most ever in use at once, and the number of allocations made. The
+// engine's own buffers, the blocks of every Arena and the textures' pixels
+// come from allocateMemory(), so getMemoryStats() shows where the memory
+// went. Per-frame work takes its memory from a frame Arena and engine
+// objects come from a Pool, so once the first frames have grown those,
+// frames make no allocations here; an allocation hook can fail a run that
+// does (see the headless tool's --check-allocations).
+//
+// Containers of the standard library still use the global heap and are
+// not counted.
+
+enum MemoryCategory
+{
+	MEMORY_CATEGORY_SIMULATION,   // Flake state and snapshots.
+	MEMORY_CATEGORY_TEXTURES,     // Decoded pixels and decode buffers.
+	MEMORY_CATEGORY_SHADERS,      // Compile and link logs.
+	MEMORY_CATEGORY_FRAME,        // Frame arenas.
+	MEMORY_CATEGORY_LEVEL,        // Level arenas.
+	MEMORY_CATEGORY_COUNT
+};
+
+struct MemoryStats
+{
+	uint64_t m_bytes;         // In use.
+	uint64_t m_highWater;     // The most in use at once.
+	uint64_t m_allocations;   // Made so far.
+};
+
+// Called on the allocating thread for every allocateMemory(), before the
+// memory is taken.
+typedef void (*AllocationHook)( MemoryCategory pCategory, size_t pBytes );
+
+// Aligned for any type, like malloc(). NULL if there is not enough memory.
+// Only freeMemory() may release it.
+void* allocateMemory( MemoryCategory pCategory, size_t pBytes );
+
+// NULL is ignored.
+void freeMemory( void* pMemory );
+
+// Arrays of types that need no constructor.
+template<typename T>
+T* allocateArray( MemoryCategory pCategory, int32_t pCount )
+{
+	return (T*) allocateMemory( pCategory, pCount * sizeof(T) );
+}
+
+void getMemoryStats( MemoryCategory pCategory, MemoryStats* pStats );
+
+// Every category's allocations so far.
+uint64_t getAllocationCount();
+
+// Brings every high-water mark down to what is in use now.
+void resetMemoryHighWater();
+
+const char* getMemoryCategoryName( MemoryCategory pCategory );
+
+// One line per category through Log::info().
+void logMemoryStats();
+
+// NULL removes the hook.
+void setAllocationHook( AllocationHook pHook );
+
+}
+#endif // _GUILDHALL_MEMORY_TRACKER_H_
@@ -0,0 +1,342 @@
+#ifndef _GUILDHALL_PARTICLE_SYSTEM_H_
+#define _GUILDHALL_PARTICLE_SYSTEM_H_
+
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "random.h"
+#include "snowflakes.h"
+#include "types.h"
+
+namespace guildhall {
+
+// A particle simulation put together at compile time from the behaviours
+// it uses:
+//
+//     ParticleSystem<DynamicCapacity, SwayFeature, FallFeature, RespawnFeature>
+//
+// is SnowFlakes (same spawn, same update, same flakes bit for bit), and
+// adding WindFeature, NoiseFeature or FadeFeature to the list adds that
+// behaviour to the loop. Each feature's update() is inlined into the one
+// loop over the particles in the order the features are listed, so a
+// configuration has no branches or calls for the features it leaves out,
+// and features without parameters take no space (see micro_bench's
+// particles benchmarks).
+//
+// With a Capacity other than DynamicCapacity the state is arrays of
+// exactly that many particles inside the object, and the loop count is a
+// constant; such systems are large, so they want to be static or on the
+// heap rather than on the stack. With DynamicCapacity the count is given
+// to the constructor and the arrays are allocated.
+//
+// A feature is a class with
+//
+//     void begin( float pElapsed );
+//     void update( const ParticleArrays& pArrays, int32_t pIndex, float pElapsed, Random& pRandom );
+//
+// begin() runs once per update, before the loop, for anything that does
+// not depend on the particle. Features that draw random numbers share the
+// system's generator, so their order in the list is part of the result.
+// getFeature<F>() reaches a feature's parameters.
+
+const int32_t DynamicCapacity = 0;
+
+// The state, in SnowFlakes' layout so that renderers take it as it is.
+struct ParticleArrays
+{
+	float* m_pos;   // x, y
+	float* m_vel;   // x, y
+	float* m_col;   // r, g, b, a
+	float* m_size;
+	float* m_timeSinceLastTurn;
+};
+
+template<int32_t Capacity>
+class ParticleStorage
+{
+public:
+
+	int32_t getCount() const { return Capacity; }
+
+protected:
+
+	ParticleArrays getArrays()
+	{
+		ParticleArrays lArrays = { m_pos, m_vel, m_col, m_size, m_timeSinceLastTurn };
+		return lArrays;
+	}
+
+	float m_pos[Capacity * 2];
+	float m_vel[Capacity * 2];
+	float m_col[Capacity * 4];
+	float m_size[Capacity];
+	float m_timeSinceLastTurn[Capacity];
+};
+
+template<>
+class ParticleStorage<DynamicCapacity>
+{
+public:
+
+	ParticleStorage( int32_t pCount ) :
+			m_count( pCount ),
+			m_pos( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 2 ) ),
+			m_vel( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 2 ) ),
+			m_col( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 4 ) ),
+			m_size( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+			m_timeSinceLastTurn( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount ) )
+	{
+	}
+
+	~ParticleStorage()
+	{
+		freeMemory( m_pos );
+		freeMemory( m_vel );
+		freeMemory( m_col );
+		freeMemory( m_size );
+		freeMemory( m_timeSinceLastTurn );
+	}
+
+	int32_t getCount() const { return m_count; }
+
+protected:
+
+	ParticleArrays getArrays()
+	{
+		ParticleArrays lArrays = { m_pos, m_vel, m_col, m_size, m_timeSinceLastTurn };
+		return lArrays;
+	}
+
+	int32_t m_count;
+
+	float* m_pos;
+	float* m_vel;
+	float* m_col;
+	float* m_size;
+	float* m_timeSinceLastTurn;
+
+private:
+
+	ParticleStorage( const ParticleStorage& );
+	ParticleStorage& operator = ( const ParticleStorage& );
+};
+
+template<int32_t Capacity, typename... Features>
+class ParticleSystem : public ParticleStorage<Capacity>, private Features...
+{
+public:
+
+	// For a fixed Capacity.
+	ParticleSystem()
+	{
+		static_assert( Capacity != DynamicCapacity, "A DynamicCapacity system needs its count" );
+	}
+
+	// For DynamicCapacity.
+	explicit ParticleSystem( int32_t pCount ) :
+			ParticleStorage<Capacity>( pCount )
+	{
+	}
+
+	// The same flakes SnowFlakes::spawn() makes from pSeed.
+	void spawn( uint32_t pSeed )
+	{
+		ParticleArrays lArrays = this->getArrays();
+		m_random.seed( pSeed );
+
+		for( int32_t i = 0; i < this->getCount(); ++i )
+		{
+			lArrays.m_pos[i * 2 + 0] = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+			lArrays.m_pos[i * 2 + 1] = m_random.nextFloat( -ViewMaxY, ViewMaxY );
+
+			lArrays.m_vel[i * 2 + 0] = m_random.nextFloat( -0.004f, 0.004f );
+			lArrays.m_vel[i * 2 + 1] = m_random.nextFloat( -0.01f, -0.008f );
+
+			lArrays.m_col[i * 4 + 0] = 1.0f;
+			lArrays.m_col[i * 4 + 1] = 1.0f;
+			lArrays.m_col[i * 4 + 2] = 1.0f;
+			lArrays.m_col[i * 4 + 3] = 1.0f;
+
+			lArrays.m_size[i] = m_random.nextFloat( 3.0, 6.0f );
+			lArrays.m_timeSinceLastTurn[i] = m_random.nextFloat( -5.0, 0.0f );
+		}
+	}
+
+	void update( float pElapsed )
+	{
+		GUILDHALL_PROFILE_ZONE( "ParticleSystem::update" );
+
+		ParticleArrays lArrays = this->getArrays();
+		int32_t lCount = this->getCount();
+
+		// Each pack expansion calls one function per feature, left to
+		// right; the leading 0 keeps the array valid with no features.
+		int32_t lBegin[] = { 0, (static_cast<Features&>( *this ).begin( pElapsed ), 0)... };
+		(void) lBegin;
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			int32_t lUpdate[] = { 0, (static_cast<Features&>( *this ).update( lArrays, i, pElapsed, m_random ), 0)... };
+			(void) lUpdate;
+		}
+	}
+
+	template<typename Feature>
+	Feature& getFeature() { return *this; }
+
+	template<typename Feature>
+	const Feature& getFeature() const { return *this; }
+
+	const float* getPositions() const { return this->m_pos; }
+	const float* getVelocities() const { return this->m_vel; }
+	const float* getColors() const { return this->m_col; }
+	const float* getSizes() const { return this->m_size; }
+	const float* getTurnTimers() const { return this->m_timeSinceLastTurn; }
+
+private:
+
+	Random m_random;
+};
+
+//
+// Features...
+//
+
+// SnowFlakes' side to side motion: the horizontal velocity reverses every
+// TimeTillTurn seconds, after a random wait, and is scaled by the time
+// since the last turn.
+class SwayFeature
+{
+public:
+
+	void begin( float ) {}
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float pElapsed, Random& pRandom )
+	{
+		float& lTimer = pArrays.m_timeSinceLastTurn[pIndex];
+		lTimer += pElapsed;
+
+		if( lTimer >= TimeTillTurn )
+		{
+			pArrays.m_vel[pIndex * 2] = -pArrays.m_vel[pIndex * 2];
+			lTimer = pRandom.nextFloat( -5.0, 0.0f );
+		}
+
+		float lModifier = lTimer * TimeTillTurnNormalizedUnit;
+		pArrays.m_pos[pIndex * 2] += pArrays.m_vel[pIndex * 2] * lModifier;
+	}
+};
+
+// Falling at the particle's vertical velocity, per update as SnowFlakes
+// does rather than per second.
+class FallFeature
+{
+public:
+
+	void begin( float ) {}
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float, Random& )
+	{
+		pArrays.m_pos[pIndex * 2 + 1] += pArrays.m_vel[pIndex * 2 + 1];
+	}
+};
+
+// A steady horizontal wind, in units per second. None until set.
+class WindFeature
+{
+public:
+
+	WindFeature() : m_velocity( 0.0f ), m_step( 0.0f ) {}
+
+	void setVelocity( float pVelocity ) { m_velocity = pVelocity; }
+
+	void begin( float pElapsed ) { m_step = m_velocity * pElapsed; }
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float, Random& )
+	{
+		pArrays.m_pos[pIndex * 2] += m_step;
+	}
+
+private:
+
+	float m_velocity;
+	float m_step;
+};
+
+// A horizontal jitter of up to the amplitude either way, different for
+// every particle and update. It hashes the index and update number rather
+// than drawing from the shared generator, so adding it leaves the other
+// features' random numbers as they were.
+class NoiseFeature
+{
+public:
+
+	NoiseFeature() : m_amplitude( 0.0f ), m_frame( 0 ) {}
+
+	void setAmplitude( float pAmplitude ) { m_amplitude = pAmplitude; }
+
+	void begin( float ) { m_frame = m_frame * 0x9e3779b9u + 1; }
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float, Random& )
+	{
+		uint32_t lHash = ((uint32_t) pIndex * 0x85ebca6bu) ^ m_frame;
+		lHash ^= lHash >> 16;
+		lHash *= 0x7feb352du;
+		lHash ^= lHash >> 15;
+
+		float lUnit = (float) (lHash >> 8) * (2.0f / 16777215.0f) - 1.0f;
+		pArrays.m_pos[pIndex * 2] += lUnit * m_amplitude;
+	}
+
+private:
+
+	float m_amplitude;
+	uint32_t m_frame;
+};
+
+// Fades particles out over the given distance above the bottom of the
+// view, where RespawnFeature takes them. One unit until set.
+class FadeFeature
+{
+public:
+
+	FadeFeature() : m_invDistance( 1.0f ) {}
+
+	void setDistance( float pDistance ) { m_invDistance = 1.0f / pDistance; }
+
+	void begin( float ) {}
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float, Random& )
+	{
+		float lAlpha = (pArrays.m_pos[pIndex * 2 + 1] + (ViewMaxY + 0.2f)) * m_invDistance;
+		pArrays.m_col[pIndex * 4 + 3] = (lAlpha < 0.0f) ? 0.0f : (lAlpha > 1.0f) ? 1.0f : lAlpha;
+	}
+
+private:
+
+	float m_invDistance;
+};
+
+// SnowFlakes' respawn: a particle that leaves the bottom or strays too far
+// to either side goes back to the top at a random x. Usually listed last,
+// so that it sees where the others moved the particle to.
+class RespawnFeature
+{
+public:
+
+	void begin( float ) {}
+
+	void update( const ParticleArrays& pArrays, int32_t pIndex, float, Random& pRandom )
+	{
+		float* lPos = &pArrays.m_pos[pIndex * 2];
+
+		if( lPos[1] < -(ViewMaxY + 0.2f) ||
+			lPos[0] < -(ViewMaxX + 0.2f) || lPos[0] > (ViewMaxX + 0.2f) )
+		{
+			lPos[0] = pRandom.nextFloat( -ViewMaxX, ViewMaxX );
+			lPos[1] = 3.1;
+		}
+	}
+};
+
+}
+#endif // _GUILDHALL_PARTICLE_SYSTEM_H_
@@ -0,0 +1,227 @@
+#include "point_transform.h"
+#include "profiler.h"
+#include "simd.h"
+
+namespace guildhall {
+
+namespace {
+
+// The matrix elements each output needs, one per lane. Sums are done in
+// the order Matrix4x4f::transformPoint() does them: x, y, z, then the
+// translation.
+struct AffineRows
+{
+	Float4 m_x[4];   // m[0], m[4], m[8], m[12]
+	Float4 m_y[4];   // m[1], m[5], m[9], m[13]
+	Float4 m_z[4];   // m[2], m[6], m[10], m[14]
+
+	AffineRows( const Matrix4x4f& pMatrix )
+	{
+		for( int32_t i = 0; i < 4; ++i )
+		{
+			m_x[i] = float4Splat( pMatrix.m[i * 4 + 0] );
+			m_y[i] = float4Splat( pMatrix.m[i * 4 + 1] );
+			m_z[i] = float4Splat( pMatrix.m[i * 4 + 2] );
+		}
+	}
+};
+
+inline Float4 transformLanes( const Float4* pRow, Float4 x, Float4 y, Float4 z )
+{
+	return float4Add( float4Madd( z, pRow[2], float4Madd( y, pRow[1], float4Mul( x, pRow[0] ) ) ), pRow[3] );
+}
+
+inline Float4 transformLanes2D( const Float4* pRow, Float4 x, Float4 y )
+{
+	return float4Add( float4Madd( y, pRow[1], float4Mul( x, pRow[0] ) ), pRow[3] );
+}
+
+// The points left over after the last group of four go through here, so
+// they are computed the same way. Reads all of a point before writing any
+// of it, for in place transforms.
+inline void transformPoint( const Matrix4x4f& pMatrix, float x, float y, float z, float* pOutX, float* pOutY, float* pOutZ )
+{
+	const float* m = pMatrix.m;
+	*pOutX = x * m[0] + y * m[4] + z * m[8] + m[12];
+	*pOutY = x * m[1] + y * m[5] + z * m[9] + m[13];
+	*pOutZ = x * m[2] + y * m[6] + z * m[10] + m[14];
+}
+
+inline void transformPoint2D( const Matrix4x4f& pMatrix, float x, float y, float* pOutX, float* pOutY )
+{
+	const float* m = pMatrix.m;
+	*pOutX = x * m[0] + y * m[4] + m[12];
+	*pOutY = x * m[1] + y * m[5] + m[13];
+}
+
+// What the chunks of one call share. The matrix is a copy so that an
+// Affine2f can be passed as its toMat4().
+struct PointTransform
+{
+	Matrix4x4f m_matrix;
+	const float* m_in[3];
+	float* m_out[3];
+};
+
+void transformPointsChunk( void* pContext, int32_t pBegin, int32_t pEnd )
+{
+	const PointTransform& lTransform = *(const PointTransform*) pContext;
+	const float* lX = lTransform.m_in[0];
+	const float* lY = lTransform.m_in[1];
+	const float* lZ = lTransform.m_in[2];
+	float* lOutX = lTransform.m_out[0];
+	float* lOutY = lTransform.m_out[1];
+	float* lOutZ = lTransform.m_out[2];
+	AffineRows lRows( lTransform.m_matrix );
+	int32_t i = pBegin;
+
+	for( ; i + 4 <= pEnd; i += 4 )
+	{
+		Float4 x = float4Load( &lX[i] );
+		Float4 y = float4Load( &lY[i] );
+		Float4 z = float4Load( &lZ[i] );
+
+		float4Store( &lOutX[i], transformLanes( lRows.m_x, x, y, z ) );
+		float4Store( &lOutY[i], transformLanes( lRows.m_y, x, y, z ) );
+		float4Store( &lOutZ[i], transformLanes( lRows.m_z, x, y, z ) );
+	}
+
+	for( ; i < pEnd; ++i )
+		transformPoint( lTransform.m_matrix, lX[i], lY[i], lZ[i], &lOutX[i], &lOutY[i], &lOutZ[i] );
+}
+
+void transformPoints2DChunk( void* pContext, int32_t pBegin, int32_t pEnd )
+{
+	const PointTransform& lTransform = *(const PointTransform*) pContext;
+	const float* lX = lTransform.m_in[0];
+	const float* lY = lTransform.m_in[1];
+	float* lOutX = lTransform.m_out[0];
+	float* lOutY = lTransform.m_out[1];
+	AffineRows lRows( lTransform.m_matrix );
+	int32_t i = pBegin;
+
+	for( ; i + 4 <= pEnd; i += 4 )
+	{
+		Float4 x = float4Load( &lX[i] );
+		Float4 y = float4Load( &lY[i] );
+
+		float4Store( &lOutX[i], transformLanes2D( lRows.m_x, x, y ) );
+		float4Store( &lOutY[i], transformLanes2D( lRows.m_y, x, y ) );
+	}
+
+	for( ; i < pEnd; ++i )
+		transformPoint2D( lTransform.m_matrix, lX[i], lY[i], &lOutX[i], &lOutY[i] );
+}
+
+void transformPackedPointsChunk( void* pContext, int32_t pBegin, int32_t pEnd )
+{
+	const PointTransform& lTransform = *(const PointTransform*) pContext;
+	const float* lPoints = lTransform.m_in[0];
+	float* lOutPoints = lTransform.m_out[0];
+	AffineRows lRows( lTransform.m_matrix );
+	int32_t i = pBegin;
+
+	for( ; i + 4 <= pEnd; i += 4 )
+	{
+		Float4 x, y, z;
+		float4LoadXYZ( &lPoints[i * 3], &x, &y, &z );
+		float4StoreXYZ( &lOutPoints[i * 3], transformLanes( lRows.m_x, x, y, z ),
+				transformLanes( lRows.m_y, x, y, z ), transformLanes( lRows.m_z, x, y, z ) );
+	}
+
+	for( ; i < pEnd; ++i )
+	{
+		const float* lPoint = &lPoints[i * 3];
+		float* lOutPoint = &lOutPoints[i * 3];
+		transformPoint( lTransform.m_matrix, lPoint[0], lPoint[1], lPoint[2], &lOutPoint[0], &lOutPoint[1], &lOutPoint[2] );
+	}
+}
+
+void transformPackedPoints2DChunk( void* pContext, int32_t pBegin, int32_t pEnd )
+{
+	const PointTransform& lTransform = *(const PointTransform*) pContext;
+	const float* lPoints = lTransform.m_in[0];
+	float* lOutPoints = lTransform.m_out[0];
+	AffineRows lRows( lTransform.m_matrix );
+	int32_t i = pBegin;
+
+	for( ; i + 4 <= pEnd; i += 4 )
+	{
+		Float4 x, y;
+		float4LoadXY( &lPoints[i * 2], &x, &y );
+		float4StoreXY( &lOutPoints[i * 2], transformLanes2D( lRows.m_x, x, y ), transformLanes2D( lRows.m_y, x, y ) );
+	}
+
+	for( ; i < pEnd; ++i )
+	{
+		const float* lPoint = &lPoints[i * 2];
+		float* lOutPoint = &lOutPoints[i * 2];
+		transformPoint2D( lTransform.m_matrix, lPoint[0], lPoint[1], &lOutPoint[0], &lOutPoint[1] );
+	}
+}
+
+void runTransform( WorkerPool::Task pTask, PointTransform* pTransform, int32_t pCount, WorkerPool* pPool )
+{
+	if( pPool != NULL )
+		pPool->run( pTask, pTransform, pCount, PointTransformChunkSize );
+	else if( pCount > 0 )
+		pTask( pTransform, 0, pCount );
+}
+
+}
+
+void transformPoints( const Matrix4x4f& pMatrix, const float* pX, const float* pY, const float* pZ,
+		float* pOutX, float* pOutY, float* pOutZ, int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPoints" );
+
+	PointTransform lTransform = { pMatrix, { pX, pY, pZ }, { pOutX, pOutY, pOutZ } };
+	runTransform( transformPointsChunk, &lTransform, pCount, pPool );
+}
+
+void transformPoints2D( const Matrix4x4f& pMatrix, const float* pX, const float* pY,
+		float* pOutX, float* pOutY, int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPoints2D" );
+
+	PointTransform lTransform = { pMatrix, { pX, pY, NULL }, { pOutX, pOutY, NULL } };
+	runTransform( transformPoints2DChunk, &lTransform, pCount, pPool );
+}
+
+void transformPackedPoints( const Matrix4x4f& pMatrix, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPackedPoints" );
+
+	PointTransform lTransform = { pMatrix, { pPoints, NULL, NULL }, { pOutPoints, NULL, NULL } };
+	runTransform( transformPackedPointsChunk, &lTransform, pCount, pPool );
+}
+
+void transformPackedPoints2D( const Matrix4x4f& pMatrix, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPackedPoints2D" );
+
+	PointTransform lTransform = { pMatrix, { pPoints, NULL, NULL }, { pOutPoints, NULL, NULL } };
+	runTransform( transformPackedPoints2DChunk, &lTransform, pCount, pPool );
+}
+
+void transformPoints2D( const Affine2f& pAffine, const float* pX, const float* pY,
+		float* pOutX, float* pOutY, int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPoints2D" );
+
+	PointTransform lTransform = { pAffine.toMat4(), { pX, pY, NULL }, { pOutX, pOutY, NULL } };
+	runTransform( transformPoints2DChunk, &lTransform, pCount, pPool );
+}
+
+void transformPackedPoints2D( const Affine2f& pAffine, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool )
+{
+	GUILDHALL_PROFILE_ZONE( "transformPackedPoints2D" );
+
+	PointTransform lTransform = { pAffine.toMat4(), { pPoints, NULL, NULL }, { pOutPoints, NULL, NULL } };
+	runTransform( transformPackedPoints2DChunk, &lTransform, pCount, pPool );
+}
+
+}
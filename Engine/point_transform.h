@@ -0,0 +1,48 @@
+#ifndef _GUILDHALL_POINT_TRANSFORM_H_
+#define _GUILDHALL_POINT_TRANSFORM_H_
+
+#include "matrix4x4f.h"
+#include "types.h"
+#include "worker_pool.h"
+
+namespace guildhall {
+
+// Transforms whole arrays of points by one matrix, four points at a time,
+// for view transforms, culling and parallax over every flake. Each result
+// is what Matrix4x4f::transformPoint() gives for the same point (bit for
+// bit unless the compiler fuses that function's multiply-adds): the matrix
+// is applied as an affine transform, w is taken to be 1 and no perspective
+// divide is done. The 2D versions take z to be 0.
+//
+// Points come either as separate x, y (and z) arrays, or packed as x, y
+// (and z) per point the way SnowFlakes keeps its positions. The output may
+// be the input itself, but must not otherwise overlap it.
+//
+// The 2D versions also take an Affine2f, with the same results as its
+// toMat4().
+//
+// With a pool, counts over PointTransformChunkSize are split between its
+// threads; pass NULL to stay on the calling thread.
+
+const int32_t PointTransformChunkSize = 16384;
+
+void transformPoints( const Matrix4x4f& pMatrix, const float* pX, const float* pY, const float* pZ,
+		float* pOutX, float* pOutY, float* pOutZ, int32_t pCount, WorkerPool* pPool );
+
+void transformPoints2D( const Matrix4x4f& pMatrix, const float* pX, const float* pY,
+		float* pOutX, float* pOutY, int32_t pCount, WorkerPool* pPool );
+
+void transformPackedPoints( const Matrix4x4f& pMatrix, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool );
+
+void transformPackedPoints2D( const Matrix4x4f& pMatrix, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool );
+
+void transformPoints2D( const Affine2f& pAffine, const float* pX, const float* pY,
+		float* pOutX, float* pOutY, int32_t pCount, WorkerPool* pPool );
+
+void transformPackedPoints2D( const Affine2f& pAffine, const float* pPoints, float* pOutPoints,
+		int32_t pCount, WorkerPool* pPool );
+
+}
+#endif // _GUILDHALL_POINT_TRANSFORM_H_
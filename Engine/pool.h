@@ -0,0 +1,88 @@
+#ifndef _GUILDHALL_POOL_H_
+#define _GUILDHALL_POOL_H_
+
+#include "types.h"
+
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+#include <utility>
+
+namespace guildhall {
+
+// Room for Capacity objects of type T inside the pool itself, for engine
+// objects that come and go at run time, such as the asset loader's jobs.
+// Creating and destroying one takes a slot off a free list and puts it
+// back, so neither touches the heap. Not thread safe.
+template<typename T, int32_t Capacity>
+class Pool
+{
+public:
+
+	Pool() :
+			m_free( &m_slots[0] ),
+			m_count( 0 ),
+			m_highWater( 0 )
+	{
+		for( int32_t i = 0; i < Capacity - 1; ++i )
+			m_slots[i].m_next = &m_slots[i + 1];
+
+		m_slots[Capacity - 1].m_next = NULL;
+	}
+
+	// Every object must have been destroyed.
+	~Pool() {}
+
+	// NULL when all Capacity objects are in use.
+	template<typename... Arguments>
+	T* create( Arguments&&... pArguments )
+	{
+		if( m_free == NULL )
+			return NULL;
+
+		Slot* lSlot = m_free;
+		m_free = lSlot->m_next;
+
+		if( ++m_count > m_highWater )
+			m_highWater = m_count;
+
+		return new( &lSlot->m_storage ) T( std::forward<Arguments>( pArguments )... );
+	}
+
+	// pObject came from this pool's create(), or is NULL.
+	void destroy( T* pObject )
+	{
+		if( pObject == NULL )
+			return;
+
+		pObject->~T();
+
+		Slot* lSlot = (Slot*) pObject;
+		lSlot->m_next = m_free;
+		m_free = lSlot;
+		--m_count;
+	}
+
+	int32_t getCount() const { return m_count; }
+	int32_t getHighWater() const { return m_highWater; }
+	int32_t getCapacity() const { return Capacity; }
+
+private:
+
+	Pool( const Pool& );
+	Pool& operator = ( const Pool& );
+
+	union Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+		Slot* m_next;
+	};
+
+	Slot m_slots[Capacity];
+	Slot* m_free;
+	int32_t m_count;
+	int32_t m_highWater;
+};
+
+}
+#endif // _GUILDHALL_POOL_H_
@@ -0,0 +1,317 @@
+#include "profiler.h"
+
+#ifdef GUILDHALL_PROFILER
+
+#include "log.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace guildhall {
+
+namespace {
+
+struct Event
+{
+	std::atomic<const char*> m_name;
+	std::atomic<uint64_t> m_begin;
+	std::atomic<uint64_t> m_end;
+};
+
+// Single producer ring, written by its owning thread only. m_claimed runs
+// ahead of m_committed while an event is being written, which tells a
+// concurrent reader which of the events it copied may have been torn.
+struct Ring
+{
+	std::atomic<bool> m_owned;
+	bool m_track;
+	std::atomic<const char*> m_threadName;
+	std::atomic<uint64_t> m_claimed;
+	std::atomic<uint64_t> m_committed;
+	Event m_events[Profiler::RingCapacity];
+};
+
+std::atomic<Ring*> g_rings[Profiler::MaxThreads];
+
+// Timestamps are written relative to this, which keeps them small enough
+// for the microsecond doubles of the trace format.
+std::atomic<uint64_t> g_origin( 0 );
+
+std::atomic<uint64_t> g_lastFrame( 0 );
+std::atomic<uint64_t> g_frameTimeTrigger( 0 );
+std::atomic<bool> g_captureRequested( false );
+
+std::mutex g_captureMutex;
+std::string g_capturePath;
+
+std::mutex g_trackMutex;
+
+int32_t acquireRing()
+{
+	uint64_t lNoOrigin = 0;
+	g_origin.compare_exchange_strong( lNoOrigin, Profiler::getTimestamp() );
+
+	for( int32_t i = 0; i < Profiler::MaxThreads; ++i )
+	{
+		Ring* lRing = g_rings[i].load( std::memory_order_acquire );
+
+		if( lRing == NULL )
+		{
+			Ring* lNewRing = new Ring();
+			lNewRing->m_owned.store( true );
+			lNewRing->m_track = false;
+			lNewRing->m_threadName.store( NULL );
+			lNewRing->m_claimed.store( 0 );
+			lNewRing->m_committed.store( 0 );
+
+			if( g_rings[i].compare_exchange_strong( lRing, lNewRing, std::memory_order_acq_rel ) )
+				return i;
+
+			// Another thread took the slot first; lRing now holds its ring.
+			delete lNewRing;
+		}
+
+		// Rings of threads which have exited are reused, so that thread
+		// pools which come and go do not run out of slots.
+		bool lOwned = false;
+
+		if( lRing->m_owned.compare_exchange_strong( lOwned, true ) )
+		{
+			lRing->m_threadName.store( NULL );
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+Ring* getRing( int32_t pIndex )
+{
+	return (pIndex >= 0) ? g_rings[pIndex].load( std::memory_order_acquire ) : NULL;
+}
+
+// Gives the ring back when its thread exits.
+struct ThreadRing
+{
+	Ring* m_ring;
+
+	ThreadRing() : m_ring( getRing( acquireRing() ) ) {}
+
+	~ThreadRing()
+	{
+		if( m_ring != NULL )
+			m_ring->m_owned.store( false, std::memory_order_release );
+	}
+};
+
+thread_local ThreadRing t_ring;
+
+void append( Ring* pRing, const char* pName, uint64_t pBegin, uint64_t pEnd )
+{
+	uint64_t lIndex = pRing->m_claimed.load( std::memory_order_relaxed );
+	pRing->m_claimed.store( lIndex + 1, std::memory_order_relaxed );
+
+	// A reader which sees any of the stores below also sees the claim.
+	std::atomic_thread_fence( std::memory_order_release );
+
+	Event& lEvent = pRing->m_events[lIndex & (Profiler::RingCapacity - 1)];
+	lEvent.m_name.store( pName, std::memory_order_relaxed );
+	lEvent.m_begin.store( pBegin, std::memory_order_relaxed );
+	lEvent.m_end.store( pEnd, std::memory_order_relaxed );
+
+	pRing->m_committed.store( lIndex + 1, std::memory_order_release );
+}
+
+struct PlainEvent
+{
+	const char* m_name;
+	uint64_t m_begin;
+	uint64_t m_end;
+};
+
+void capture()
+{
+	std::string lPath;
+
+	{
+		std::lock_guard<std::mutex> lLock( g_captureMutex );
+		lPath = g_capturePath;
+	}
+
+	if( lPath.empty() )
+	{
+		Log::warn( "Profiler capture requested without a capture path." );
+		return;
+	}
+
+	if( Profiler::writeChromeTrace( lPath.c_str() ) == STATUS_OK )
+		Log::info( "Profiler capture written to %s", lPath.c_str() );
+}
+
+}
+
+void Profiler::setThreadName( const char* pName )
+{
+	if( t_ring.m_ring != NULL )
+		t_ring.m_ring->m_threadName.store( pName, std::memory_order_release );
+}
+
+void Profiler::record( const char* pName, uint64_t pBegin, uint64_t pEnd )
+{
+	if( t_ring.m_ring != NULL )
+		append( t_ring.m_ring, pName, pBegin, pEnd );
+}
+
+int32_t Profiler::createTrack( const char* pName )
+{
+	std::lock_guard<std::mutex> lLock( g_trackMutex );
+
+	for( int32_t i = 0; i < MaxThreads; ++i )
+	{
+		Ring* lRing = getRing( i );
+
+		if( lRing != NULL && lRing->m_track && strcmp( lRing->m_threadName.load(), pName ) == 0 )
+			return i;
+	}
+
+	// Tracks are never given back, so one made for each GL context does
+	// not use up the slots.
+	int32_t lTrack = acquireRing();
+	Ring* lRing = getRing( lTrack );
+
+	if( lRing == NULL )
+		return -1;
+
+	lRing->m_track = true;
+	lRing->m_threadName.store( pName, std::memory_order_release );
+	return lTrack;
+}
+
+void Profiler::recordTrack( int32_t pTrack, const char* pName, uint64_t pBegin, uint64_t pEnd )
+{
+	Ring* lRing = getRing( pTrack );
+
+	if( lRing != NULL )
+		append( lRing, pName, pBegin, pEnd );
+}
+
+status Profiler::writeChromeTrace( const char* pPath )
+{
+	FILE* lFile = fopen( pPath, "w" );
+
+	if( lFile == NULL )
+	{
+		Log::error( "Unable to write the trace to %s", pPath );
+		return STATUS_ERROR;
+	}
+
+	double lOrigin = (double) g_origin.load();
+	std::vector<PlainEvent> lEvents( RingCapacity );
+	const char* lSeparator = "";
+
+	fprintf( lFile, "{\"traceEvents\":[\n" );
+
+	for( int32_t i = 0; i < MaxThreads; ++i )
+	{
+		Ring* lRing = g_rings[i].load( std::memory_order_acquire );
+
+		if( lRing == NULL )
+			continue;
+
+		int32_t lThreadId = i + 1;
+		const char* lThreadName = lRing->m_threadName.load( std::memory_order_acquire );
+
+		if( lThreadName != NULL )
+		{
+			fprintf( lFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+					lSeparator, lThreadId, lThreadName );
+			lSeparator = ",\n";
+		}
+
+		uint64_t lEnd = lRing->m_committed.load( std::memory_order_acquire );
+		uint64_t lBegin = (lEnd > (uint64_t) RingCapacity) ? lEnd - RingCapacity : 0;
+
+		for( uint64_t j = lBegin; j < lEnd; ++j )
+		{
+			const Event& lEvent = lRing->m_events[j & (RingCapacity - 1)];
+			PlainEvent& lCopy = lEvents[j - lBegin];
+			lCopy.m_name = lEvent.m_name.load( std::memory_order_relaxed );
+			lCopy.m_begin = lEvent.m_begin.load( std::memory_order_relaxed );
+			lCopy.m_end = lEvent.m_end.load( std::memory_order_relaxed );
+		}
+
+		// Events the owner has started to overwrite since are dropped.
+		std::atomic_thread_fence( std::memory_order_acquire );
+		uint64_t lClaimed = lRing->m_claimed.load( std::memory_order_relaxed );
+		uint64_t lFirstValid = (lClaimed > (uint64_t) RingCapacity) ? lClaimed - RingCapacity : 0;
+
+		for( uint64_t j = (lFirstValid > lBegin) ? lFirstValid : lBegin; j < lEnd; ++j )
+		{
+			const PlainEvent& lEvent = lEvents[j - lBegin];
+
+			fprintf( lFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					lSeparator, lEvent.m_name, lThreadId, (lEvent.m_begin - lOrigin) * 1.0e-3,
+					(lEvent.m_end - lEvent.m_begin) * 1.0e-3 );
+			lSeparator = ",\n";
+		}
+	}
+
+	fprintf( lFile, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+
+	bool lWritten = (ferror( lFile ) == 0);
+
+	if( fclose( lFile ) != 0 || !lWritten )
+	{
+		Log::error( "Unable to write the trace to %s", pPath );
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+void Profiler::endFrame()
+{
+	uint64_t lNow = getTimestamp();
+	uint64_t lLastFrame = g_lastFrame.load( std::memory_order_relaxed );
+
+	if( lLastFrame != 0 )
+	{
+		record( "Frame", lLastFrame, lNow );
+
+		uint64_t lTrigger = g_frameTimeTrigger.load( std::memory_order_relaxed );
+		bool lSpike = (lTrigger != 0 && lNow - lLastFrame > lTrigger);
+
+		if( lSpike )
+			g_frameTimeTrigger.store( 0, std::memory_order_relaxed );
+
+		if( g_captureRequested.exchange( false ) || lSpike )
+			capture();
+	}
+
+	// Taken again so that writing a capture does not count as frame time.
+	g_lastFrame.store( getTimestamp(), std::memory_order_relaxed );
+}
+
+void Profiler::setCapturePath( const char* pPath )
+{
+	std::lock_guard<std::mutex> lLock( g_captureMutex );
+	g_capturePath = (pPath != NULL) ? pPath : "";
+}
+
+void Profiler::requestCapture()
+{
+	g_captureRequested.store( true );
+}
+
+void Profiler::setFrameTimeTrigger( double pSeconds )
+{
+	g_frameTimeTrigger.store( (pSeconds > 0.0) ? (uint64_t)(pSeconds * 1.0e9) : 0, std::memory_order_relaxed );
+}
+
+}
+
+#endif // GUILDHALL_PROFILER
@@ -0,0 +1,122 @@
+#ifndef _GUILDHALL_PROFILER_H_
+#define _GUILDHALL_PROFILER_H_
+
+#include "types.h"
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+// Scoped instrumentation zones, exported as Chrome trace JSON (which
+// chrome://tracing and ui.perfetto.dev both open). Everything compiles
+// to nothing unless GUILDHALL_PROFILER is defined, so zones can stay in
+// hot code:
+//
+//     void SnowRenderer::draw( const SnowFlakes& pSnowFlakes )
+//     {
+//         GUILDHALL_PROFILE_ZONE( "SnowRenderer::draw" );
+//         ...
+//
+// Zone names must be string literals, or at least outlive the profiler.
+#ifdef GUILDHALL_PROFILER
+#define GUILDHALL_PROFILE_CONCAT_( a, b ) a##b
+#define GUILDHALL_PROFILE_CONCAT( a, b ) GUILDHALL_PROFILE_CONCAT_( a, b )
+#define GUILDHALL_PROFILE_ZONE( pName ) \
+	guildhall::ProfileZone GUILDHALL_PROFILE_CONCAT( lProfileZone, __LINE__ )( pName )
+#define GUILDHALL_PROFILE_THREAD( pName ) guildhall::Profiler::setThreadName( pName )
+#define GUILDHALL_PROFILE_FRAME() guildhall::Profiler::endFrame()
+#else
+#define GUILDHALL_PROFILE_ZONE( pName )
+#define GUILDHALL_PROFILE_THREAD( pName )
+#define GUILDHALL_PROFILE_FRAME()
+#endif
+
+#ifdef GUILDHALL_PROFILER
+
+namespace guildhall {
+
+class Profiler
+{
+public:
+
+	// Events kept per thread. Older ones are overwritten, so a capture
+	// holds the last few seconds of every thread.
+	static const int32_t RingCapacity = 16384;
+	static const int32_t MaxThreads = 32;
+
+	// Monotonic nanoseconds.
+	static uint64_t getTimestamp()
+	{
+#ifdef __APPLE__
+		static mach_timebase_info_data_t lTimebase;
+
+		if( lTimebase.denom == 0 )
+			mach_timebase_info( &lTimebase );
+
+		return mach_absolute_time() * lTimebase.numer / lTimebase.denom;
+#else
+		timespec lTimeVal;
+		clock_gettime( CLOCK_MONOTONIC, &lTimeVal );
+		return (uint64_t) lTimeVal.tv_sec * 1000000000u + lTimeVal.tv_nsec;
+#endif
+	}
+
+	// Names the calling thread in the trace.
+	static void setThreadName( const char* pName );
+
+	// Appends a finished zone to the calling thread's ring. Lock-free.
+	static void record( const char* pName, uint64_t pBegin, uint64_t pEnd );
+
+	// Adds a track for events which were not timed on a CPU thread, such as
+	// GPU passes, shown in the trace like a thread named pName. Returns the
+	// track to record to, the same one for every call with the same name,
+	// or -1 when all MaxThreads slots are taken. A track must only be
+	// recorded to from one thread at a time.
+	static int32_t createTrack( const char* pName );
+	static void recordTrack( int32_t pTrack, const char* pName, uint64_t pBegin, uint64_t pEnd );
+
+	// Writes the events of every thread as Chrome trace JSON. May be called
+	// from any thread while the others keep recording.
+	static status writeChromeTrace( const char* pPath );
+
+	// Once per frame, on the render thread. Records a "Frame" zone since
+	// the previous call, and writes a capture to the capture path when one
+	// was requested or the frame took longer than the trigger.
+	static void endFrame();
+
+	static void setCapturePath( const char* pPath );
+	static void requestCapture();
+
+	// Captures the first frame longer than pSeconds, then disarms. Zero
+	// (the default) disables the trigger.
+	static void setFrameTimeTrigger( double pSeconds );
+};
+
+// Records the time from its construction to its destruction.
+class ProfileZone
+{
+public:
+
+	ProfileZone( const char* pName ) :
+			m_name( pName ),
+			m_begin( Profiler::getTimestamp() )
+	{
+	}
+
+	~ProfileZone()
+	{
+		Profiler::record( m_name, m_begin, Profiler::getTimestamp() );
+	}
+
+private:
+
+	const char* m_name;
+	uint64_t m_begin;
+};
+
+}
+
+#endif // GUILDHALL_PROFILER
+#endif // _GUILDHALL_PROFILER_H_
@@ -0,0 +1,52 @@
+#ifndef _GUILDHALL_RANDOM_H_
+#define _GUILDHALL_RANDOM_H_
+
+#include "types.h"
+
+namespace guildhall {
+
+// Small deterministic generator (PCG32, O'Neill 2014). Unlike rand() its
+// sequence does not depend on the C library, and every SnowFlakes owns
+// one instead of sharing hidden global state, so a seed reproduces a run
+// exactly.
+class Random
+{
+public:
+
+	Random() : m_state( 0 ) { seed( 1 ); }
+
+	void seed( uint32_t pSeed )
+	{
+		m_state = 0;
+		next();
+		m_state += pSeed;
+		next();
+	}
+
+	uint32_t next()
+	{
+		uint64_t lState = m_state;
+		m_state = lState * 6364136223846793005ULL + Increment;
+
+		uint32_t lXorShifted = (uint32_t) (((lState >> 18) ^ lState) >> 27);
+		uint32_t lRotation = (uint32_t) (lState >> 59);
+		return (lXorShifted >> lRotation) | (lXorShifted << ((32 - lRotation) & 31));
+	}
+
+	// In [pMin, pMax].
+	float nextFloat( float pMin, float pMax )
+	{
+		// 24 bits are all a float's mantissa holds.
+		float lUnit = (float) (next() >> 8) * (1.0f / 16777215.0f);
+		return pMin + lUnit * (pMax - pMin);
+	}
+
+private:
+
+	static const uint64_t Increment = 1442695040888963407ULL;
+
+	uint64_t m_state;
+};
+
+}
+#endif // _GUILDHALL_RANDOM_H_
@@ -0,0 +1,24 @@
+#ifndef _GUILDHALL_RENDERER_H_
+#define _GUILDHALL_RENDERER_H_
+
+#include "snowflakes.h"
+
+namespace guildhall {
+
+// Common interface of the snow renderers. Each backend has its own
+// initialize(), since what it needs to get going differs.
+class Renderer
+{
+public:
+
+	virtual ~Renderer() {}
+
+	virtual void release() = 0;
+	virtual void draw( const SnowFlakes& pSnowFlakes ) = 0;
+
+	// Share of the flakes the last draw() culled as off screen, 0 to 100.
+	virtual float getCulledPercentage() const = 0;
+};
+
+}
+#endif // _GUILDHALL_RENDERER_H_
@@ -0,0 +1,537 @@
+#ifndef _GUILDHALL_SIMD_H_
+#define _GUILDHALL_SIMD_H_
+
+#include <stdint.h>
+
+// Minimal four lane float vector over SSE2, NEON or plain C++, picked at
+// compile time. Only what the engine's kernels need is wrapped.
+//
+// A file that defines GUILDHALL_SIMD_FORCE_SCALAR before including this
+// gets the plain C++ version whatever the target, which is how kernels.h
+// builds its scalar variants. Each version is in its own inline
+// namespace, so files built for different ones can be linked together.
+#if defined(GUILDHALL_SIMD_FORCE_SCALAR)
+#define GUILDHALL_SIMD_SCALAR 1
+#include <string.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define GUILDHALL_SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GUILDHALL_SIMD_NEON 1
+#include <arm_neon.h>
+#else
+#define GUILDHALL_SIMD_SCALAR 1
+#include <string.h>
+#endif
+
+namespace guildhall {
+
+#if GUILDHALL_SIMD_SSE
+inline namespace simd_sse2 {
+#elif GUILDHALL_SIMD_NEON
+inline namespace simd_neon {
+#else
+inline namespace simd_scalar {
+#endif
+
+#if GUILDHALL_SIMD_SSE
+
+struct Float4 { __m128 v; };
+
+inline Float4 float4Load( const float* pValues ) { Float4 r = { _mm_loadu_ps( pValues ) }; return r; }
+inline void float4Store( float* pValues, Float4 a ) { _mm_storeu_ps( pValues, a.v ); }
+inline Float4 float4Splat( float pValue ) { Float4 r = { _mm_set1_ps( pValue ) }; return r; }
+inline Float4 float4Set( float x, float y, float z, float w ) { Float4 r = { _mm_setr_ps( x, y, z, w ) }; return r; }
+inline Float4 float4Add( Float4 a, Float4 b ) { Float4 r = { _mm_add_ps( a.v, b.v ) }; return r; }
+inline Float4 float4Sub( Float4 a, Float4 b ) { Float4 r = { _mm_sub_ps( a.v, b.v ) }; return r; }
+inline Float4 float4Mul( Float4 a, Float4 b ) { Float4 r = { _mm_mul_ps( a.v, b.v ) }; return r; }
+inline Float4 float4Min( Float4 a, Float4 b ) { Float4 r = { _mm_min_ps( a.v, b.v ) }; return r; }
+inline Float4 float4Max( Float4 a, Float4 b ) { Float4 r = { _mm_max_ps( a.v, b.v ) }; return r; }
+
+// a * b + c
+inline Float4 float4Madd( Float4 a, Float4 b, Float4 c ) { return float4Add( float4Mul( a, b ), c ); }
+
+// Broadcasts lane pLane to all four lanes.
+template<int pLane>
+inline Float4 float4Lane( Float4 a ) { Float4 r = { _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( pLane, pLane, pLane, pLane ) ) }; return r; }
+
+// Unpacks four 8 bit channels (r in the lowest byte) to 0..255 floats.
+inline Float4 float4FromRgba8( uint32_t pPixel )
+{
+	__m128i lZero = _mm_setzero_si128();
+	__m128i lWide = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( pPixel ), lZero ), lZero );
+	Float4 r = { _mm_cvtepi32_ps( lWide ) };
+	return r;
+}
+
+// Rounds 0..255 floats back to four 8 bit channels, saturating.
+inline uint32_t float4ToRgba8( Float4 a )
+{
+	__m128i lInt = _mm_cvtps_epi32( a.v );
+	__m128i lShort = _mm_packs_epi32( lInt, lInt );
+	return (uint32_t) _mm_cvtsi128_si32( _mm_packus_epi16( lShort, lShort ) );
+}
+
+// Loads four interleaved x, y pairs as one vector of x and one of y.
+inline void float4LoadXY( const float* pValues, Float4* pX, Float4* pY )
+{
+	__m128 lLow = _mm_loadu_ps( pValues );
+	__m128 lHigh = _mm_loadu_ps( pValues + 4 );
+	pX->v = _mm_shuffle_ps( lLow, lHigh, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+	pY->v = _mm_shuffle_ps( lLow, lHigh, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+}
+
+inline Float4 float4Abs( Float4 a ) { Float4 r = { _mm_andnot_ps( _mm_set1_ps( -0.0f ), a.v ) }; return r; }
+
+// Bit i of the result is set when lane i of a is less than or equal to b.
+inline int32_t float4LessEqualMask( Float4 a, Float4 b ) { return _mm_movemask_ps( _mm_cmple_ps( a.v, b.v ) ); }
+
+// Lanes ( a[x], a[y], a[z], a[w] ).
+template<int x, int y, int z, int w>
+inline Float4 float4Swizzle( Float4 a ) { Float4 r = { _mm_shuffle_ps( a.v, a.v, _MM_SHUFFLE( w, z, y, x ) ) }; return r; }
+
+// Lanes ( a[x], a[y], b[z], b[w] ).
+template<int x, int y, int z, int w>
+inline Float4 float4Shuffle( Float4 a, Float4 b ) { Float4 r = { _mm_shuffle_ps( a.v, b.v, _MM_SHUFFLE( w, z, y, x ) ) }; return r; }
+
+// Transposes the 4x4 matrix whose rows (or columns) are p0 to p3.
+inline void float4Transpose( Float4* p0, Float4* p1, Float4* p2, Float4* p3 ) { _MM_TRANSPOSE4_PS( p0->v, p1->v, p2->v, p3->v ); }
+
+// The reverse of float4LoadXY().
+inline void float4StoreXY( float* pValues, Float4 x, Float4 y )
+{
+	_mm_storeu_ps( pValues, _mm_unpacklo_ps( x.v, y.v ) );
+	_mm_storeu_ps( pValues + 4, _mm_unpackhi_ps( x.v, y.v ) );
+}
+
+// Loads four interleaved x, y, z triples as one vector of each.
+inline void float4LoadXYZ( const float* pValues, Float4* pX, Float4* pY, Float4* pZ )
+{
+	// x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3.
+	Float4 a = float4Load( pValues );
+	Float4 b = float4Load( pValues + 4 );
+	Float4 c = float4Load( pValues + 8 );
+
+	*pX = float4Shuffle<0, 3, 0, 2>( a, float4Shuffle<2, 2, 1, 1>( b, c ) );
+	*pY = float4Shuffle<0, 2, 0, 2>( float4Shuffle<1, 1, 0, 0>( a, b ), float4Shuffle<3, 3, 2, 2>( b, c ) );
+	*pZ = float4Shuffle<0, 2, 0, 3>( float4Shuffle<2, 2, 1, 1>( a, b ), c );
+}
+
+// The reverse of float4LoadXYZ().
+inline void float4StoreXYZ( float* pValues, Float4 x, Float4 y, Float4 z )
+{
+	float4Store( pValues, float4Shuffle<0, 2, 0, 2>( float4Shuffle<0, 0, 0, 0>( x, y ), float4Shuffle<0, 0, 1, 1>( z, x ) ) );
+	float4Store( pValues + 4, float4Shuffle<0, 2, 0, 2>( float4Shuffle<1, 1, 1, 1>( y, z ), float4Shuffle<2, 2, 2, 2>( x, y ) ) );
+	float4Store( pValues + 8, float4Shuffle<0, 2, 0, 2>( float4Shuffle<2, 2, 3, 3>( z, x ), float4Shuffle<3, 3, 3, 3>( y, z ) ) );
+}
+
+// Bitwise operations on the lanes' IEEE 754 bit patterns.
+inline Float4 float4And( Float4 a, Float4 b ) { Float4 r = { _mm_and_ps( a.v, b.v ) }; return r; }
+inline Float4 float4Xor( Float4 a, Float4 b ) { Float4 r = { _mm_xor_ps( a.v, b.v ) }; return r; }
+
+// Lanes of a where pMask is all ones and of b where it is all zeros.
+inline Float4 float4Select( Float4 pMask, Float4 a, Float4 b )
+{
+	Float4 r = { _mm_or_ps( _mm_and_ps( pMask.v, a.v ), _mm_andnot_ps( pMask.v, b.v ) ) };
+	return r;
+}
+
+// Bit pBit of each lane's bit pattern moved to the sign bit, so -0.0f
+// where it is set and 0.0f elsewhere.
+template<int pBit>
+inline Float4 float4BitToSign( Float4 a )
+{
+	Float4 r = { _mm_and_ps( _mm_castsi128_ps( _mm_slli_epi32( _mm_castps_si128( a.v ), 31 - pBit ) ), _mm_set1_ps( -0.0f ) ) };
+	return r;
+}
+
+// All ones where bit pBit of a lane's bit pattern is set, all zeros elsewhere.
+template<int pBit>
+inline Float4 float4BitToMask( Float4 a )
+{
+	Float4 r = { _mm_castsi128_ps( _mm_srai_epi32( _mm_slli_epi32( _mm_castps_si128( a.v ), 31 - pBit ), 31 ) ) };
+	return r;
+}
+
+// Eight lane 16 bit integer vector, for fixed point kernels. Arithmetic
+// wraps around like int16_t's would if it did not promote to int.
+struct Int16x8 { __m128i v; };
+
+inline Int16x8 int16x8Load( const int16_t* pValues ) { Int16x8 r = { _mm_loadu_si128( (const __m128i*) pValues ) }; return r; }
+inline void int16x8Store( int16_t* pValues, Int16x8 a ) { _mm_storeu_si128( (__m128i*) pValues, a.v ); }
+inline Int16x8 int16x8Splat( int16_t pValue ) { Int16x8 r = { _mm_set1_epi16( pValue ) }; return r; }
+
+// Eight int8_t sign extended to 16 bits.
+inline Int16x8 int16x8LoadInt8( const int8_t* pValues )
+{
+	__m128i lBytes = _mm_loadl_epi64( (const __m128i*) pValues );
+	Int16x8 r = { _mm_srai_epi16( _mm_unpacklo_epi8( lBytes, lBytes ), 8 ) };
+	return r;
+}
+
+inline Int16x8 int16x8Add( Int16x8 a, Int16x8 b ) { Int16x8 r = { _mm_add_epi16( a.v, b.v ) }; return r; }
+inline Int16x8 int16x8Sub( Int16x8 a, Int16x8 b ) { Int16x8 r = { _mm_sub_epi16( a.v, b.v ) }; return r; }
+inline Int16x8 int16x8Or( Int16x8 a, Int16x8 b ) { Int16x8 r = { _mm_or_si128( a.v, b.v ) }; return r; }
+
+// The high half of the 32 bit product, (a * b) >> 16.
+inline Int16x8 int16x8MulHigh( Int16x8 a, Int16x8 b ) { Int16x8 r = { _mm_mulhi_epi16( a.v, b.v ) }; return r; }
+
+// Arithmetic, so negative lanes round towards minus infinity.
+template<int pBits>
+inline Int16x8 int16x8ShiftRight( Int16x8 a ) { Int16x8 r = { _mm_srai_epi16( a.v, pBits ) }; return r; }
+
+template<int pBits>
+inline Int16x8 int16x8ShiftLeft( Int16x8 a ) { Int16x8 r = { _mm_slli_epi16( a.v, pBits ) }; return r; }
+
+// All ones in the lanes where a > b, all zeros elsewhere.
+inline Int16x8 int16x8Greater( Int16x8 a, Int16x8 b ) { Int16x8 r = { _mm_cmpgt_epi16( a.v, b.v ) }; return r; }
+
+// True if any lane of pMask is set.
+inline bool int16x8Any( Int16x8 pMask ) { return _mm_movemask_epi8( pMask.v ) != 0; }
+
+#elif GUILDHALL_SIMD_NEON
+
+struct Float4 { float32x4_t v; };
+
+inline Float4 float4Load( const float* pValues ) { Float4 r = { vld1q_f32( pValues ) }; return r; }
+inline void float4Store( float* pValues, Float4 a ) { vst1q_f32( pValues, a.v ); }
+inline Float4 float4Splat( float pValue ) { Float4 r = { vdupq_n_f32( pValue ) }; return r; }
+inline Float4 float4Set( float x, float y, float z, float w ) { const float lValues[4] = { x, y, z, w }; return float4Load( lValues ); }
+inline Float4 float4Add( Float4 a, Float4 b ) { Float4 r = { vaddq_f32( a.v, b.v ) }; return r; }
+inline Float4 float4Sub( Float4 a, Float4 b ) { Float4 r = { vsubq_f32( a.v, b.v ) }; return r; }
+inline Float4 float4Mul( Float4 a, Float4 b ) { Float4 r = { vmulq_f32( a.v, b.v ) }; return r; }
+inline Float4 float4Min( Float4 a, Float4 b ) { Float4 r = { vminq_f32( a.v, b.v ) }; return r; }
+inline Float4 float4Max( Float4 a, Float4 b ) { Float4 r = { vmaxq_f32( a.v, b.v ) }; return r; }
+inline Float4 float4Madd( Float4 a, Float4 b, Float4 c ) { Float4 r = { vmlaq_f32( c.v, a.v, b.v ) }; return r; }
+
+template<int pLane>
+inline Float4 float4Lane( Float4 a ) { Float4 r = { vdupq_n_f32( vgetq_lane_f32( a.v, pLane ) ) }; return r; }
+
+inline Float4 float4FromRgba8( uint32_t pPixel )
+{
+	uint16x8_t lShort = vmovl_u8( vcreate_u8( pPixel ) );
+	Float4 r = { vcvtq_f32_u32( vmovl_u16( vget_low_u16( lShort ) ) ) };
+	return r;
+}
+
+inline uint32_t float4ToRgba8( Float4 a )
+{
+	// Adds 0.5 since the conversion truncates.
+	uint32x4_t lInt = vcvtq_u32_f32( vaddq_f32( vmaxq_f32( a.v, vdupq_n_f32( 0.0f ) ), vdupq_n_f32( 0.5f ) ) );
+	uint16x4_t lShort = vqmovn_u32( lInt );
+	uint8x8_t lByte = vqmovn_u16( vcombine_u16( lShort, lShort ) );
+	return vget_lane_u32( vreinterpret_u32_u8( lByte ), 0 );
+}
+
+inline void float4LoadXY( const float* pValues, Float4* pX, Float4* pY )
+{
+	float32x4x2_t lPairs = vld2q_f32( pValues );
+	pX->v = lPairs.val[0];
+	pY->v = lPairs.val[1];
+}
+
+inline Float4 float4Abs( Float4 a ) { Float4 r = { vabsq_f32( a.v ) }; return r; }
+
+inline int32_t float4LessEqualMask( Float4 a, Float4 b )
+{
+	const int32_t lBitValues[4] = { 1, 2, 4, 8 };
+	uint32x4_t lBits = vandq_u32( vcleq_f32( a.v, b.v ), vreinterpretq_u32_s32( vld1q_s32( lBitValues ) ) );
+	uint32x2_t lPairs = vorr_u32( vget_low_u32( lBits ), vget_high_u32( lBits ) );
+	return (int32_t)(vget_lane_u32( lPairs, 0 ) | vget_lane_u32( lPairs, 1 ));
+}
+
+// Clang, which the NDK uses, and GCC spell generic shuffles differently.
+template<int x, int y, int z, int w>
+inline Float4 float4Swizzle( Float4 a )
+{
+#if defined(__clang__)
+	Float4 r = { __builtin_shufflevector( a.v, a.v, x, y, z, w ) };
+#else
+	const uint32x4_t lMask = { x, y, z, w };
+	Float4 r = { __builtin_shuffle( a.v, lMask ) };
+#endif
+	return r;
+}
+
+template<int x, int y, int z, int w>
+inline Float4 float4Shuffle( Float4 a, Float4 b )
+{
+#if defined(__clang__)
+	Float4 r = { __builtin_shufflevector( a.v, b.v, x, y, z + 4, w + 4 ) };
+#else
+	const uint32x4_t lMask = { x, y, z + 4, w + 4 };
+	Float4 r = { __builtin_shuffle( a.v, b.v, lMask ) };
+#endif
+	return r;
+}
+
+inline void float4Transpose( Float4* p0, Float4* p1, Float4* p2, Float4* p3 )
+{
+	float32x4x2_t l01 = vtrnq_f32( p0->v, p1->v );
+	float32x4x2_t l23 = vtrnq_f32( p2->v, p3->v );
+	p0->v = vcombine_f32( vget_low_f32( l01.val[0] ), vget_low_f32( l23.val[0] ) );
+	p1->v = vcombine_f32( vget_low_f32( l01.val[1] ), vget_low_f32( l23.val[1] ) );
+	p2->v = vcombine_f32( vget_high_f32( l01.val[0] ), vget_high_f32( l23.val[0] ) );
+	p3->v = vcombine_f32( vget_high_f32( l01.val[1] ), vget_high_f32( l23.val[1] ) );
+}
+
+inline void float4StoreXY( float* pValues, Float4 x, Float4 y )
+{
+	float32x4x2_t lPairs = { { x.v, y.v } };
+	vst2q_f32( pValues, lPairs );
+}
+
+inline void float4LoadXYZ( const float* pValues, Float4* pX, Float4* pY, Float4* pZ )
+{
+	float32x4x3_t lTriples = vld3q_f32( pValues );
+	pX->v = lTriples.val[0];
+	pY->v = lTriples.val[1];
+	pZ->v = lTriples.val[2];
+}
+
+inline void float4StoreXYZ( float* pValues, Float4 x, Float4 y, Float4 z )
+{
+	float32x4x3_t lTriples = { { x.v, y.v, z.v } };
+	vst3q_f32( pValues, lTriples );
+}
+
+inline Float4 float4And( Float4 a, Float4 b )
+{
+	Float4 r = { vreinterpretq_f32_u32( vandq_u32( vreinterpretq_u32_f32( a.v ), vreinterpretq_u32_f32( b.v ) ) ) };
+	return r;
+}
+
+inline Float4 float4Xor( Float4 a, Float4 b )
+{
+	Float4 r = { vreinterpretq_f32_u32( veorq_u32( vreinterpretq_u32_f32( a.v ), vreinterpretq_u32_f32( b.v ) ) ) };
+	return r;
+}
+
+inline Float4 float4Select( Float4 pMask, Float4 a, Float4 b ) { Float4 r = { vbslq_f32( vreinterpretq_u32_f32( pMask.v ), a.v, b.v ) }; return r; }
+
+template<int pBit>
+inline Float4 float4BitToSign( Float4 a )
+{
+	uint32x4_t lBits = vshlq_n_u32( vreinterpretq_u32_f32( a.v ), 31 - pBit );
+	Float4 r = { vreinterpretq_f32_u32( vandq_u32( lBits, vdupq_n_u32( 0x80000000u ) ) ) };
+	return r;
+}
+
+template<int pBit>
+inline Float4 float4BitToMask( Float4 a )
+{
+	Float4 r = { vreinterpretq_f32_s32( vshrq_n_s32( vshlq_n_s32( vreinterpretq_s32_f32( a.v ), 31 - pBit ), 31 ) ) };
+	return r;
+}
+
+struct Int16x8 { int16x8_t v; };
+
+inline Int16x8 int16x8Load( const int16_t* pValues ) { Int16x8 r = { vld1q_s16( pValues ) }; return r; }
+inline void int16x8Store( int16_t* pValues, Int16x8 a ) { vst1q_s16( pValues, a.v ); }
+inline Int16x8 int16x8Splat( int16_t pValue ) { Int16x8 r = { vdupq_n_s16( pValue ) }; return r; }
+inline Int16x8 int16x8LoadInt8( const int8_t* pValues ) { Int16x8 r = { vmovl_s8( vld1_s8( pValues ) ) }; return r; }
+inline Int16x8 int16x8Add( Int16x8 a, Int16x8 b ) { Int16x8 r = { vaddq_s16( a.v, b.v ) }; return r; }
+inline Int16x8 int16x8Sub( Int16x8 a, Int16x8 b ) { Int16x8 r = { vsubq_s16( a.v, b.v ) }; return r; }
+inline Int16x8 int16x8Or( Int16x8 a, Int16x8 b ) { Int16x8 r = { vorrq_s16( a.v, b.v ) }; return r; }
+
+inline Int16x8 int16x8MulHigh( Int16x8 a, Int16x8 b )
+{
+	int16x4_t lLow = vshrn_n_s32( vmull_s16( vget_low_s16( a.v ), vget_low_s16( b.v ) ), 16 );
+	int16x4_t lHigh = vshrn_n_s32( vmull_s16( vget_high_s16( a.v ), vget_high_s16( b.v ) ), 16 );
+	Int16x8 r = { vcombine_s16( lLow, lHigh ) };
+	return r;
+}
+
+template<int pBits>
+inline Int16x8 int16x8ShiftRight( Int16x8 a ) { Int16x8 r = { vshrq_n_s16( a.v, pBits ) }; return r; }
+
+template<int pBits>
+inline Int16x8 int16x8ShiftLeft( Int16x8 a ) { Int16x8 r = { vshlq_n_s16( a.v, pBits ) }; return r; }
+
+inline Int16x8 int16x8Greater( Int16x8 a, Int16x8 b ) { Int16x8 r = { vreinterpretq_s16_u16( vcgtq_s16( a.v, b.v ) ) }; return r; }
+
+inline bool int16x8Any( Int16x8 pMask )
+{
+	int16x4_t lHalves = vorr_s16( vget_low_s16( pMask.v ), vget_high_s16( pMask.v ) );
+	return vget_lane_u64( vreinterpret_u64_s16( lHalves ), 0 ) != 0;
+}
+
+#else
+
+struct Float4 { float v[4]; };
+
+inline Float4 float4Load( const float* pValues ) { Float4 r = { { pValues[0], pValues[1], pValues[2], pValues[3] } }; return r; }
+inline void float4Store( float* pValues, Float4 a ) { for( int i = 0; i < 4; ++i ) pValues[i] = a.v[i]; }
+inline Float4 float4Splat( float pValue ) { Float4 r = { { pValue, pValue, pValue, pValue } }; return r; }
+inline Float4 float4Set( float x, float y, float z, float w ) { Float4 r = { { x, y, z, w } }; return r; }
+inline Float4 float4Add( Float4 a, Float4 b ) { for( int i = 0; i < 4; ++i ) a.v[i] += b.v[i]; return a; }
+inline Float4 float4Sub( Float4 a, Float4 b ) { for( int i = 0; i < 4; ++i ) a.v[i] -= b.v[i]; return a; }
+inline Float4 float4Mul( Float4 a, Float4 b ) { for( int i = 0; i < 4; ++i ) a.v[i] *= b.v[i]; return a; }
+inline Float4 float4Min( Float4 a, Float4 b ) { for( int i = 0; i < 4; ++i ) a.v[i] = (b.v[i] < a.v[i]) ? b.v[i] : a.v[i]; return a; }
+inline Float4 float4Max( Float4 a, Float4 b ) { for( int i = 0; i < 4; ++i ) a.v[i] = (b.v[i] > a.v[i]) ? b.v[i] : a.v[i]; return a; }
+inline Float4 float4Madd( Float4 a, Float4 b, Float4 c ) { return float4Add( float4Mul( a, b ), c ); }
+
+template<int pLane>
+inline Float4 float4Lane( Float4 a ) { return float4Splat( a.v[pLane] ); }
+
+inline Float4 float4FromRgba8( uint32_t pPixel )
+{
+	Float4 r = { { (float)(pPixel & 0xff), (float)((pPixel >> 8) & 0xff), (float)((pPixel >> 16) & 0xff), (float)(pPixel >> 24) } };
+	return r;
+}
+
+inline uint32_t float4ToRgba8( Float4 a )
+{
+	uint32_t lPixel = 0;
+
+	for( int i = 0; i < 4; ++i )
+	{
+		float lValue = a.v[i] + 0.5f;
+		uint32_t lByte = (lValue <= 0.0f) ? 0 : (lValue >= 255.0f) ? 255 : (uint32_t) lValue;
+		lPixel |= lByte << (i * 8);
+	}
+
+	return lPixel;
+}
+
+inline void float4LoadXY( const float* pValues, Float4* pX, Float4* pY )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		pX->v[i] = pValues[i * 2 + 0];
+		pY->v[i] = pValues[i * 2 + 1];
+	}
+}
+
+inline Float4 float4Abs( Float4 a ) { for( int i = 0; i < 4; ++i ) a.v[i] = (a.v[i] < 0.0f) ? -a.v[i] : a.v[i]; return a; }
+
+inline int32_t float4LessEqualMask( Float4 a, Float4 b )
+{
+	int32_t lMask = 0;
+
+	for( int i = 0; i < 4; ++i )
+		lMask |= (a.v[i] <= b.v[i]) ? (1 << i) : 0;
+
+	return lMask;
+}
+
+template<int x, int y, int z, int w>
+inline Float4 float4Swizzle( Float4 a ) { Float4 r = { { a.v[x], a.v[y], a.v[z], a.v[w] } }; return r; }
+
+template<int x, int y, int z, int w>
+inline Float4 float4Shuffle( Float4 a, Float4 b ) { Float4 r = { { a.v[x], a.v[y], b.v[z], b.v[w] } }; return r; }
+
+inline void float4Transpose( Float4* p0, Float4* p1, Float4* p2, Float4* p3 )
+{
+	Float4* lRows[4] = { p0, p1, p2, p3 };
+
+	for( int i = 0; i < 4; ++i )
+	{
+		for( int j = i + 1; j < 4; ++j )
+		{
+			float lValue = lRows[i]->v[j];
+			lRows[i]->v[j] = lRows[j]->v[i];
+			lRows[j]->v[i] = lValue;
+		}
+	}
+}
+
+inline void float4StoreXY( float* pValues, Float4 x, Float4 y )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		pValues[i * 2 + 0] = x.v[i];
+		pValues[i * 2 + 1] = y.v[i];
+	}
+}
+
+inline void float4LoadXYZ( const float* pValues, Float4* pX, Float4* pY, Float4* pZ )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		pX->v[i] = pValues[i * 3 + 0];
+		pY->v[i] = pValues[i * 3 + 1];
+		pZ->v[i] = pValues[i * 3 + 2];
+	}
+}
+
+inline void float4StoreXYZ( float* pValues, Float4 x, Float4 y, Float4 z )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		pValues[i * 3 + 0] = x.v[i];
+		pValues[i * 3 + 1] = y.v[i];
+		pValues[i * 3 + 2] = z.v[i];
+	}
+}
+
+inline uint32_t floatBits( float pValue ) { uint32_t lBits; memcpy( &lBits, &pValue, sizeof(lBits) ); return lBits; }
+inline float floatFromBits( uint32_t pBits ) { float lValue; memcpy( &lValue, &pBits, sizeof(lValue) ); return lValue; }
+
+inline Float4 float4And( Float4 a, Float4 b )
+{
+	for( int i = 0; i < 4; ++i ) a.v[i] = floatFromBits( floatBits( a.v[i] ) & floatBits( b.v[i] ) );
+	return a;
+}
+
+inline Float4 float4Xor( Float4 a, Float4 b )
+{
+	for( int i = 0; i < 4; ++i ) a.v[i] = floatFromBits( floatBits( a.v[i] ) ^ floatBits( b.v[i] ) );
+	return a;
+}
+
+inline Float4 float4Select( Float4 pMask, Float4 a, Float4 b )
+{
+	for( int i = 0; i < 4; ++i ) a.v[i] = (floatBits( pMask.v[i] ) != 0) ? a.v[i] : b.v[i];
+	return a;
+}
+
+template<int pBit>
+inline Float4 float4BitToSign( Float4 a )
+{
+	for( int i = 0; i < 4; ++i ) a.v[i] = floatFromBits( (floatBits( a.v[i] ) << (31 - pBit)) & 0x80000000u );
+	return a;
+}
+
+template<int pBit>
+inline Float4 float4BitToMask( Float4 a )
+{
+	for( int i = 0; i < 4; ++i ) a.v[i] = floatFromBits( ((floatBits( a.v[i] ) >> pBit) & 1) ? 0xffffffffu : 0 );
+	return a;
+}
+
+struct Int16x8 { int16_t v[8]; };
+
+inline Int16x8 int16x8Load( const int16_t* pValues ) { Int16x8 r; for( int i = 0; i < 8; ++i ) r.v[i] = pValues[i]; return r; }
+inline void int16x8Store( int16_t* pValues, Int16x8 a ) { for( int i = 0; i < 8; ++i ) pValues[i] = a.v[i]; }
+inline Int16x8 int16x8Splat( int16_t pValue ) { Int16x8 r; for( int i = 0; i < 8; ++i ) r.v[i] = pValue; return r; }
+inline Int16x8 int16x8LoadInt8( const int8_t* pValues ) { Int16x8 r; for( int i = 0; i < 8; ++i ) r.v[i] = pValues[i]; return r; }
+inline Int16x8 int16x8Add( Int16x8 a, Int16x8 b ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(a.v[i] + b.v[i]); return a; }
+inline Int16x8 int16x8Sub( Int16x8 a, Int16x8 b ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(a.v[i] - b.v[i]); return a; }
+inline Int16x8 int16x8Or( Int16x8 a, Int16x8 b ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(a.v[i] | b.v[i]); return a; }
+inline Int16x8 int16x8MulHigh( Int16x8 a, Int16x8 b ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(((int32_t) a.v[i] * b.v[i]) >> 16); return a; }
+
+template<int pBits>
+inline Int16x8 int16x8ShiftRight( Int16x8 a ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(a.v[i] >> pBits); return a; }
+
+template<int pBits>
+inline Int16x8 int16x8ShiftLeft( Int16x8 a ) { for( int i = 0; i < 8; ++i ) a.v[i] = (int16_t)(uint16_t)((uint16_t) a.v[i] << pBits); return a; }
+
+inline Int16x8 int16x8Greater( Int16x8 a, Int16x8 b ) { for( int i = 0; i < 8; ++i ) a.v[i] = (a.v[i] > b.v[i]) ? -1 : 0; return a; }
+
+inline bool int16x8Any( Int16x8 pMask )
+{
+	int16_t lAny = 0;
+
+	for( int i = 0; i < 8; ++i )
+		lAny |= pMask.v[i];
+
+	return lAny != 0;
+}
+
+#endif
+
+}
+
+}
+#endif // _GUILDHALL_SIMD_H_
@@ -0,0 +1,267 @@
+#include "simulation_log.h"
+#include "log.h"
+
+#include <string.h>
+
+namespace guildhall {
+
+namespace {
+
+const char LogMagic[4] = { 'S', 'F', 'R', 'L' };
+const uint32_t LogVersion = 1;
+
+const uint8_t RecordSteps = 'S';
+const uint8_t RecordEvent = 'E';
+const uint8_t RecordChecksum = 'C';
+
+}
+
+SimulationRecorder::SimulationRecorder() :
+		m_file( NULL ),
+		m_step( 0 ),
+		m_runElapsed( 0.0f ),
+		m_runCount( 0 )
+{
+}
+
+SimulationRecorder::~SimulationRecorder()
+{
+	close();
+}
+
+status SimulationRecorder::open( const char* pPath, int32_t pFlakeCount, uint32_t pSeed )
+{
+	close();
+
+	m_file = fopen( pPath, "wb" );
+
+	if( m_file == NULL )
+	{
+		Log::error( "Unable to record the simulation to %s", pPath );
+		return STATUS_ERROR;
+	}
+
+	m_step = 0;
+	m_runCount = 0;
+
+	fwrite( LogMagic, sizeof(LogMagic), 1, m_file );
+	fwrite( &LogVersion, sizeof(LogVersion), 1, m_file );
+	fwrite( &pFlakeCount, sizeof(pFlakeCount), 1, m_file );
+	fwrite( &pSeed, sizeof(pSeed), 1, m_file );
+
+	Log::info( "Recording the simulation to %s", pPath );
+	return STATUS_OK;
+}
+
+status SimulationRecorder::close()
+{
+	if( m_file == NULL )
+		return STATUS_OK;
+
+	flushSteps();
+
+	bool lWritten = (ferror( m_file ) == 0);
+
+	if( fclose( m_file ) != 0 )
+		lWritten = false;
+
+	m_file = NULL;
+
+	if( !lWritten )
+	{
+		Log::error( "Unable to write the simulation log." );
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+void SimulationRecorder::recordEvent( const SimulationEvent& pEvent )
+{
+	if( m_file == NULL )
+		return;
+
+	flushSteps();
+
+	fwrite( &RecordEvent, sizeof(RecordEvent), 1, m_file );
+	fwrite( &pEvent.m_type, sizeof(pEvent.m_type), 1, m_file );
+	fwrite( pEvent.m_values, sizeof(pEvent.m_values), 1, m_file );
+}
+
+void SimulationRecorder::recordStep( float pElapsed, const SnowFlakes& pFlakes )
+{
+	if( m_file == NULL )
+		return;
+
+	// Compared bit for bit, -0.0f and NaN timesteps included.
+	if( m_runCount > 0 && memcmp( &pElapsed, &m_runElapsed, sizeof(pElapsed) ) != 0 )
+		flushSteps();
+
+	m_runElapsed = pElapsed;
+	++m_runCount;
+	++m_step;
+
+	if( m_step % ChecksumInterval == 0 )
+	{
+		uint64_t lChecksum = pFlakes.computeChecksum();
+
+		flushSteps();
+
+		fwrite( &RecordChecksum, sizeof(RecordChecksum), 1, m_file );
+		fwrite( &m_step, sizeof(m_step), 1, m_file );
+		fwrite( &lChecksum, sizeof(lChecksum), 1, m_file );
+	}
+}
+
+void SimulationRecorder::flushSteps()
+{
+	if( m_runCount == 0 )
+		return;
+
+	fwrite( &RecordSteps, sizeof(RecordSteps), 1, m_file );
+	fwrite( &m_runElapsed, sizeof(m_runElapsed), 1, m_file );
+	fwrite( &m_runCount, sizeof(m_runCount), 1, m_file );
+
+	m_runCount = 0;
+}
+
+SimulationPlayer::SimulationPlayer() :
+		m_offset( 0 ),
+		m_flakeCount( 0 ),
+		m_seed( 0 ),
+		m_step( 0 ),
+		m_runElapsed( 0.0f ),
+		m_runCount( 0 )
+{
+}
+
+status SimulationPlayer::open( const char* pPath )
+{
+	close();
+
+	FILE* lFile = fopen( pPath, "rb" );
+
+	if( lFile == NULL )
+	{
+		Log::error( "Unable to open the simulation log %s", pPath );
+		return STATUS_ERROR;
+	}
+
+	uint8_t lBuffer[4096];
+	size_t lRead;
+
+	while( (lRead = fread( lBuffer, 1, sizeof(lBuffer), lFile )) > 0 )
+		m_data.insert( m_data.end(), lBuffer, lBuffer + lRead );
+
+	fclose( lFile );
+
+	char lMagic[4];
+	uint32_t lVersion = 0;
+
+	if( !read( lMagic, sizeof(lMagic) ) || memcmp( lMagic, LogMagic, sizeof(lMagic) ) != 0 ||
+			!read( &lVersion, sizeof(lVersion) ) || lVersion != LogVersion ||
+			!read( &m_flakeCount, sizeof(m_flakeCount) ) || !read( &m_seed, sizeof(m_seed) ) )
+	{
+		Log::error( "%s is not a simulation log.", pPath );
+		close();
+		return STATUS_ERROR;
+	}
+
+	Log::info( "Replaying %s: %d flakes, seed %u", pPath, m_flakeCount, m_seed );
+	return STATUS_OK;
+}
+
+void SimulationPlayer::close()
+{
+	m_data.clear();
+	m_offset = 0;
+	m_flakeCount = 0;
+	m_seed = 0;
+	m_step = 0;
+	m_runCount = 0;
+}
+
+bool SimulationPlayer::nextStep( float* pElapsed, std::vector<SimulationEvent>* pEvents )
+{
+	while( m_runCount == 0 )
+	{
+		uint8_t lRecord;
+
+		if( !read( &lRecord, sizeof(lRecord) ) )
+			return false;
+
+		if( lRecord == RecordSteps )
+		{
+			if( !read( &m_runElapsed, sizeof(m_runElapsed) ) || !read( &m_runCount, sizeof(m_runCount) ) )
+				return false;
+		}
+		else if( lRecord == RecordEvent )
+		{
+			SimulationEvent lEvent;
+
+			if( !read( &lEvent.m_type, sizeof(lEvent.m_type) ) || !read( lEvent.m_values, sizeof(lEvent.m_values) ) )
+				return false;
+
+			pEvents->push_back( lEvent );
+		}
+		else if( lRecord == RecordChecksum )
+		{
+			// Left over when verify() was not called.
+			uint32_t lStep;
+			uint64_t lChecksum;
+
+			if( !read( &lStep, sizeof(lStep) ) || !read( &lChecksum, sizeof(lChecksum) ) )
+				return false;
+		}
+		else
+		{
+			Log::error( "Unknown record %u in the simulation log.", lRecord );
+			return false;
+		}
+	}
+
+	*pElapsed = m_runElapsed;
+	--m_runCount;
+	++m_step;
+	return true;
+}
+
+status SimulationPlayer::verify( const SnowFlakes& pFlakes )
+{
+	// Checksums only ever follow the last step of a run.
+	if( m_runCount > 0 || m_offset >= m_data.size() || m_data[m_offset] != RecordChecksum )
+		return STATUS_OK;
+
+	uint8_t lRecord;
+	uint32_t lStep;
+	uint64_t lChecksum;
+
+	if( !read( &lRecord, sizeof(lRecord) ) || !read( &lStep, sizeof(lStep) ) || !read( &lChecksum, sizeof(lChecksum) ) )
+		return STATUS_ERROR;
+
+	if( lStep != m_step )
+	{
+		Log::error( "The simulation log has a checksum for step %u at step %u.", lStep, m_step );
+		return STATUS_ERROR;
+	}
+
+	if( pFlakes.computeChecksum() != lChecksum )
+	{
+		Log::error( "The simulation diverged from the recording by step %u.", m_step );
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+bool SimulationPlayer::read( void* pData, size_t pSize )
+{
+	if( m_data.size() - m_offset < pSize )
+		return false;
+
+	memcpy( pData, &m_data[m_offset], pSize );
+	m_offset += pSize;
+	return true;
+}
+
+}
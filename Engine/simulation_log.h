@@ -0,0 +1,123 @@
+#ifndef _GUILDHALL_SIMULATION_LOG_H_
+#define _GUILDHALL_SIMULATION_LOG_H_
+
+#include "snowflakes.h"
+#include "types.h"
+
+#include <stdio.h>
+#include <vector>
+
+namespace guildhall {
+
+// Input and sensor events, in the units the platform reported them in.
+struct SimulationEvent
+{
+	enum Type
+	{
+		EVENT_TOUCH_DOWN,
+		EVENT_TOUCH_MOVE,
+		EVENT_TOUCH_UP,
+		EVENT_ACCELEROMETER
+	};
+
+	uint8_t m_type;
+	float m_values[3];   // x, y for touches; x, y, z for the accelerometer.
+};
+
+// Writes a simulation run to a compact binary log: the flake count and
+// seed, the timestep of every step, the events delivered before each step
+// and, every ChecksumInterval steps, a checksum of the flake state.
+// Replaying the log with SimulationPlayer repeats the run bit for bit, and
+// the checksums find the first step at which a different build of the
+// update kernel diverges.
+//
+// Layout, in the native byte order (little endian on every target):
+//
+//     header   "SFRL", uint32 version, int32 flake count, uint32 seed
+//     steps    uint8 'S', float elapsed, uint32 count   (a run of steps)
+//     event    uint8 'E', uint8 type, float values[3]
+//     checksum uint8 'C', uint32 step, uint64 checksum
+//
+// Runs of steps with the same timestep take one record, so a fixed rate
+// simulation costs a few bytes per second plus its events.
+class SimulationRecorder
+{
+public:
+
+	static const uint32_t ChecksumInterval = 60;
+
+	SimulationRecorder();
+	~SimulationRecorder();
+
+	status open( const char* pPath, int32_t pFlakeCount, uint32_t pSeed );
+	status close();
+	bool isOpen() const { return m_file != NULL; }
+
+	// Before the step the event is delivered to.
+	void recordEvent( const SimulationEvent& pEvent );
+
+	// After each step, with the flakes it stepped.
+	void recordStep( float pElapsed, const SnowFlakes& pFlakes );
+
+private:
+
+	SimulationRecorder( const SimulationRecorder& );
+	SimulationRecorder& operator = ( const SimulationRecorder& );
+
+	void flushSteps();
+
+private:
+
+	FILE* m_file;
+	uint32_t m_step;
+
+	// The run of steps not written yet.
+	float m_runElapsed;
+	uint32_t m_runCount;
+};
+
+// Reads back a log written by SimulationRecorder. The whole log is loaded
+// by open(), so replaying does no I/O.
+class SimulationPlayer
+{
+public:
+
+	SimulationPlayer();
+
+	status open( const char* pPath );
+	void close();
+	bool isOpen() const { return !m_data.empty(); }
+
+	int32_t getFlakeCount() const { return m_flakeCount; }
+	uint32_t getSeed() const { return m_seed; }
+
+	// Returns the timestep of the next step and appends the events to
+	// deliver before it to pEvents, or returns false at the end of the log.
+	bool nextStep( float* pElapsed, std::vector<SimulationEvent>* pEvents );
+
+	// After the step, with the flakes it stepped. STATUS_ERROR when they
+	// differ from the recording.
+	status verify( const SnowFlakes& pFlakes );
+
+	uint32_t getStep() const { return m_step; }
+
+private:
+
+	bool read( void* pData, size_t pSize );
+
+private:
+
+	std::vector<uint8_t> m_data;
+	size_t m_offset;
+
+	int32_t m_flakeCount;
+	uint32_t m_seed;
+	uint32_t m_step;
+
+	// What is left of the current run of steps.
+	float m_runElapsed;
+	uint32_t m_runCount;
+};
+
+}
+#endif // _GUILDHALL_SIMULATION_LOG_H_
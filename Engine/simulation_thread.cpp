@@ -0,0 +1,223 @@
+#include "simulation_thread.h"
+#include "log.h"
+#include "profiler.h"
+#include "timer.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace guildhall {
+
+SimulationThread::SimulationThread( int32_t pFlakeCount ) :
+		m_flakes( pFlakeCount ),
+		m_running( false ),
+		m_replayDiverged( false ),
+		m_published( 0 ),
+		m_dropped( 0 ),
+		m_acquiredFresh( false )
+{
+	for( int32_t i = 0; i < 3; ++i )
+	{
+		m_snapshots[i] = new SnowFlakes( pFlakeCount );
+		m_snapshotTimes[i] = 0.0;
+	}
+
+	resetStats();
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+
+	for( int32_t i = 0; i < 3; ++i )
+	{
+		delete m_snapshots[i];
+	}
+}
+
+void SimulationThread::start( uint32_t pSeed )
+{
+	stop();
+
+	uint32_t lSeed = pSeed;
+	m_replayDiverged.store( false );
+
+	if( !m_replayPath.empty() && m_player.open( m_replayPath.c_str() ) == STATUS_OK )
+	{
+		if( m_player.getFlakeCount() == m_flakes.getCount() )
+		{
+			lSeed = m_player.getSeed();
+		}
+		else
+		{
+			Log::error( "The simulation log has %d flakes instead of %d, it is not replayed.",
+					m_player.getFlakeCount(), m_flakes.getCount() );
+			m_player.close();
+		}
+	}
+
+	if( !m_recordPath.empty() )
+		m_recorder.open( m_recordPath.c_str(), m_flakes.getCount(), lSeed );
+
+	{
+		std::lock_guard<std::mutex> lLock( m_eventMutex );
+		m_events.clear();
+	}
+
+	m_flakes.spawn( lSeed );
+
+	// The renderer always has something to draw, even before the first
+	// step.
+	publish();
+
+	m_running.store( true );
+	m_thread = std::thread( &SimulationThread::run, this );
+}
+
+void SimulationThread::stop()
+{
+	if( !m_thread.joinable() )
+		return;
+
+	m_running.store( false );
+	m_thread.join();
+
+	m_recorder.close();
+	m_player.close();
+}
+
+void SimulationThread::setRecordPath( const char* pPath )
+{
+	m_recordPath = (pPath != NULL) ? pPath : "";
+}
+
+void SimulationThread::setReplayPath( const char* pPath )
+{
+	m_replayPath = (pPath != NULL) ? pPath : "";
+}
+
+void SimulationThread::postEvent( const SimulationEvent& pEvent )
+{
+	std::lock_guard<std::mutex> lLock( m_eventMutex );
+	m_events.push_back( pEvent );
+}
+
+const SnowFlakes& SimulationThread::acquire()
+{
+	m_acquiredFresh = m_handoff.acquire();
+	return *m_snapshots[m_handoff.getReadSlot()];
+}
+
+void SimulationThread::present()
+{
+	double lAge = getCurrentTimeInSeconds() - m_snapshotTimes[m_handoff.getReadSlot()];
+
+	++m_renderStats.m_presented;
+
+	if( !m_acquiredFresh )
+		++m_renderStats.m_duplicated;
+
+	m_renderStats.m_ageTotal += lAge;
+
+	if( lAge > m_renderStats.m_ageMax )
+		m_renderStats.m_ageMax = lAge;
+
+	// A snapshot only counts as a duplicate from its second present on.
+	m_acquiredFresh = false;
+}
+
+void SimulationThread::getStats( HandoffStats* pStats ) const
+{
+	*pStats = m_renderStats;
+	pStats->m_published = m_published.load( std::memory_order_relaxed );
+	pStats->m_dropped = m_dropped.load( std::memory_order_relaxed );
+}
+
+void SimulationThread::resetStats()
+{
+	memset( &m_renderStats, 0, sizeof(m_renderStats) );
+	m_published.store( 0, std::memory_order_relaxed );
+	m_dropped.store( 0, std::memory_order_relaxed );
+}
+
+void SimulationThread::publish()
+{
+	int32_t lSlot = m_handoff.getWriteSlot();
+
+	m_snapshots[lSlot]->copyRenderState( m_flakes );
+	m_snapshotTimes[lSlot] = getCurrentTimeInSeconds();
+
+	if( m_handoff.publish() )
+		m_dropped.fetch_add( 1, std::memory_order_relaxed );
+
+	m_published.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void SimulationThread::run()
+{
+	// SnowFlakes::update() moves flakes by a fixed amount per call, so the
+	// simulation keeps its own fixed clock instead of following the
+	// display.
+	const std::chrono::nanoseconds lStep( 1000000000 / SimulationRate );
+	std::chrono::steady_clock::time_point lNextStep = std::chrono::steady_clock::now();
+
+	GUILDHALL_PROFILE_THREAD( "Simulation" );
+
+	std::vector<SimulationEvent> lEvents;
+
+	while( m_running.load() )
+	{
+		{
+			GUILDHALL_PROFILE_ZONE( "Simulation step" );
+
+			float lElapsed = 1.0f / SimulationRate;
+			lEvents.clear();
+
+			{
+				std::lock_guard<std::mutex> lLock( m_eventMutex );
+
+				// While replaying, only the recorded events count.
+				if( m_player.isOpen() )
+					m_events.clear();
+				else
+					lEvents.swap( m_events );
+			}
+
+			if( m_player.isOpen() && !m_player.nextStep( &lElapsed, &lEvents ) )
+			{
+				Log::info( "Replay finished after %u steps.", m_player.getStep() );
+				return;
+			}
+
+			for( size_t i = 0; i < lEvents.size(); ++i )
+				m_recorder.recordEvent( lEvents[i] );
+
+			m_flakes.update( lElapsed );
+			m_recorder.recordStep( lElapsed, m_flakes );
+
+			if( m_player.isOpen() && m_player.verify( m_flakes ) != STATUS_OK )
+			{
+				// Whatever follows would not be the recorded run either.
+				Log::error( "Replay stopped after %u steps.", m_player.getStep() );
+				m_replayDiverged.store( true );
+				publish();
+				return;
+			}
+
+			publish();
+		}
+
+		lNextStep += lStep;
+
+		// After a long stall, catch up with the present instead of
+		// stepping as fast as possible until the clock is reached.
+		std::chrono::steady_clock::time_point lNow = std::chrono::steady_clock::now();
+
+		if( lNextStep < lNow - lStep )
+			lNextStep = lNow;
+
+		std::this_thread::sleep_until( lNextStep );
+	}
+}
+
+}
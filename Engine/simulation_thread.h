@@ -0,0 +1,114 @@
+#ifndef _GUILDHALL_SIMULATION_THREAD_H_
+#define _GUILDHALL_SIMULATION_THREAD_H_
+
+#include "simulation_log.h"
+#include "snowflakes.h"
+#include "triple_buffer.h"
+#include "types.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace guildhall {
+
+// Counters of the snapshot handoff between the simulation and the render
+// thread.
+struct HandoffStats
+{
+	uint32_t m_published;   // Snapshots the simulation produced.
+	uint32_t m_dropped;     // Replaced before the renderer took them.
+	uint32_t m_presented;   // Frames presented.
+	uint32_t m_duplicated;  // Frames that presented the previous snapshot again.
+	double m_ageTotal;      // Seconds from publish to present, summed over frames.
+	double m_ageMax;
+};
+
+// Steps the snow flakes on their own thread at SimulationRate, so that
+// neither a slow swap nor a slow update holds the other back. Each step
+// publishes a snapshot of what the renderer needs (positions, colours and
+// sizes) through a TripleBuffer.
+class SimulationThread
+{
+public:
+
+	static const int32_t SimulationRate = 60;
+
+	SimulationThread( int32_t pFlakeCount );
+	~SimulationThread();
+
+	// Spawns the flakes from pSeed, publishes them and starts stepping.
+	void start( uint32_t pSeed );
+	void stop();
+
+	// Before start(). Records every step, and the events before it, to
+	// pPath, see SimulationRecorder. NULL stops recording.
+	void setRecordPath( const char* pPath );
+
+	// Before start(). Takes the seed, the timesteps and the events from the
+	// log at pPath instead, still at SimulationRate, and stops stepping at
+	// its end, or as soon as the flakes differ from the recording. NULL
+	// stops replaying.
+	void setReplayPath( const char* pPath );
+
+	// Any thread. True once the replay started by the last start() has
+	// differed from its recording.
+	bool hasReplayDiverged() const { return m_replayDiverged.load(); }
+
+	// Any thread. Delivered to the simulation before its next step. The
+	// flakes do not react to any events yet; they are recorded so that
+	// runs stay reproducible once they do.
+	void postEvent( const SimulationEvent& pEvent );
+
+	// Render thread. Returns the newest published snapshot, which stays
+	// valid until the next acquire().
+	const SnowFlakes& acquire();
+
+	// Render thread, right before the acquired snapshot is presented.
+	void present();
+
+	// Render thread.
+	void getStats( HandoffStats* pStats ) const;
+	void resetStats();
+
+private:
+
+	SimulationThread( const SimulationThread& );
+	SimulationThread& operator = ( const SimulationThread& );
+
+	void publish();
+	void run();
+
+private:
+
+	SnowFlakes m_flakes;
+
+	TripleBuffer m_handoff;
+	SnowFlakes* m_snapshots[3];
+	double m_snapshotTimes[3];
+
+	std::thread m_thread;
+	std::atomic<bool> m_running;
+
+	std::string m_recordPath;
+	std::string m_replayPath;
+	SimulationRecorder m_recorder;
+	SimulationPlayer m_player;
+	std::atomic<bool> m_replayDiverged;
+
+	std::mutex m_eventMutex;
+	std::vector<SimulationEvent> m_events;
+
+	// Written by the simulation thread.
+	std::atomic<uint32_t> m_published;
+	std::atomic<uint32_t> m_dropped;
+
+	// Render thread only.
+	bool m_acquiredFresh;
+	HandoffStats m_renderStats;
+};
+
+}
+#endif // _GUILDHALL_SIMULATION_THREAD_H_
@@ -0,0 +1,123 @@
+#include "snowflakes.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+
+#include <string.h>
+
+namespace guildhall {
+
+SnowFlakes::SnowFlakes( int32_t pCount ) :
+		m_count( pCount ),
+		m_pos( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 2 ) ),
+		m_vel( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 2 ) ),
+		m_col( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount * 4 ) ),
+		m_size( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount ) ),
+		m_timeSinceLastTurn( allocateArray<float>( MEMORY_CATEGORY_SIMULATION, pCount ) )
+{
+}
+
+SnowFlakes::~SnowFlakes()
+{
+	freeMemory( m_pos );
+	freeMemory( m_vel );
+	freeMemory( m_col );
+	freeMemory( m_size );
+	freeMemory( m_timeSinceLastTurn );
+}
+
+void SnowFlakes::spawn( uint32_t pSeed )
+{
+	m_random.seed( pSeed );
+
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		m_pos[i * 2 + 0] = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+		m_pos[i * 2 + 1] = m_random.nextFloat( -ViewMaxY, ViewMaxY );
+
+		m_vel[i * 2 + 0] = m_random.nextFloat( -0.004f, 0.004f ); // Flakes move side to side
+		m_vel[i * 2 + 1] = m_random.nextFloat( -0.01f, -0.008f ); // Flakes fall down
+
+		m_col[i * 4 + 0] = 1.0f;
+		m_col[i * 4 + 1] = 1.0f;
+		m_col[i * 4 + 2] = 1.0f;
+		m_col[i * 4 + 3] = 1.0f; //m_random.nextFloat( 0.6f, 1.0f ); // It seems that Doodle Jump snow does not use alpha.
+
+		m_size[i] = m_random.nextFloat( 3.0, 6.0f );
+
+		// It looks strange if the flakes all turn at the same time, so
+		// lets vary their turn times with a random negative value.
+		m_timeSinceLastTurn[i] = m_random.nextFloat( -5.0, 0.0f );
+	}
+}
+
+void SnowFlakes::copyRenderState( const SnowFlakes& pOther )
+{
+	memcpy( m_pos, pOther.m_pos, m_count * 2 * sizeof(float) );
+	memcpy( m_col, pOther.m_col, m_count * 4 * sizeof(float) );
+	memcpy( m_size, pOther.m_size, m_count * sizeof(float) );
+}
+
+uint64_t SnowFlakes::computeChecksum() const
+{
+	// 64 bit FNV-1a over 32 bit words, which is enough to tell runs apart
+	// and fast enough to take every second.
+	const float* lArrays[] = { m_pos, m_vel, m_col, m_size, m_timeSinceLastTurn };
+	const int32_t lWidths[] = { 2, 2, 4, 1, 1 };
+	uint64_t lHash = 0xcbf29ce484222325ULL;
+
+	for( int32_t i = 0; i < 5; ++i )
+	{
+		int32_t lCount = m_count * lWidths[i];
+
+		for( int32_t j = 0; j < lCount; ++j )
+		{
+			uint32_t lWord;
+			memcpy( &lWord, &lArrays[i][j], sizeof(lWord) );
+
+			lHash ^= lWord;
+			lHash *= 0x100000001b3ULL;
+		}
+	}
+
+	return lHash;
+}
+
+void SnowFlakes::update( float pElapsed )
+{
+	GUILDHALL_PROFILE_ZONE( "SnowFlakes::update" );
+
+	for( int32_t i = 0; i < m_count; ++i )
+	{
+		float* lPos = &m_pos[i * 2];
+		float* lVel = &m_vel[i * 2];
+
+		// Keep track of how long it has been since this flake turned
+		// or changed direction.
+		m_timeSinceLastTurn[i] += pElapsed;
+
+		if( m_timeSinceLastTurn[i] >= TimeTillTurn )
+		{
+			// Change or invert direction!
+			lVel[0] = -(lVel[0]);
+			m_timeSinceLastTurn[i] = m_random.nextFloat( -5.0, 0.0f );
+		}
+
+		// Speed up the flake up as it leaves the last turn and prepares for next turn.
+		float turnVelocityModifier = m_timeSinceLastTurn[i] * TimeTillTurnNormalizedUnit;
+
+		// Apply some velocity to simulate gravity and wind.
+		lPos[0] += (lVel[0] * turnVelocityModifier); // Side to side
+		lPos[1] += lVel[1]; // Gravity
+
+		// But, if the snow flake goes off the bottom or strays too far
+		// left or right - respawn it back to the top.
+		if( lPos[1] < -(ViewMaxY + 0.2f) ||
+			lPos[0] < -(ViewMaxX + 0.2f) || lPos[0] > (ViewMaxX + 0.2f) )
+		{
+			lPos[0] = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+			lPos[1] = 3.1;
+		}
+	}
+}
+
+}
@@ -0,0 +1,68 @@
+#ifndef _GUILDHALL_SNOWFLAKES_H_
+#define _GUILDHALL_SNOWFLAKES_H_
+
+#include "random.h"
+#include "types.h"
+
+namespace guildhall {
+
+// The Game's view size or area is 2 units wide and 3 units high.
+const float ViewMaxX = 2;
+const float ViewMaxY = 3;
+
+// Each snow flake will wait 3 seconds - then turn or change direction.
+const float TimeTillTurn = 3.0f;
+const float TimeTillTurnNormalizedUnit = 1.0f / TimeTillTurn;
+
+// Snow flake simulation state. Fields are kept in separate arrays so that
+// positions, colors and sizes can be handed to OpenGL as they are.
+class SnowFlakes
+{
+public:
+
+	SnowFlakes( int32_t pCount );
+	~SnowFlakes();
+
+	// Scatters every flake over the view with a random speed and size.
+	// Everything random in the simulation comes from pSeed, so the same
+	// seed and timesteps always produce the same flakes.
+	void spawn( uint32_t pSeed );
+	void update( float pElapsed );
+
+	// Hash of the whole simulation state, for comparing runs.
+	uint64_t computeChecksum() const;
+
+	// Copies the positions, colors and sizes of pOther, which must have
+	// the same count. Velocities and turn timers are left alone.
+	void copyRenderState( const SnowFlakes& pOther );
+
+	int32_t getCount() const { return m_count; }
+	const float* getPositions() const { return m_pos; }
+	const float* getColors() const { return m_col; }
+	const float* getSizes() const { return m_size; }
+
+	// The rest of the state, for CompactSnowFlakes::assign().
+	const float* getVelocities() const { return m_vel; }
+	const float* getTurnTimers() const { return m_timeSinceLastTurn; }
+	const Random& getRandom() const { return m_random; }
+
+private:
+
+	SnowFlakes( const SnowFlakes& );
+	SnowFlakes& operator = ( const SnowFlakes& );
+
+private:
+
+	int32_t m_count;
+
+	float* m_pos;   // x, y
+	float* m_vel;   // x, y
+	float* m_col;   // r, g, b, a
+	float* m_size;
+	float* m_timeSinceLastTurn;
+
+	Random m_random;
+};
+
+}
+#endif // _GUILDHALL_SNOWFLAKES_H_
@@ -0,0 +1,376 @@
+#include "software_renderer.h"
+#include "kernels.h"
+#include "log.h"
+#include "point_transform.h"
+#include "profiler.h"
+#include "simd.h"
+#include "timer.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace guildhall {
+
+namespace {
+
+const int32_t TileSize = 64;
+
+// Enough for the sprites and bins of about a thousand flakes; the arena
+// grows to fit more.
+const size_t FrameArenaBlockSize = 64 * 1024;
+
+// Doodle jump sky color (or something like it).
+const float SkyColor[4] = { 0.31f, 0.43f, 0.63f, 1.0f };
+
+// OpenGL rasterizes points with their window position and size on a grid
+// of sub-pixels; ES asks for at least 4 bits of them, Mesa and most GPUs
+// have 8.
+const float SubpixelSteps = 256.0f;
+
+inline float snapToSubpixel( float pValue )
+{
+	return rintf( pValue * SubpixelSteps ) / SubpixelSteps;
+}
+
+inline int32_t clampInt( int32_t pValue, int32_t pMin, int32_t pMax )
+{
+	return (pValue < pMin) ? pMin : (pValue > pMax) ? pMax : pValue;
+}
+
+}
+
+SoftwareRenderer::SoftwareRenderer( int32_t pThreadCount ) :
+		m_threadCount( pThreadCount > 0 ? pThreadCount : 1 ),
+		m_width( 0 ),
+		m_height( 0 ),
+		m_tilesX( 0 ),
+		m_tilesY( 0 ),
+		m_pixelsPerSecond( 0.0 ),
+		m_frameArena( MEMORY_CATEGORY_FRAME, FrameArenaBlockSize ),
+		m_sprites( NULL ),
+		m_binStarts( NULL ),
+		m_binEntries( NULL ),
+		m_textureWidth( 0 ),
+		m_textureHeight( 0 ),
+		m_frame( 0 ),
+		m_activeWorkers( 0 ),
+		m_stopping( false ),
+		m_nextTile( 0 ),
+		m_pixelCount( 0 )
+{
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+	release();
+}
+
+status SoftwareRenderer::initialize( const Image& pImage, int32_t pWidth, int32_t pHeight )
+{
+	if( pImage.m_texels.empty() || pWidth <= 0 || pHeight <= 0 )
+	{
+		Log::error( "Software renderer needs a decoded image and a size." );
+		return STATUS_ERROR;
+	}
+
+	release();
+
+	m_width = pWidth;
+	m_height = pHeight;
+	m_tilesX = (pWidth + TileSize - 1) / TileSize;
+	m_tilesY = (pHeight + TileSize - 1) / TileSize;
+	m_colorBuffer.assign( pWidth * pHeight, 0 );
+
+	m_projection = Affine2f::createOrthographicProjection( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY );
+
+	m_textureWidth = pImage.m_width;
+	m_textureHeight = pImage.m_height;
+	m_texels = pImage.m_texels;
+
+	m_stopping = false;
+
+	for( int32_t i = 1; i < m_threadCount; ++i )
+	{
+		m_workers.push_back( std::thread( &SoftwareRenderer::run, this ) );
+	}
+
+	return STATUS_OK;
+}
+
+void SoftwareRenderer::release()
+{
+	{
+		std::lock_guard<std::mutex> lLock( m_mutex );
+		m_stopping = true;
+	}
+
+	m_startCondition.notify_all();
+
+	for( size_t i = 0; i < m_workers.size(); ++i )
+	{
+		m_workers[i].join();
+	}
+
+	m_workers.clear();
+}
+
+void SoftwareRenderer::draw( const SnowFlakes& pSnowFlakes )
+{
+	GUILDHALL_PROFILE_ZONE( "SoftwareRenderer::draw" );
+
+	double lStart = getCurrentTimeInSeconds();
+
+	if( bin( pSnowFlakes ) != STATUS_OK )
+	{
+		Log::error( "Out of memory for the software renderer's frame." );
+		return;
+	}
+
+	shadeTiles();
+
+	double lTime = getCurrentTimeInSeconds() - lStart;
+	m_pixelsPerSecond = (lTime > 0.0) ? m_pixelCount.load() / lTime : 0.0;
+}
+
+status SoftwareRenderer::bin( const SnowFlakes& pSnowFlakes )
+{
+	GUILDHALL_PROFILE_ZONE( "Bin sprites" );
+
+	int32_t lCount = m_culler.cull( pSnowFlakes, m_projection, m_width, m_height );
+	const float* lPositions = m_culler.getPositions();
+	const float* lColors = m_culler.getColors();
+	const float* lSizes = m_culler.getSizes();
+	int32_t lTileCount = m_tilesX * m_tilesY;
+
+	// Last frame's sprites and bins are done with.
+	m_frameArena.reset();
+
+	float* lClipPositions = m_frameArena.allocateArray<float>( lCount * 2 );
+	m_sprites = m_frameArena.allocateArray<Sprite>( lCount );
+	m_binStarts = m_frameArena.allocateArray<int32_t>( lTileCount + 1 );
+
+	if( lClipPositions == NULL || m_sprites == NULL || m_binStarts == NULL )
+		return STATUS_ERROR;
+
+	transformPackedPoints2D( m_projection, lPositions, lClipPositions, lCount, NULL );
+
+	float lHalfWidth = m_width * 0.5f;
+	float lHalfHeight = m_height * 0.5f;
+
+	memset( m_binStarts, 0, (lTileCount + 1) * sizeof(int32_t) );
+
+	// Sprites, and how many go into each tile.
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		Sprite& lSprite = m_sprites[i];
+
+		// Viewport transform, in the spec's order so that the rounding is
+		// OpenGL's.
+		lSprite.m_x = lClipPositions[i * 2 + 0] * lHalfWidth + lHalfWidth;
+		lSprite.m_y = lClipPositions[i * 2 + 1] * lHalfHeight + lHalfHeight;
+
+		// The snapped size sets both the coverage and the gl_PointCoord
+		// step, so a texel boundary falls where OpenGL puts it.
+		float lSize = snapToSubpixel( lSizes[i] );
+		lSprite.m_size = (lSize < 1.0f) ? 1.0f : lSize;
+
+		for( int32_t c = 0; c < 4; ++c )
+		{
+			lSprite.m_color[c] = lColors[i * 4 + c];
+		}
+
+		// Pixels whose centre lies within [centre - size/2, centre + size/2),
+		// with the centre snapped too. gl_PointCoord is interpolated from
+		// the exact one.
+		float lRadius = lSprite.m_size * 0.5f;
+		float lCornerX = snapToSubpixel( lSprite.m_x - 0.5f );
+		float lCornerY = snapToSubpixel( lSprite.m_y - 0.5f );
+
+		lSprite.m_minX = (int32_t) ceilf( lCornerX - lRadius );
+		lSprite.m_maxX = (int32_t) ceilf( lCornerX + lRadius );
+		lSprite.m_minY = (int32_t) ceilf( lCornerY - lRadius );
+		lSprite.m_maxY = (int32_t) ceilf( lCornerY + lRadius );
+
+		if( lSprite.m_maxX <= 0 || lSprite.m_maxY <= 0 || lSprite.m_minX >= m_width || lSprite.m_minY >= m_height )
+		{
+			lSprite.m_tileMinX = lSprite.m_tileMinY = 0;
+			lSprite.m_tileMaxX = lSprite.m_tileMaxY = -1;
+			continue;
+		}
+
+		lSprite.m_tileMinX = clampInt( lSprite.m_minX, 0, m_width - 1 ) / TileSize;
+		lSprite.m_tileMaxX = clampInt( lSprite.m_maxX - 1, 0, m_width - 1 ) / TileSize;
+		lSprite.m_tileMinY = clampInt( lSprite.m_minY, 0, m_height - 1 ) / TileSize;
+		lSprite.m_tileMaxY = clampInt( lSprite.m_maxY - 1, 0, m_height - 1 ) / TileSize;
+
+		for( int32_t ty = lSprite.m_tileMinY; ty <= lSprite.m_tileMaxY; ++ty )
+		{
+			for( int32_t tx = lSprite.m_tileMinX; tx <= lSprite.m_tileMaxX; ++tx )
+			{
+				++m_binStarts[ty * m_tilesX + tx + 1];
+			}
+		}
+	}
+
+	for( int32_t t = 0; t < lTileCount; ++t )
+	{
+		m_binStarts[t + 1] += m_binStarts[t];
+	}
+
+	m_binEntries = m_frameArena.allocateArray<int32_t>( m_binStarts[lTileCount] );
+	int32_t* lNext = m_frameArena.allocateArray<int32_t>( lTileCount );
+
+	if( m_binEntries == NULL || lNext == NULL )
+		return STATUS_ERROR;
+
+	memcpy( lNext, m_binStarts, lTileCount * sizeof(int32_t) );
+
+	// Bins are filled in flake order, which keeps the blend order (and so
+	// the rounding of every blend) the same as OpenGL's.
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		const Sprite& lSprite = m_sprites[i];
+
+		for( int32_t ty = lSprite.m_tileMinY; ty <= lSprite.m_tileMaxY; ++ty )
+		{
+			for( int32_t tx = lSprite.m_tileMinX; tx <= lSprite.m_tileMaxX; ++tx )
+			{
+				m_binEntries[lNext[ty * m_tilesX + tx]++] = i;
+			}
+		}
+	}
+
+	return STATUS_OK;
+}
+
+void SoftwareRenderer::shadeTiles()
+{
+	m_nextTile.store( 0 );
+	m_pixelCount.store( 0 );
+
+	{
+		std::lock_guard<std::mutex> lLock( m_mutex );
+		m_activeWorkers = (int32_t) m_workers.size();
+		++m_frame;
+	}
+
+	m_startCondition.notify_all();
+
+	// The calling thread shades tiles too.
+	int32_t lTileCount = m_tilesX * m_tilesY;
+	int64_t lPixels = 0;
+	int32_t lTile;
+
+	while( (lTile = m_nextTile.fetch_add( 1 )) < lTileCount )
+	{
+		lPixels += shadeTile( lTile );
+	}
+
+	m_pixelCount.fetch_add( lPixels );
+
+	std::unique_lock<std::mutex> lLock( m_mutex );
+
+	while( m_activeWorkers > 0 )
+	{
+		m_doneCondition.wait( lLock );
+	}
+}
+
+int64_t SoftwareRenderer::shadeTile( int32_t pTile )
+{
+	GUILDHALL_PROFILE_ZONE( "Shade tile" );
+
+	int32_t lTileX0 = (pTile % m_tilesX) * TileSize;
+	int32_t lTileY0 = (pTile / m_tilesX) * TileSize;
+	int32_t lTileX1 = (lTileX0 + TileSize < m_width) ? lTileX0 + TileSize : m_width;
+	int32_t lTileY1 = (lTileY0 + TileSize < m_height) ? lTileY0 + TileSize : m_height;
+
+	// Clear.
+	uint32_t lSky = float4ToRgba8( float4Mul( float4Load( SkyColor ), float4Splat( 255.0f ) ) );
+
+	for( int32_t y = lTileY0; y < lTileY1; ++y )
+	{
+		uint32_t* lRow = &m_colorBuffer[y * m_width];
+
+		for( int32_t x = lTileX0; x < lTileX1; ++x )
+		{
+			lRow[x] = lSky;
+		}
+	}
+
+	const Kernels& lKernels = getKernels();
+	const Float4 lTexelScale = float4Splat( 1.0f / 255.0f );
+	int64_t lPixels = 0;
+
+	for( int32_t i = m_binStarts[pTile]; i < m_binStarts[pTile + 1]; ++i )
+	{
+		const Sprite& lSprite = m_sprites[m_binEntries[i]];
+		float lInvSize = 1.0f / lSprite.m_size;
+
+		int32_t lX0 = (lSprite.m_minX > lTileX0) ? lSprite.m_minX : lTileX0;
+		int32_t lY0 = (lSprite.m_minY > lTileY0) ? lSprite.m_minY : lTileY0;
+		int32_t lX1 = (lSprite.m_maxX < lTileX1) ? lSprite.m_maxX : lTileX1;
+		int32_t lY1 = (lSprite.m_maxY < lTileY1) ? lSprite.m_maxY : lTileY1;
+
+		if( lX0 >= lX1 || lY0 >= lY1 )
+			continue;
+
+		// Colour modulation with the texel's 0..255 range folded in.
+		float lColor[4];
+		float4Store( lColor, float4Mul( float4Load( lSprite.m_color ), lTexelScale ) );
+
+		for( int32_t y = lY0; y < lY1; ++y )
+		{
+			// gl_PointCoord has its origin at the top left of the sprite.
+			float t = 0.5f - ((y + 0.5f) - lSprite.m_y) * lInvSize;
+			int32_t lTexelY = clampInt( (int32_t) floorf( t * m_textureHeight ), 0, m_textureHeight - 1 );
+			const uint32_t* lTexelRow = &m_texels[lTexelY * m_textureWidth];
+			lKernels.m_blendSpriteRow( &m_colorBuffer[y * m_width], lX0, lX1, lTexelRow, m_textureWidth,
+					lSprite.m_x, lInvSize, lColor );
+		}
+
+		lPixels += (int64_t)(lX1 - lX0) * (lY1 - lY0);
+	}
+
+	return lPixels;
+}
+
+void SoftwareRenderer::run()
+{
+	uint32_t lFrame = 0;
+	std::unique_lock<std::mutex> lLock( m_mutex );
+
+	GUILDHALL_PROFILE_THREAD( "Software renderer" );
+
+	while( true )
+	{
+		while( !m_stopping && m_frame == lFrame )
+		{
+			m_startCondition.wait( lLock );
+		}
+
+		if( m_stopping )
+			break;
+
+		lFrame = m_frame;
+		lLock.unlock();
+
+		int32_t lTileCount = m_tilesX * m_tilesY;
+		int64_t lPixels = 0;
+		int32_t lTile;
+
+		while( (lTile = m_nextTile.fetch_add( 1 )) < lTileCount )
+		{
+			lPixels += shadeTile( lTile );
+		}
+
+		m_pixelCount.fetch_add( lPixels );
+
+		lLock.lock();
+
+		if( --m_activeWorkers == 0 )
+			m_doneCondition.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef _GUILDHALL_SOFTWARE_RENDERER_H_
+#define _GUILDHALL_SOFTWARE_RENDERER_H_
+
+#include "arena.h"
+#include "flake_culler.h"
+#include "image.h"
+#include "renderer.h"
+#include "types.h"
+#include "vecmath.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace guildhall {
+
+// CPU reproduction of SnowRenderer's output, for devices with broken GLES
+// drivers and golden images on machines without a GPU. Flakes are binned
+// into screen tiles, then tiles are shaded in parallel: textured point
+// sprites modulated by the flake colour and blended additively
+// (GL_SRC_ALPHA, GL_ONE) over the sky clear colour, four channels at a
+// time with SIMD. The sprites and bins of a frame live in a frame arena,
+// so drawing makes no allocations once the flake count stops growing.
+class SoftwareRenderer : public Renderer
+{
+public:
+
+	// pThreadCount includes the calling thread.
+	SoftwareRenderer( int32_t pThreadCount );
+	~SoftwareRenderer();
+
+	status initialize( const Image& pImage, int32_t pWidth, int32_t pHeight );
+	virtual void release();
+	virtual void draw( const SnowFlakes& pSnowFlakes );
+
+	// RGBA pixels, bottom row first like glReadPixels().
+	const uint32_t* getPixels() const { return &m_colorBuffer[0]; }
+	int32_t getWidth() const { return m_width; }
+	int32_t getHeight() const { return m_height; }
+
+	// Fragments shaded per second over the last draw().
+	double getPixelsPerSecond() const { return m_pixelsPerSecond; }
+
+	virtual float getCulledPercentage() const { return m_culler.getCulledPercentage(); }
+
+private:
+
+	// Screen space point sprite, set up once per flake and frame.
+	struct Sprite
+	{
+		float m_x, m_y;
+		float m_size;
+		float m_color[4];
+
+		// The pixels it covers, the maxima excluded.
+		int32_t m_minX, m_maxX;
+		int32_t m_minY, m_maxY;
+
+		// The tiles it covers; none when the minimum is above the maximum.
+		int32_t m_tileMinX, m_tileMaxX;
+		int32_t m_tileMinY, m_tileMaxY;
+	};
+
+	status bin( const SnowFlakes& pSnowFlakes );
+	void shadeTiles();
+	int64_t shadeTile( int32_t pTile );
+
+	void run();
+
+private:
+
+	int32_t m_threadCount;
+	int32_t m_width, m_height;
+	int32_t m_tilesX, m_tilesY;
+	double m_pixelsPerSecond;
+
+	Affine2f m_projection;
+	FlakeCuller m_culler;
+
+	std::vector<uint32_t> m_colorBuffer;
+
+	// Reset by every bin(). Tile t's sprites, in flake order, are
+	// m_binEntries[m_binStarts[t]] up to m_binEntries[m_binStarts[t + 1]].
+	Arena m_frameArena;
+	Sprite* m_sprites;
+	int32_t* m_binStarts;
+	int32_t* m_binEntries;
+
+	// Flake texture, RGBA, bottom row first.
+	std::vector<uint32_t> m_texels;
+	int32_t m_textureWidth, m_textureHeight;
+
+	// Workers sleep until the frame counter moves, then pull tiles off
+	// the shared tile counter.
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_doneCondition;
+	uint32_t m_frame;
+	int32_t m_activeWorkers;
+	bool m_stopping;
+	std::atomic<int32_t> m_nextTile;
+	std::atomic<int64_t> m_pixelCount;
+};
+
+}
+#endif // _GUILDHALL_SOFTWARE_RENDERER_H_
@@ -0,0 +1,30 @@
+#ifndef _GUILDHALL_TIMER_H_
+#define _GUILDHALL_TIMER_H_
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+namespace guildhall {
+
+inline double getCurrentTimeInSeconds()
+{
+#ifdef __APPLE__
+	// clock_gettime() only exists from iOS 10 on.
+	static mach_timebase_info_data_t lTimebase;
+
+	if( lTimebase.denom == 0 )
+		mach_timebase_info( &lTimebase );
+
+	return mach_absolute_time() * ((double) lTimebase.numer / lTimebase.denom) * 1.0e-9;
+#else
+	timespec lTimeVal;
+	clock_gettime( CLOCK_MONOTONIC, &lTimeVal );
+	return lTimeVal.tv_sec + (lTimeVal.tv_nsec * 1.0e-9);
+#endif
+}
+
+}
+#endif // _GUILDHALL_TIMER_H_
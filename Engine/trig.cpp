@@ -0,0 +1,61 @@
+#include "trig.h"
+#include "simd.h"
+
+namespace guildhall {
+
+void sinCosArray( const float* pAngles, float* pSin, float* pCos, int32_t pCount )
+{
+	const Float4 lLimit = float4Splat( SinCosRangeLimit );
+	const Float4 lTwoOverPi = float4Splat( trig::TwoOverPi );
+	const Float4 lRoundingShift = float4Splat( trig::RoundingShift );
+	const Float4 lHalf = float4Splat( 0.5f );
+	const Float4 lOne = float4Splat( 1.0f );
+
+	int32_t i = 0;
+
+	for( ; i + 4 <= pCount; i += 4 )
+	{
+		Float4 x = float4Load( pAngles + i );
+
+		// NaNs fail the comparison too.
+		if( float4LessEqualMask( float4Abs( x ), lLimit ) != 0xf )
+		{
+			for( int32_t j = i; j < i + 4; ++j )
+				sinCos( pAngles[j], pSin + j, pCos + j );
+
+			continue;
+		}
+
+		// The same steps as sinCos(), lane by lane.
+		Float4 lShifted = float4Madd( x, lTwoOverPi, lRoundingShift );
+		Float4 k = float4Sub( lShifted, lRoundingShift );
+
+		Float4 r = float4Sub( x, float4Mul( k, float4Splat( trig::PiOverTwo1 ) ) );
+		r = float4Sub( r, float4Mul( k, float4Splat( trig::PiOverTwo2 ) ) );
+		r = float4Sub( r, float4Mul( k, float4Splat( trig::PiOverTwo3 ) ) );
+		r = float4Sub( r, float4Mul( k, float4Splat( trig::PiOverTwo4 ) ) );
+		Float4 z = float4Mul( r, r );
+
+		Float4 s = float4Madd( float4Splat( trig::Sin3 ), z, float4Splat( trig::Sin2 ) );
+		s = float4Madd( s, z, float4Splat( trig::Sin1 ) );
+		s = float4Madd( float4Mul( s, z ), r, r );
+
+		Float4 c = float4Madd( float4Splat( trig::Cos3 ), z, float4Splat( trig::Cos2 ) );
+		c = float4Madd( c, z, float4Splat( trig::Cos1 ) );
+		c = float4Add( float4Sub( float4Mul( float4Mul( c, z ), z ), float4Mul( lHalf, z ) ), lOne );
+
+		// Quadrants 1 and 3 swap the two, 2 and 3 negate the sine, 1 and 2
+		// the cosine.
+		Float4 lSwap = float4BitToMask<0>( lShifted );
+		Float4 lSinSign = float4BitToSign<1>( lShifted );
+		Float4 lCosSign = float4Xor( lSinSign, float4BitToSign<0>( lShifted ) );
+
+		float4Store( pSin + i, float4Xor( float4Select( lSwap, c, s ), lSinSign ) );
+		float4Store( pCos + i, float4Xor( float4Select( lSwap, s, c ), lCosSign ) );
+	}
+
+	for( ; i < pCount; ++i )
+		sinCos( pAngles[i], pSin + i, pCos + i );
+}
+
+}
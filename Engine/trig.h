@@ -0,0 +1,97 @@
+#ifndef _GUILDHALL_TRIG_H_
+#define _GUILDHALL_TRIG_H_
+
+#include "types.h"
+
+#include <cmath>
+#include <string.h>
+
+namespace guildhall {
+
+// Sine and cosine together in float, for the matrix builders and for per
+// flake sways and rotations, where libm's separate double sin() and cos()
+// calls dominate. The angle is reduced to [-pi/4, pi/4] by the nearest
+// multiple of pi/2, subtracted in four parts so that the reduction loses
+// nothing that matters even next to a zero, and each result is a minimax
+// polynomial (Cephes sinf and cosf) of what is left.
+//
+// Within SinCosRangeLimit radians of zero both results are within 3 ULP
+// of the correctly rounded value; checked against libm for every float up
+// to the limit, and by micro_bench on a sample. Larger angles, infinities
+// and NaNs go to libm instead.
+//
+// sinCosArray() does whole arrays four angles at a time with SSE or NEON,
+// and gives the same results as sinCos() unless the compiler fuses the
+// latter's multiply-adds.
+
+const float SinCosRangeLimit = 16384.0f;
+
+namespace trig {
+
+const float TwoOverPi = 0.636619772367581343f;
+
+// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer, which
+// is then in the low bits of the sum.
+const float RoundingShift = 12582912.0f;
+
+// pi/2 as four floats. The first three have 10 significant bits, so k
+// times them is exact for any k the range limit allows.
+const float PiOverTwo1 = 1.5703125f;
+const float PiOverTwo2 = 4.839897155761719e-4f;
+const float PiOverTwo3 = -1.6298145055770874e-7f;
+const float PiOverTwo4 = 6.07710062827671e-11f;
+
+const float Sin1 = -1.6666654611e-1f;
+const float Sin2 = 8.3321608736e-3f;
+const float Sin3 = -1.9515295891e-4f;
+
+const float Cos1 = 4.166664568298827e-2f;
+const float Cos2 = -1.388731625493765e-3f;
+const float Cos3 = 2.443315711809948e-5f;
+
+}
+
+inline void sinCos( float pAngle, float* pSin, float* pCos )
+{
+	if( !(std::fabs( pAngle ) <= SinCosRangeLimit) )
+	{
+		*pSin = std::sin( pAngle );
+		*pCos = std::cos( pAngle );
+		return;
+	}
+
+	float lShifted = pAngle * trig::TwoOverPi + trig::RoundingShift;
+	float k = lShifted - trig::RoundingShift;
+
+	uint32_t lQuadrant;
+	memcpy( &lQuadrant, &lShifted, sizeof(lQuadrant) );
+
+	float r = (((pAngle - k * trig::PiOverTwo1) - k * trig::PiOverTwo2) - k * trig::PiOverTwo3) - k * trig::PiOverTwo4;
+	float z = r * r;
+
+	float s = ((trig::Sin3 * z + trig::Sin2) * z + trig::Sin1) * z * r + r;
+	float c = ((trig::Cos3 * z + trig::Cos2) * z + trig::Cos1) * z * z - 0.5f * z + 1.0f;
+
+	if( lQuadrant & 1 )
+	{
+		float t = s;
+		s = c;
+		c = t;
+	}
+
+	*pSin = (lQuadrant & 2) ? -s : s;
+	*pCos = ((lQuadrant ^ (lQuadrant >> 1)) & 1) ? -c : c;
+}
+
+// libm's, so that Mat4<double> keeps its precision.
+inline void sinCos( double pAngle, double* pSin, double* pCos )
+{
+	*pSin = std::sin( pAngle );
+	*pCos = std::cos( pAngle );
+}
+
+// pSin and pCos may not overlap pAngles or each other.
+void sinCosArray( const float* pAngles, float* pSin, float* pCos, int32_t pCount );
+
+}
+#endif // _GUILDHALL_TRIG_H_
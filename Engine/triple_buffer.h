@@ -0,0 +1,68 @@
+#ifndef _GUILDHALL_TRIPLE_BUFFER_H_
+#define _GUILDHALL_TRIPLE_BUFFER_H_
+
+#include "types.h"
+
+#include <atomic>
+
+namespace guildhall {
+
+// Hands the newest of a stream of snapshots from one writer thread to one
+// reader thread without locks. The caller owns three snapshot slots: the
+// writer fills getWriteSlot() and publishes it, the reader acquires and
+// then reads getReadSlot(). The third slot sits between them, so neither
+// side ever waits on the other. Snapshots the reader never got to are
+// replaced (latest wins).
+class TripleBuffer
+{
+public:
+
+	TripleBuffer() :
+			m_writeSlot( 0 ),
+			m_readSlot( 1 ),
+			m_middle( 2 )
+	{
+	}
+
+	// Writer thread.
+	int32_t getWriteSlot() const { return m_writeSlot; }
+
+	// Writer thread. Returns true when the previously published snapshot
+	// was replaced before the reader took it.
+	bool publish()
+	{
+		int32_t lPrevious = m_middle.exchange( m_writeSlot | FreshBit, std::memory_order_acq_rel );
+		m_writeSlot = lPrevious & SlotMask;
+		return (lPrevious & FreshBit) != 0;
+	}
+
+	// Reader thread. Returns false when nothing was published since the
+	// last acquire(), in which case the read slot is left as it was.
+	bool acquire()
+	{
+		if( (m_middle.load( std::memory_order_relaxed ) & FreshBit) == 0 )
+			return false;
+
+		int32_t lPrevious = m_middle.exchange( m_readSlot, std::memory_order_acq_rel );
+		m_readSlot = lPrevious & SlotMask;
+		return true;
+	}
+
+	// Reader thread.
+	int32_t getReadSlot() const { return m_readSlot; }
+
+private:
+
+	static const int32_t SlotMask = 3;
+	static const int32_t FreshBit = 4;
+
+	int32_t m_writeSlot;
+	int32_t m_readSlot;
+
+	// Slot index of the snapshot in the middle, plus FreshBit while it
+	// has not been read.
+	std::atomic<int32_t> m_middle;
+};
+
+}
+#endif // _GUILDHALL_TRIPLE_BUFFER_H_
@@ -0,0 +1,716 @@
+#ifndef _GUILDHALL_VECMATH_H_
+#define _GUILDHALL_VECMATH_H_
+
+#include "trig.h"
+
+#include <cmath>
+
+#define DEGTORAD(degree) ((degree) * (3.141592654f / 180.0f))
+#define RADTODEG(radian) ((radian) * (180.0f / 3.141592654f))
+
+namespace guildhall {
+
+// Small vectors and column-major matrices (laid out the way OpenGL takes
+// them), all in this header so that every operator inlines. Everything
+// that does not need sqrt or a trigonometric function is constexpr, and
+// nothing throws. The float rotations and perspective projection take
+// their sines and cosines from sinCos() in trig.h.
+//
+// Vector3f and Matrix4x4f are Vec3<float> and Mat4<float>; their original
+// interfaces are kept as they were, so the in-place methods such as
+// Mat4::translate() still replace the whole matrix. The float Mat4 is the
+// one exception to "all in this header": its operator *, transpose() and
+// inverses are SSE or NEON and live in matrix4x4f.cpp, while the constexpr
+// *Reference() versions stay here (see micro_bench, which checks one
+// against the other).
+//
+// Expressions such as a + b * s compile to straight-line arithmetic at -O2.
+// For chains of multiply-adds that should round once per step on hardware
+// with FMA, see vecmath_expression.h.
+
+template<typename T>
+struct Vec2
+{
+	T x;
+	T y;
+
+	constexpr Vec2() noexcept : x(), y() {}
+	constexpr Vec2( T pX, T pY ) noexcept : x( pX ), y( pY ) {}
+
+	constexpr void set( T pX, T pY ) noexcept { x = pX; y = pY; }
+
+	T length() const noexcept { return std::sqrt( x * x + y * y ); }
+
+	void normalize() noexcept
+	{
+		T lLength = length();
+		x = x / lLength;
+		y = y / lLength;
+	}
+
+	static constexpr T dotProduct( const Vec2& a, const Vec2& b ) noexcept { return a.x * b.x + a.y * b.y; }
+
+	constexpr Vec2 operator + ( const Vec2& pOther ) const noexcept { return Vec2( x + pOther.x, y + pOther.y ); }
+	constexpr Vec2 operator - ( const Vec2& pOther ) const noexcept { return Vec2( x - pOther.x, y - pOther.y ); }
+	constexpr Vec2 operator * ( const Vec2& pOther ) const noexcept { return Vec2( x * pOther.x, y * pOther.y ); }
+	constexpr Vec2 operator / ( const Vec2& pOther ) const noexcept { return Vec2( x / pOther.x, y / pOther.y ); }
+	constexpr Vec2 operator * ( T pScalar ) const noexcept { return Vec2( x * pScalar, y * pScalar ); }
+
+	constexpr Vec2& operator += ( const Vec2& pOther ) noexcept { x += pOther.x; y += pOther.y; return *this; }
+	constexpr Vec2& operator -= ( const Vec2& pOther ) noexcept { x -= pOther.x; y -= pOther.y; return *this; }
+	constexpr Vec2& operator *= ( T pScalar ) noexcept { x *= pScalar; y *= pScalar; return *this; }
+
+	constexpr Vec2 operator + () const noexcept { return *this; }
+	constexpr Vec2 operator - () const noexcept { return Vec2( -x, -y ); }
+};
+
+template<typename T>
+struct Vec3
+{
+	T x;
+	T y;
+	T z;
+
+	constexpr Vec3() noexcept : x(), y(), z() {}
+	constexpr Vec3( T pX, T pY, T pZ ) noexcept : x( pX ), y( pY ), z( pZ ) {}
+
+	constexpr void set( T pX, T pY, T pZ ) noexcept { x = pX; y = pY; z = pZ; }
+
+	T length() const noexcept { return std::sqrt( x * x + y * y + z * z ); }
+
+	void normalize() noexcept
+	{
+		T lLength = length();
+		x = x / lLength;
+		y = y / lLength;
+		z = z / lLength;
+	}
+
+	static T distance( const Vec3& a, const Vec3& b ) noexcept { return (a - b).length(); }
+	static constexpr T dotProduct( const Vec3& a, const Vec3& b ) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	static constexpr Vec3 crossProduct( const Vec3& a, const Vec3& b ) noexcept
+	{
+		return Vec3( a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x );
+	}
+
+	constexpr Vec3 operator + ( const Vec3& pOther ) const noexcept { return Vec3( x + pOther.x, y + pOther.y, z + pOther.z ); }
+	constexpr Vec3 operator - ( const Vec3& pOther ) const noexcept { return Vec3( x - pOther.x, y - pOther.y, z - pOther.z ); }
+	constexpr Vec3 operator * ( const Vec3& pOther ) const noexcept { return Vec3( x * pOther.x, y * pOther.y, z * pOther.z ); }
+	constexpr Vec3 operator / ( const Vec3& pOther ) const noexcept { return Vec3( x / pOther.x, y / pOther.y, z / pOther.z ); }
+	constexpr Vec3 operator * ( T pScalar ) const noexcept { return Vec3( x * pScalar, y * pScalar, z * pScalar ); }
+
+	constexpr Vec3& operator += ( const Vec3& pOther ) noexcept { x += pOther.x; y += pOther.y; z += pOther.z; return *this; }
+	constexpr Vec3& operator -= ( const Vec3& pOther ) noexcept { x -= pOther.x; y -= pOther.y; z -= pOther.z; return *this; }
+	constexpr Vec3& operator *= ( T pScalar ) noexcept { x *= pScalar; y *= pScalar; z *= pScalar; return *this; }
+
+	constexpr Vec3 operator + () const noexcept { return *this; }
+	constexpr Vec3 operator - () const noexcept { return Vec3( -x, -y, -z ); }
+};
+
+template<typename T>
+struct Vec4
+{
+	T x;
+	T y;
+	T z;
+	T w;
+
+	constexpr Vec4() noexcept : x(), y(), z(), w() {}
+	constexpr Vec4( T pX, T pY, T pZ, T pW ) noexcept : x( pX ), y( pY ), z( pZ ), w( pW ) {}
+	constexpr Vec4( const Vec3<T>& pXYZ, T pW ) noexcept : x( pXYZ.x ), y( pXYZ.y ), z( pXYZ.z ), w( pW ) {}
+
+	constexpr void set( T pX, T pY, T pZ, T pW ) noexcept { x = pX; y = pY; z = pZ; w = pW; }
+
+	T length() const noexcept { return std::sqrt( x * x + y * y + z * z + w * w ); }
+
+	static constexpr T dotProduct( const Vec4& a, const Vec4& b ) noexcept { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+	constexpr Vec4 operator + ( const Vec4& pOther ) const noexcept { return Vec4( x + pOther.x, y + pOther.y, z + pOther.z, w + pOther.w ); }
+	constexpr Vec4 operator - ( const Vec4& pOther ) const noexcept { return Vec4( x - pOther.x, y - pOther.y, z - pOther.z, w - pOther.w ); }
+	constexpr Vec4 operator * ( const Vec4& pOther ) const noexcept { return Vec4( x * pOther.x, y * pOther.y, z * pOther.z, w * pOther.w ); }
+	constexpr Vec4 operator / ( const Vec4& pOther ) const noexcept { return Vec4( x / pOther.x, y / pOther.y, z / pOther.z, w / pOther.w ); }
+	constexpr Vec4 operator * ( T pScalar ) const noexcept { return Vec4( x * pScalar, y * pScalar, z * pScalar, w * pScalar ); }
+
+	constexpr Vec4& operator += ( const Vec4& pOther ) noexcept { x += pOther.x; y += pOther.y; z += pOther.z; w += pOther.w; return *this; }
+	constexpr Vec4& operator -= ( const Vec4& pOther ) noexcept { x -= pOther.x; y -= pOther.y; z -= pOther.z; w -= pOther.w; return *this; }
+	constexpr Vec4& operator *= ( T pScalar ) noexcept { x *= pScalar; y *= pScalar; z *= pScalar; w *= pScalar; return *this; }
+
+	constexpr Vec4 operator + () const noexcept { return *this; }
+	constexpr Vec4 operator - () const noexcept { return Vec4( -x, -y, -z, -w ); }
+};
+
+// The scalar is not deduced, so that 2 * v converts the 2 as the member
+// operators do.
+template<typename T>
+struct Scalar { typedef T Type; };
+
+template<typename T>
+constexpr Vec2<T> operator * ( typename Scalar<T>::Type pScalar, const Vec2<T>& pVector ) noexcept { return pVector * pScalar; }
+
+template<typename T>
+constexpr Vec3<T> operator * ( typename Scalar<T>::Type pScalar, const Vec3<T>& pVector ) noexcept { return pVector * pScalar; }
+
+template<typename T>
+constexpr Vec4<T> operator * ( typename Scalar<T>::Type pScalar, const Vec4<T>& pVector ) noexcept { return pVector * pScalar; }
+
+// The constructors take the elements row by row, as they are written on
+// paper; m holds them column by column.
+template<typename T>
+struct Mat2
+{
+	T m[4];
+
+	constexpr Mat2() noexcept : m{ 1, 0, 0, 1 } {}
+	constexpr Mat2( T m0, T m2,
+	                T m1, T m3 ) noexcept : m{ m0, m1, m2, m3 } {}
+
+	constexpr T determinant() const noexcept { return m[0] * m[3] - m[2] * m[1]; }
+
+	static constexpr Mat2 transpose( const Mat2& a ) noexcept { return Mat2( a.m[0], a.m[1], a.m[2], a.m[3] ); }
+
+	constexpr Vec2<T> operator * ( const Vec2<T>& v ) const noexcept
+	{
+		return Vec2<T>( m[0] * v.x + m[2] * v.y, m[1] * v.x + m[3] * v.y );
+	}
+
+	constexpr Mat2 operator * ( const Mat2& b ) const noexcept
+	{
+		return Mat2( m[0] * b.m[0] + m[2] * b.m[1], m[0] * b.m[2] + m[2] * b.m[3],
+		             m[1] * b.m[0] + m[3] * b.m[1], m[1] * b.m[2] + m[3] * b.m[3] );
+	}
+};
+
+template<typename T>
+struct Mat3
+{
+	T m[9];
+
+	constexpr Mat3() noexcept : m{ 1, 0, 0, 0, 1, 0, 0, 0, 1 } {}
+	constexpr Mat3( T m0, T m3, T m6,
+	                T m1, T m4, T m7,
+	                T m2, T m5, T m8 ) noexcept : m{ m0, m1, m2, m3, m4, m5, m6, m7, m8 } {}
+
+	constexpr T determinant() const noexcept
+	{
+		return m[0] * (m[4] * m[8] - m[7] * m[5]) - m[3] * (m[1] * m[8] - m[7] * m[2]) + m[6] * (m[1] * m[5] - m[4] * m[2]);
+	}
+
+	static constexpr Mat3 transpose( const Mat3& a ) noexcept
+	{
+		return Mat3( a.m[0], a.m[1], a.m[2],
+		             a.m[3], a.m[4], a.m[5],
+		             a.m[6], a.m[7], a.m[8] );
+	}
+
+	constexpr Vec3<T> operator * ( const Vec3<T>& v ) const noexcept
+	{
+		return Vec3<T>( m[0] * v.x + m[3] * v.y + m[6] * v.z,
+		                m[1] * v.x + m[4] * v.y + m[7] * v.z,
+		                m[2] * v.x + m[5] * v.y + m[8] * v.z );
+	}
+
+	constexpr Mat3 operator * ( const Mat3& b ) const noexcept
+	{
+		Mat3 lResult;
+
+		for( int c = 0; c < 3; ++c )
+			for( int r = 0; r < 3; ++r )
+				lResult.m[c * 3 + r] = m[r] * b.m[c * 3] + m[3 + r] * b.m[c * 3 + 1] + m[6 + r] * b.m[c * 3 + 2];
+
+		return lResult;
+	}
+};
+
+template<typename T>
+struct Mat4
+{
+	T m[16];
+
+	constexpr Mat4() noexcept : m{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } {}
+	constexpr Mat4( T m0, T m4, T  m8, T m12,
+	                T m1, T m5, T  m9, T m13,
+	                T m2, T m6, T m10, T m14,
+	                T m3, T m7, T m11, T m15 ) noexcept :
+			m{ m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15 }
+	{
+	}
+
+	constexpr void identity() noexcept { *this = Mat4(); }
+
+	constexpr void translate( const Vec3<T>& pTranslation ) noexcept
+	{
+		identity();
+		m[12] = pTranslation.x;
+		m[13] = pTranslation.y;
+		m[14] = pTranslation.z;
+	}
+
+	constexpr void translate_x( const T& pDistance ) noexcept { identity(); m[12] = pDistance; }
+	constexpr void translate_y( const T& pDistance ) noexcept { identity(); m[13] = pDistance; }
+	constexpr void translate_z( const T& pDistance ) noexcept { identity(); m[14] = pDistance; }
+
+	// In degrees. rotate() normalizes pAxis in place.
+	void rotate( const T& pAngle, Vec3<T>& pAxis ) noexcept;
+	void rotate_x( const T& pAngle ) noexcept;
+	void rotate_y( const T& pAngle ) noexcept;
+	void rotate_z( const T& pAngle ) noexcept;
+
+	constexpr void scale( const Vec3<T>& pScale ) noexcept
+	{
+		identity();
+		m[0] = pScale.x;
+		m[5] = pScale.y;
+		m[10] = pScale.z;
+	}
+
+	// Affine: w is taken to be 1 for points and 0 for vectors, and the
+	// bottom row is ignored.
+	constexpr Vec3<T> transformPoint( const Vec3<T>& v ) const noexcept
+	{
+		return Vec3<T>( v.x * m[0] + v.y * m[4] + v.z * m[8] + m[12],
+		                v.x * m[1] + v.y * m[5] + v.z * m[9] + m[13],
+		                v.x * m[2] + v.y * m[6] + v.z * m[10] + m[14] );
+	}
+
+	constexpr Vec3<T> transformVector( const Vec3<T>& v ) const noexcept
+	{
+		return Vec3<T>( v.x * m[0] + v.y * m[4] + v.z * m[8],
+		                v.x * m[1] + v.y * m[5] + v.z * m[9],
+		                v.x * m[2] + v.y * m[6] + v.z * m[10] );
+	}
+
+	constexpr void transformPoint( Vec3<T>* pVector ) const noexcept { *pVector = transformPoint( *pVector ); }
+	constexpr void transformVector( Vec3<T>* pVector ) const noexcept { *pVector = transformVector( *pVector ); }
+
+	// Singular matrices invert to the identity.
+	static constexpr Mat4 invertMatrix( const Mat4* pMatrix ) noexcept { return invertMatrixReference( pMatrix ); }
+	static constexpr Mat4 transpose( const Mat4* pMatrix ) noexcept { return transposeReference( pMatrix ); }
+
+	// Cheaper inverse for matrices whose bottom row is 0, 0, 0, 1, which
+	// is every mix of rotations, scales and translations.
+	static constexpr Mat4 invertAffine( const Mat4* pMatrix ) noexcept { return invertAffineReference( pMatrix ); }
+
+	// Plain C++ versions of the above and of operator *, which the float
+	// SIMD versions are checked against.
+	static constexpr Mat4 multiplyReference( const Mat4* a, const Mat4* b ) noexcept;
+	static constexpr Mat4 invertMatrixReference( const Mat4* pMatrix ) noexcept;
+	static constexpr Mat4 invertAffineReference( const Mat4* pMatrix ) noexcept;
+	static constexpr Mat4 transposeReference( const Mat4* pMatrix ) noexcept;
+
+	static constexpr Mat4 createFrustumProjection( T left, T right, T bottom, T top, T zNear, T zFar ) noexcept;
+	static Mat4 createPerspectiveProjection( T fieldOfVision, T aspectRatio, T zNear, T zFar ) noexcept;
+	static constexpr Mat4 createOrthographicProjection( T left, T right, T bottom, T top, T near, T far ) noexcept;
+
+	constexpr Mat4 operator + ( const Mat4& pOther ) const noexcept
+	{
+		Mat4 lResult;
+
+		for( int i = 0; i < 16; ++i )
+			lResult.m[i] = m[i] + pOther.m[i];
+
+		return lResult;
+	}
+
+	constexpr Mat4 operator - ( const Mat4& pOther ) const noexcept
+	{
+		Mat4 lResult;
+
+		for( int i = 0; i < 16; ++i )
+			lResult.m[i] = m[i] - pOther.m[i];
+
+		return lResult;
+	}
+
+	constexpr Mat4 operator * ( const Mat4& pOther ) const noexcept { return multiplyReference( this, &pOther ); }
+
+	constexpr Mat4 operator * ( T pScalar ) const noexcept
+	{
+		Mat4 lResult;
+
+		for( int i = 0; i < 16; ++i )
+			lResult.m[i] = m[i] * pScalar;
+
+		return lResult;
+	}
+
+	constexpr Vec4<T> operator * ( const Vec4<T>& v ) const noexcept
+	{
+		return Vec4<T>( m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+		                m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+		                m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+		                m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w );
+	}
+};
+
+template<typename T>
+void Mat4<T>::rotate( const T& pAngle, Vec3<T>& pAxis ) noexcept
+{
+	T s, c;
+	sinCos( DEGTORAD(pAngle), &s, &c );
+
+	pAxis.normalize();
+
+	T ux = pAxis.x;
+	T uy = pAxis.y;
+	T uz = pAxis.z;
+
+	m[0]  = c + (1 - c) * ux * ux;
+	m[1]  = (1 - c) * ux * uy + s * uz;
+	m[2]  = (1 - c) * ux * uz - s * uy;
+	m[3]  = 0;
+
+	m[4]  = (1 - c) * uy * ux - s * uz;
+	m[5]  = c + (1 - c) * uy * uy;
+	m[6]  = (1 - c) * uy * uz + s * ux;
+	m[7]  = 0;
+
+	m[8]  = (1 - c) * uz * ux + s * uy;
+	m[9]  = (1 - c) * uz * uz - s * ux;
+	m[10] = c + (1 - c) * uz * uz;
+	m[11] = 0;
+
+	m[12] = 0;
+	m[13] = 0;
+	m[14] = 0;
+	m[15] = 1;
+}
+
+template<typename T>
+void Mat4<T>::rotate_x( const T& pAngle ) noexcept
+{
+	T s, c;
+	sinCos( DEGTORAD(pAngle), &s, &c );
+
+	identity();
+
+	m[5]  =  c;
+	m[6]  =  s;
+	m[9]  = -s;
+	m[10] =  c;
+}
+
+template<typename T>
+void Mat4<T>::rotate_y( const T& pAngle ) noexcept
+{
+	T s, c;
+	sinCos( DEGTORAD(pAngle), &s, &c );
+
+	identity();
+
+	m[0]  =  c;
+	m[2]  = -s;
+	m[8]  =  s;
+	m[10] =  c;
+}
+
+template<typename T>
+void Mat4<T>::rotate_z( const T& pAngle ) noexcept
+{
+	T s, c;
+	sinCos( DEGTORAD(pAngle), &s, &c );
+
+	identity();
+
+	m[0] =  c;
+	m[1] =  s;
+	m[4] = -s;
+	m[5] =  c;
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::multiplyReference( const Mat4* a, const Mat4* b ) noexcept
+{
+	Mat4 lResult;
+
+	// Summed left to right, which the SIMD version relies on to match.
+	for( int c = 0; c < 16; c += 4 )
+		for( int r = 0; r < 4; ++r )
+			lResult.m[c + r] = (a->m[r] * b->m[c]) + (a->m[4 + r] * b->m[c + 1]) +
+					(a->m[8 + r] * b->m[c + 2]) + (a->m[12 + r] * b->m[c + 3]);
+
+	return lResult;
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::invertMatrixReference( const Mat4* pMatrix ) noexcept
+{
+	// Inverse = adjoint / det, with the elements named by row and column
+	// from 1 (so m23 is row 2, column 3).
+	const T* a = pMatrix->m;
+	const T m11 = a[0], m12 = a[4], m13 = a[8],  m14 = a[12];
+	const T m21 = a[1], m22 = a[5], m23 = a[9],  m24 = a[13];
+	const T m31 = a[2], m32 = a[6], m33 = a[10], m34 = a[14];
+	const T m41 = a[3], m42 = a[7], m43 = a[11], m44 = a[15];
+
+	// 2x2 determinants of the last two rows, for the cofactors of the
+	// first two rows.
+	T d12 = (m31 * m42 - m41 * m32);
+	T d13 = (m31 * m43 - m41 * m33);
+	T d23 = (m32 * m43 - m42 * m33);
+	T d24 = (m32 * m44 - m42 * m34);
+	T d34 = (m33 * m44 - m43 * m34);
+	T d41 = (m34 * m41 - m44 * m31);
+
+	Mat4 lResult;
+	T* r = lResult.m;
+
+	r[0] =  (m22 * d34 - m23 * d24 + m24 * d23);
+	r[1] = -(m21 * d34 + m23 * d41 + m24 * d13);
+	r[2] =  (m21 * d24 + m22 * d41 + m24 * d12);
+	r[3] = -(m21 * d23 - m22 * d13 + m23 * d12);
+
+	// The determinant, from the first of these cofactors.
+	T det = m11 * r[0] + m12 * r[1] + m13 * r[2] + m14 * r[3];
+
+	if( det == 0 )
+		return Mat4();
+
+	T invDet = 1 / det;
+
+	r[0] *= invDet;
+	r[1] *= invDet;
+	r[2] *= invDet;
+	r[3] *= invDet;
+
+	r[4] = -(m12 * d34 - m13 * d24 + m14 * d23) * invDet;
+	r[5] =  (m11 * d34 + m13 * d41 + m14 * d13) * invDet;
+	r[6] = -(m11 * d24 + m12 * d41 + m14 * d12) * invDet;
+	r[7] =  (m11 * d23 - m12 * d13 + m13 * d12) * invDet;
+
+	// 2x2 determinants of the first two rows, for the cofactors of the
+	// last two rows.
+	d12 = m11 * m22 - m21 * m12;
+	d13 = m11 * m23 - m21 * m13;
+	d23 = m12 * m23 - m22 * m13;
+	d24 = m12 * m24 - m22 * m14;
+	d34 = m13 * m24 - m23 * m14;
+	d41 = m14 * m21 - m24 * m11;
+
+	r[8]  =  (m42 * d34 - m43 * d24 + m44 * d23) * invDet;
+	r[9]  = -(m41 * d34 + m43 * d41 + m44 * d13) * invDet;
+	r[10] =  (m41 * d24 + m42 * d41 + m44 * d12) * invDet;
+	r[11] = -(m41 * d23 - m42 * d13 + m43 * d12) * invDet;
+	r[12] = -(m32 * d34 - m33 * d24 + m34 * d23) * invDet;
+	r[13] =  (m31 * d34 + m33 * d41 + m34 * d13) * invDet;
+	r[14] = -(m31 * d24 + m32 * d41 + m34 * d12) * invDet;
+	r[15] =  (m31 * d23 - m32 * d13 + m33 * d12) * invDet;
+
+	return lResult;
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::invertAffineReference( const Mat4* pMatrix ) noexcept
+{
+	const T* a = pMatrix->m;
+
+	// Cofactors of the upper 3x3, which are the cross products of its
+	// columns.
+	T r0[3] = { a[5] * a[10] - a[6] * a[9], a[6] * a[8] - a[4] * a[10], a[4] * a[9] - a[5] * a[8] };
+	T r1[3] = { a[9] * a[2] - a[10] * a[1], a[10] * a[0] - a[8] * a[2], a[8] * a[1] - a[9] * a[0] };
+	T r2[3] = { a[1] * a[6] - a[2] * a[5], a[2] * a[4] - a[0] * a[6], a[0] * a[5] - a[1] * a[4] };
+
+	T det = a[0] * r0[0] + a[1] * r0[1] + a[2] * r0[2];
+
+	if( det == 0 )
+		return Mat4();
+
+	T invDet = 1 / det;
+	Mat4 lResult;
+
+	for( int i = 0; i < 3; ++i )
+	{
+		lResult.m[i * 4 + 0] = r0[i] * invDet;
+		lResult.m[i * 4 + 1] = r1[i] * invDet;
+		lResult.m[i * 4 + 2] = r2[i] * invDet;
+		lResult.m[i * 4 + 3] = 0;
+	}
+
+	for( int i = 0; i < 3; ++i )
+		lResult.m[12 + i] = -(lResult.m[i] * a[12] + lResult.m[4 + i] * a[13] + lResult.m[8 + i] * a[14]);
+
+	return lResult;
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::transposeReference( const Mat4* pMatrix ) noexcept
+{
+	Mat4 lResult;
+
+	for( int c = 0; c < 4; ++c )
+		for( int r = 0; r < 4; ++r )
+			lResult.m[c * 4 + r] = pMatrix->m[r * 4 + c];
+
+	return lResult;
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::createFrustumProjection( T left, T right, T bottom, T top, T zNear, T zFar ) noexcept
+{
+	Mat4 lResult;
+
+	lResult.m[0] = 2 * zNear / (right - left);
+	lResult.m[5] = 2 * zNear / (top - bottom);
+	lResult.m[8] = (right + left) / (right - left);
+	lResult.m[9] = (top + bottom) / (top - bottom);
+	lResult.m[10] = -(zFar + zNear) / (zFar - zNear);
+	lResult.m[11] = -1;
+	lResult.m[14] = -(2 * zFar * zNear) / (zFar - zNear);
+
+	return lResult;
+}
+
+template<typename T>
+Mat4<T> Mat4<T>::createPerspectiveProjection( T fieldOfVision, T aspectRatio, T zNear, T zFar ) noexcept
+{
+	T s, c;
+	sinCos( DEGTORAD(fieldOfVision) / 2, &s, &c );
+
+	T lSize = zNear * s / c;
+
+	return createFrustumProjection( -lSize, lSize, -lSize / aspectRatio, lSize / aspectRatio, zNear, zFar );
+}
+
+template<typename T>
+constexpr Mat4<T> Mat4<T>::createOrthographicProjection( T left, T right, T bottom, T top, T near, T far ) noexcept
+{
+	Mat4 lResult;
+
+	lResult.m[0]  = 2 / (right - left);
+	lResult.m[5]  = 2 / (top - bottom);
+	lResult.m[10] = -2.0 / (far - near);
+	lResult.m[12] = -(right + left) / (right - left);
+	lResult.m[13] = -(top + bottom) / (top - bottom);
+	lResult.m[14] = -(far + near) / (far - near);
+
+	return lResult;
+}
+
+// SSE or NEON, in matrix4x4f.cpp.
+// A 2D affine transform, the top two rows of a 3x3 matrix whose bottom row
+// is 0, 0, 1, stored by column like Mat4:
+//
+//     x' = m[0] * x + m[2] * y + m[4]
+//     y' = m[1] * x + m[3] * y + m[5]
+//
+// Six numbers instead of sixteen for the 2D scene, which only becomes a
+// Mat4 (toMat4()) where GL wants one. Like Mat4's, the in-place methods
+// replace the whole transform, and a * b applies b first.
+template<typename T>
+struct Affine2
+{
+	T m[6];
+
+	constexpr Affine2() noexcept : m{ 1, 0, 0, 1, 0, 0 } {}
+	constexpr Affine2( T m0, T m2, T m4,
+	                   T m1, T m3, T m5 ) noexcept : m{ m0, m1, m2, m3, m4, m5 } {}
+
+	constexpr void identity() noexcept { *this = Affine2(); }
+
+	constexpr void translate( const Vec2<T>& pTranslation ) noexcept
+	{
+		identity();
+		m[4] = pTranslation.x;
+		m[5] = pTranslation.y;
+	}
+
+	constexpr void scale( const Vec2<T>& pScale ) noexcept
+	{
+		identity();
+		m[0] = pScale.x;
+		m[3] = pScale.y;
+	}
+
+	// In degrees, counterclockwise.
+	void rotate( const T& pAngle ) noexcept
+	{
+		T s, c;
+		sinCos( DEGTORAD(pAngle), &s, &c );
+
+		*this = Affine2( c, -s, 0,
+		                 s,  c, 0 );
+	}
+
+	// Summed in the order Mat4::transformPoint() sums, so a point comes
+	// out the same through either.
+	constexpr Vec2<T> transformPoint( const Vec2<T>& v ) const noexcept
+	{
+		return Vec2<T>( v.x * m[0] + v.y * m[2] + m[4],
+		                v.x * m[1] + v.y * m[3] + m[5] );
+	}
+
+	constexpr Vec2<T> transformVector( const Vec2<T>& v ) const noexcept
+	{
+		return Vec2<T>( v.x * m[0] + v.y * m[2],
+		                v.x * m[1] + v.y * m[3] );
+	}
+
+	constexpr void transformPoint( Vec2<T>* pVector ) const noexcept { *pVector = transformPoint( *pVector ); }
+	constexpr void transformVector( Vec2<T>* pVector ) const noexcept { *pVector = transformVector( *pVector ); }
+
+	constexpr Affine2 operator * ( const Affine2& b ) const noexcept
+	{
+		return Affine2( m[0] * b.m[0] + m[2] * b.m[1], m[0] * b.m[2] + m[2] * b.m[3], m[0] * b.m[4] + m[2] * b.m[5] + m[4],
+		                m[1] * b.m[0] + m[3] * b.m[1], m[1] * b.m[2] + m[3] * b.m[3], m[1] * b.m[4] + m[3] * b.m[5] + m[5] );
+	}
+
+	// Singular transforms invert to the identity.
+	static constexpr Affine2 invert( const Affine2* pAffine ) noexcept
+	{
+		const T* a = pAffine->m;
+		T det = a[0] * a[3] - a[1] * a[2];
+
+		if( det == 0 )
+			return Affine2();
+
+		T invDet = 1 / det;
+		T m0 = a[3] * invDet;
+		T m1 = -a[1] * invDet;
+		T m2 = -a[2] * invDet;
+		T m3 = a[0] * invDet;
+
+		return Affine2( m0, m2, -(m0 * a[4] + m2 * a[5]),
+		                m1, m3, -(m1 * a[4] + m3 * a[5]) );
+	}
+
+	// The x and y part of Mat4::createOrthographicProjection(); z is left
+	// alone rather than mapped from near and far.
+	static constexpr Affine2 createOrthographicProjection( T left, T right, T bottom, T top ) noexcept
+	{
+		return Affine2( 2 / (right - left), 0, -(right + left) / (right - left),
+		                0, 2 / (top - bottom), -(top + bottom) / (top - bottom) );
+	}
+
+	// True when there is no rotation or shear, so that the transform is
+	// just getScaleOffset().
+	constexpr bool isScaleOffset() const noexcept { return m[1] == 0 && m[2] == 0; }
+
+	// x and y scale, then x and y offset, as the SHADER_SCALE_OFFSET
+	// shaders take them.
+	constexpr Vec4<T> getScaleOffset() const noexcept { return Vec4<T>( m[0], m[3], m[4], m[5] ); }
+
+	// Column-major with z passed through, for glUniformMatrix4fv().
+	constexpr Mat4<T> toMat4() const noexcept
+	{
+		return Mat4<T>( m[0], m[2], 0, m[4],
+		                m[1], m[3], 0, m[5],
+		                0,    0,    1, 0,
+		                0,    0,    0, 1 );
+	}
+};
+
+template<> Mat4<float> Mat4<float>::operator * ( const Mat4<float>& pOther ) const noexcept;
+template<> Mat4<float> Mat4<float>::invertMatrix( const Mat4<float>* pMatrix ) noexcept;
+template<> Mat4<float> Mat4<float>::invertAffine( const Mat4<float>* pMatrix ) noexcept;
+template<> Mat4<float> Mat4<float>::transpose( const Mat4<float>* pMatrix ) noexcept;
+
+typedef Vec2<float> Vector2f;
+typedef Vec3<float> Vector3f;
+typedef Vec4<float> Vector4f;
+typedef Mat2<float> Matrix2x2f;
+typedef Mat3<float> Matrix3x3f;
+typedef Mat4<float> Matrix4x4f;
+typedef Affine2<float> Affine2f;
+
+}
+#endif // _GUILDHALL_VECMATH_H_
@@ -0,0 +1,222 @@
+#ifndef _GUILDHALL_VECMATH_EXPRESSION_H_
+#define _GUILDHALL_VECMATH_EXPRESSION_H_
+
+#include "vecmath.h"
+
+namespace guildhall {
+
+// Optional expression templates over Vec2, Vec3 and Vec4. Wrapping a
+// vector in expression() makes the arithmetic on it build a tree instead of
+// computing anything, and evaluate() then computes every component of the
+// whole tree in one pass:
+//
+//     Vector3f p = evaluate<Vector3f>( expression( velocity ) * elapsed + expression( position ) );
+//
+// The plain operators already inline to the same arithmetic at -O2, so the
+// one thing the tree adds is that a * b + c becomes a fused multiply-add
+// where the target has one (ARMv8, or x86 built with -mfma), rounding once
+// instead of twice. Elsewhere it computes exactly what the operators do.
+//
+// Leaves refer to the vectors they wrap, so a tree must be evaluated in
+// the statement that builds it rather than kept in an auto variable.
+
+template<typename T>
+constexpr T multiplyAdd( T a, T b, T c ) noexcept
+{
+#if defined(__FP_FAST_FMAF)
+	return __builtin_fmaf( a, b, c );
+#else
+	return a * b + c;
+#endif
+}
+
+template<>
+constexpr double multiplyAdd( double a, double b, double c ) noexcept
+{
+#if defined(__FP_FAST_FMA)
+	return __builtin_fma( a, b, c );
+#else
+	return a * b + c;
+#endif
+}
+
+// Every node derives from Expression<Node> and has a component( i ).
+template<typename E>
+struct Expression
+{
+	constexpr const E& self() const noexcept { return static_cast<const E&>( *this ); }
+	constexpr auto component( int i ) const noexcept { return self().component( i ); }
+};
+
+template<typename V>
+struct VectorLeaf : public Expression< VectorLeaf<V> >
+{
+	const V& m_vector;
+
+	constexpr explicit VectorLeaf( const V& pVector ) noexcept : m_vector( pVector ) {}
+
+	constexpr auto component( int i ) const noexcept
+	{
+		return (i == 0) ? m_vector.x : (i == 1) ? m_vector.y : component3( m_vector, i );
+	}
+
+private:
+
+	template<typename T> static constexpr T component3( const Vec2<T>& v, int ) noexcept { return v.y; }
+	template<typename T> static constexpr T component3( const Vec3<T>& v, int ) noexcept { return v.z; }
+	template<typename T> static constexpr T component3( const Vec4<T>& v, int i ) noexcept { return (i == 2) ? v.z : v.w; }
+};
+
+template<typename T>
+struct ScalarLeaf : public Expression< ScalarLeaf<T> >
+{
+	T m_value;
+
+	constexpr explicit ScalarLeaf( T pValue ) noexcept : m_value( pValue ) {}
+	constexpr T component( int ) const noexcept { return m_value; }
+};
+
+template<typename L, typename R>
+struct SumNode : public Expression< SumNode<L, R> >
+{
+	L m_left;
+	R m_right;
+
+	constexpr SumNode( const L& pLeft, const R& pRight ) noexcept : m_left( pLeft ), m_right( pRight ) {}
+	constexpr auto component( int i ) const noexcept { return m_left.component( i ) + m_right.component( i ); }
+};
+
+template<typename L, typename R>
+struct DifferenceNode : public Expression< DifferenceNode<L, R> >
+{
+	L m_left;
+	R m_right;
+
+	constexpr DifferenceNode( const L& pLeft, const R& pRight ) noexcept : m_left( pLeft ), m_right( pRight ) {}
+	constexpr auto component( int i ) const noexcept { return m_left.component( i ) - m_right.component( i ); }
+};
+
+template<typename L, typename R>
+struct ProductNode : public Expression< ProductNode<L, R> >
+{
+	L m_left;
+	R m_right;
+
+	constexpr ProductNode( const L& pLeft, const R& pRight ) noexcept : m_left( pLeft ), m_right( pRight ) {}
+	constexpr auto component( int i ) const noexcept { return m_left.component( i ) * m_right.component( i ); }
+};
+
+// a * b + c and c + a * b, the chains this is for.
+template<typename A, typename B, typename C>
+struct SumNode< ProductNode<A, B>, C > : public Expression< SumNode< ProductNode<A, B>, C > >
+{
+	ProductNode<A, B> m_left;
+	C m_right;
+
+	constexpr SumNode( const ProductNode<A, B>& pLeft, const C& pRight ) noexcept : m_left( pLeft ), m_right( pRight ) {}
+
+	constexpr auto component( int i ) const noexcept
+	{
+		return multiplyAdd( m_left.m_left.component( i ), m_left.m_right.component( i ), m_right.component( i ) );
+	}
+};
+
+template<typename C, typename A, typename B>
+struct SumNode< C, ProductNode<A, B> > : public Expression< SumNode< C, ProductNode<A, B> > >
+{
+	C m_left;
+	ProductNode<A, B> m_right;
+
+	constexpr SumNode( const C& pLeft, const ProductNode<A, B>& pRight ) noexcept : m_left( pLeft ), m_right( pRight ) {}
+
+	constexpr auto component( int i ) const noexcept
+	{
+		return multiplyAdd( m_right.m_left.component( i ), m_right.m_right.component( i ), m_left.component( i ) );
+	}
+};
+
+// Both sides products: the first product is fused into the second.
+template<typename A, typename B, typename C, typename D>
+struct SumNode< ProductNode<A, B>, ProductNode<C, D> > :
+		public Expression< SumNode< ProductNode<A, B>, ProductNode<C, D> > >
+{
+	ProductNode<A, B> m_left;
+	ProductNode<C, D> m_right;
+
+	constexpr SumNode( const ProductNode<A, B>& pLeft, const ProductNode<C, D>& pRight ) noexcept :
+			m_left( pLeft ),
+			m_right( pRight )
+	{
+	}
+
+	constexpr auto component( int i ) const noexcept
+	{
+		return multiplyAdd( m_left.m_left.component( i ), m_left.m_right.component( i ), m_right.component( i ) );
+	}
+};
+
+template<typename T>
+constexpr VectorLeaf< Vec2<T> > expression( const Vec2<T>& pVector ) noexcept { return VectorLeaf< Vec2<T> >( pVector ); }
+
+template<typename T>
+constexpr VectorLeaf< Vec3<T> > expression( const Vec3<T>& pVector ) noexcept { return VectorLeaf< Vec3<T> >( pVector ); }
+
+template<typename T>
+constexpr VectorLeaf< Vec4<T> > expression( const Vec4<T>& pVector ) noexcept { return VectorLeaf< Vec4<T> >( pVector ); }
+
+template<typename L, typename R>
+constexpr SumNode<L, R> operator + ( const Expression<L>& pLeft, const Expression<R>& pRight ) noexcept
+{
+	return SumNode<L, R>( pLeft.self(), pRight.self() );
+}
+
+template<typename L, typename R>
+constexpr DifferenceNode<L, R> operator - ( const Expression<L>& pLeft, const Expression<R>& pRight ) noexcept
+{
+	return DifferenceNode<L, R>( pLeft.self(), pRight.self() );
+}
+
+template<typename L, typename R>
+constexpr ProductNode<L, R> operator * ( const Expression<L>& pLeft, const Expression<R>& pRight ) noexcept
+{
+	return ProductNode<L, R>( pLeft.self(), pRight.self() );
+}
+
+template<typename L>
+constexpr ProductNode< L, ScalarLeaf<float> > operator * ( const Expression<L>& pLeft, float pScalar ) noexcept
+{
+	return ProductNode< L, ScalarLeaf<float> >( pLeft.self(), ScalarLeaf<float>( pScalar ) );
+}
+
+template<typename R>
+constexpr ProductNode< ScalarLeaf<float>, R > operator * ( float pScalar, const Expression<R>& pRight ) noexcept
+{
+	return ProductNode< ScalarLeaf<float>, R >( ScalarLeaf<float>( pScalar ), pRight.self() );
+}
+
+template<typename T, typename E>
+constexpr Vec2<T> evaluateAs( const Expression<E>& e, const Vec2<T>* ) noexcept
+{
+	return Vec2<T>( e.component( 0 ), e.component( 1 ) );
+}
+
+template<typename T, typename E>
+constexpr Vec3<T> evaluateAs( const Expression<E>& e, const Vec3<T>* ) noexcept
+{
+	return Vec3<T>( e.component( 0 ), e.component( 1 ), e.component( 2 ) );
+}
+
+template<typename T, typename E>
+constexpr Vec4<T> evaluateAs( const Expression<E>& e, const Vec4<T>* ) noexcept
+{
+	return Vec4<T>( e.component( 0 ), e.component( 1 ), e.component( 2 ), e.component( 3 ) );
+}
+
+template<typename V, typename E>
+constexpr V evaluate( const Expression<E>& pExpression ) noexcept
+{
+	return evaluateAs( pExpression, (const V*) 0 );
+}
+
+}
+#endif // _GUILDHALL_VECMATH_EXPRESSION_H_
@@ -0,0 +1,15 @@
+//-----------------------------------------------------------------------------
+//           Name: vector3f.h
+//         Author: Kevin Harris
+//  Last Modified: 06/04/12
+//    Description: OpenGL compatible utility class for a 3D vector of floats
+//                 Vector3f is now Vec3<float>, which vecmath.h defines
+//                 inline along with the other vector and matrix types.
+//-----------------------------------------------------------------------------
+
+#ifndef _GUILDHALL_VECTOR3F_H_
+#define _GUILDHALL_VECTOR3F_H_
+
+#include "vecmath.h"
+
+#endif // _GUILDHALL_VECTOR3F_H_
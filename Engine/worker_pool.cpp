@@ -0,0 +1,113 @@
+#include "worker_pool.h"
+
+namespace guildhall {
+
+WorkerPool::WorkerPool( int32_t pThreadCount ) :
+		m_generation( 0 ),
+		m_activeWorkers( 0 ),
+		m_stopping( false ),
+		m_task( NULL ),
+		m_context( NULL ),
+		m_count( 0 ),
+		m_chunkSize( 1 ),
+		m_nextChunk( 0 )
+{
+	for( int32_t i = 1; i < pThreadCount; ++i )
+	{
+		m_workers.push_back( std::thread( &WorkerPool::work, this ) );
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lLock( m_mutex );
+		m_stopping = true;
+	}
+
+	m_startCondition.notify_all();
+
+	for( size_t i = 0; i < m_workers.size(); ++i )
+	{
+		m_workers[i].join();
+	}
+}
+
+void WorkerPool::run( Task pTask, void* pContext, int32_t pCount, int32_t pChunkSize )
+{
+	if( pCount <= 0 )
+		return;
+
+	// Waking the workers costs more than a single chunk.
+	if( m_workers.empty() || pCount <= pChunkSize )
+	{
+		pTask( pContext, 0, pCount );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lLock( m_mutex );
+		m_task = pTask;
+		m_context = pContext;
+		m_count = pCount;
+		m_chunkSize = pChunkSize;
+		m_nextChunk.store( 0 );
+		m_activeWorkers = (int32_t) m_workers.size();
+		++m_generation;
+	}
+
+	m_startCondition.notify_all();
+
+	runChunks();
+
+	std::unique_lock<std::mutex> lLock( m_mutex );
+
+	while( m_activeWorkers > 0 )
+	{
+		m_doneCondition.wait( lLock );
+	}
+}
+
+void WorkerPool::runChunks()
+{
+	int32_t lChunkCount = (m_count + m_chunkSize - 1) / m_chunkSize;
+	int32_t lChunk;
+
+	while( (lChunk = m_nextChunk.fetch_add( 1 )) < lChunkCount )
+	{
+		int32_t lBegin = lChunk * m_chunkSize;
+		int32_t lEnd = (m_count - lBegin > m_chunkSize) ? lBegin + m_chunkSize : m_count;
+		m_task( m_context, lBegin, lEnd );
+	}
+}
+
+void WorkerPool::work()
+{
+	// The generation the pool was created with. A worker that only gets
+	// here after the first run() started still takes part in that run.
+	uint32_t lGeneration = 0;
+	std::unique_lock<std::mutex> lLock( m_mutex );
+
+	while( true )
+	{
+		while( !m_stopping && m_generation == lGeneration )
+		{
+			m_startCondition.wait( lLock );
+		}
+
+		if( m_stopping )
+			break;
+
+		lGeneration = m_generation;
+		lLock.unlock();
+
+		runChunks();
+
+		lLock.lock();
+
+		if( --m_activeWorkers == 0 )
+			m_doneCondition.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef _GUILDHALL_WORKER_POOL_H_
+#define _GUILDHALL_WORKER_POOL_H_
+
+#include "types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace guildhall {
+
+// A few threads that split a loop over [0, count) into chunks, for kernels
+// that are worth spreading over cores at a hundred thousand flakes but not
+// at a few hundred. The calling thread takes chunks as well, and run()
+// returns once all of them are done. Workers sleep between runs.
+class WorkerPool
+{
+public:
+
+	// Called with each chunk [pBegin, pEnd).
+	typedef void (*Task)( void* pContext, int32_t pBegin, int32_t pEnd );
+
+	// pThreadCount includes the calling thread, so 1 starts no threads.
+	WorkerPool( int32_t pThreadCount );
+	~WorkerPool();
+
+	int32_t getThreadCount() const { return (int32_t) m_workers.size() + 1; }
+
+	// One run at a time, from one thread.
+	void run( Task pTask, void* pContext, int32_t pCount, int32_t pChunkSize );
+
+private:
+
+	WorkerPool( const WorkerPool& );
+	WorkerPool& operator = ( const WorkerPool& );
+
+	void runChunks();
+	void work();
+
+private:
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_doneCondition;
+	uint32_t m_generation;
+	int32_t m_activeWorkers;
+	bool m_stopping;
+
+	// The current run.
+	Task m_task;
+	void* m_context;
+	int32_t m_count;
+	int32_t m_chunkSize;
+	std::atomic<int32_t> m_nextChunk;
+};
+
+}
+#endif // _GUILDHALL_WORKER_POOL_H_
@@ -0,0 +1,2032 @@
+//
+// micro_bench.cpp
+// SnowFlakes
+//
+// Microbenchmarks for the engine's hot paths: the flake update in float, in
+// fixed point and as ParticleSystem configurations, Random, Vector3f
+// and Matrix4x4f arithmetic, sines and cosines and PNG decoding, each at a
+// range of sizes (200 to a million flakes for the simulation kernels), plus
+// the cost of a profiler zone (nothing unless built with GUILDHALL_PROFILER).
+//
+// Every benchmark reports nanoseconds per item (a flake, a vector, a matrix
+// or a decoded pixel), the bytes of state it streams per second, the heap
+// allocations it makes per run and, where the hardware counters can be
+// read, its L1 data and last level cache misses per item. Results can be
+// written as JSON and compared against an earlier run, in which case the
+// exit status is 1 when any benchmark got slower than the threshold allows.
+//
+// The correctness checks run before any benchmark; --check stops after
+// them, for the ctest run.
+//
+// Usage: micro_bench [--filter TEXT] [--min-time SECONDS] [--check]
+//                    [--output results.json]
+//                    [--baseline baseline.json] [--threshold PERCENT]
+//                    [--kernels scalar|sse2|avx2|neon]
+//
+
+#include "block_snowflakes.h"
+#include "compact_snowflakes.h"
+#include "flake_culler.h"
+#include "kernels.h"
+#include "matrix4x4f.h"
+#include "memory_tracker.h"
+#include "particle_system.h"
+#include "point_transform.h"
+#include "profiler.h"
+#include "random.h"
+#include "simd.h"
+#include "snowflakes.h"
+#include "texture.h"
+#include "timer.h"
+#include "trig.h"
+#include "vecmath_expression.h"
+#include "vector3f.h"
+
+#include <algorithm>
+#include <atomic>
+#include <float.h>
+#include <map>
+#include <math.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace guildhall;
+
+//
+// Allocation counting. glibc lets a program replace malloc and friends, so
+// every heap allocation is counted, whether it comes from operator new, the
+// engine's new[] or libpng.
+//
+
+namespace {
+
+std::atomic<uint64_t> g_allocations( 0 );
+
+}
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+void* __libc_malloc( size_t pSize );
+void* __libc_calloc( size_t pCount, size_t pSize );
+void* __libc_realloc( void* pPointer, size_t pSize );
+void __libc_free( void* pPointer );
+
+void* malloc( size_t pSize )
+{
+	g_allocations.fetch_add( 1, std::memory_order_relaxed );
+	return __libc_malloc( pSize );
+}
+
+void* calloc( size_t pCount, size_t pSize )
+{
+	g_allocations.fetch_add( 1, std::memory_order_relaxed );
+	return __libc_calloc( pCount, pSize );
+}
+
+void* realloc( void* pPointer, size_t pSize )
+{
+	g_allocations.fetch_add( 1, std::memory_order_relaxed );
+	return __libc_realloc( pPointer, pSize );
+}
+
+void free( void* pPointer )
+{
+	__libc_free( pPointer );
+}
+
+}
+
+const bool AllocationsCounted = true;
+
+#else
+
+const bool AllocationsCounted = false;
+
+#endif
+
+//
+// Cache misses, from the kernel's hardware counters where the CPU has them
+// and perf_event_paranoid lets a user read them (2, the usual default,
+// does for the program's own counts). Elsewhere, including most virtual
+// machines, they read as unavailable.
+//
+
+namespace {
+
+class CacheMissCounter
+{
+public:
+
+	// PERF_COUNT_HW_CACHE_MISSES counts misses of the last level cache; the
+	// L1 data cache read misses come from the generic cache events.
+	CacheMissCounter( uint32_t pType, uint64_t pConfig ) : m_file( -1 )
+	{
+#ifdef __linux__
+		perf_event_attr lAttributes;
+		memset( &lAttributes, 0, sizeof(lAttributes) );
+		lAttributes.type = pType;
+		lAttributes.size = sizeof(lAttributes);
+		lAttributes.config = pConfig;
+		lAttributes.exclude_kernel = 1;
+		lAttributes.exclude_hv = 1;
+
+		m_file = (int) syscall( __NR_perf_event_open, &lAttributes, 0, -1, -1, 0 );
+#else
+		(void) pType;
+		(void) pConfig;
+#endif
+	}
+
+	~CacheMissCounter()
+	{
+#ifdef __linux__
+		if( m_file >= 0 )
+			close( m_file );
+#endif
+	}
+
+	bool isAvailable() const { return m_file >= 0; }
+
+	// Since the counter was opened.
+	uint64_t read() const
+	{
+		uint64_t lCount = 0;
+
+#ifdef __linux__
+		if( m_file >= 0 && ::read( m_file, &lCount, sizeof(lCount) ) != sizeof(lCount) )
+			lCount = 0;
+#endif
+
+		return lCount;
+	}
+
+private:
+
+	CacheMissCounter( const CacheMissCounter& );
+	CacheMissCounter& operator = ( const CacheMissCounter& );
+
+private:
+
+	int m_file;
+};
+
+#ifdef __linux__
+const uint32_t LastLevelMissType = PERF_TYPE_HARDWARE;
+const uint64_t LastLevelMissConfig = PERF_COUNT_HW_CACHE_MISSES;
+const uint32_t L1MissType = PERF_TYPE_HW_CACHE;
+const uint64_t L1MissConfig = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+#else
+const uint32_t LastLevelMissType = 0;
+const uint64_t LastLevelMissConfig = 0;
+const uint32_t L1MissType = 0;
+const uint64_t L1MissConfig = 0;
+#endif
+
+}
+
+namespace {
+
+// Written by every kernel so that the compiler cannot drop its work.
+volatile float g_sink;
+
+// Every input is drawn from this, so that runs see the same data.
+Random g_random;
+
+const float FrameTimeStep = 1.0f / 60.0f;
+
+// A kernel under test, set up for one size. run() is what gets timed.
+class Fixture
+{
+public:
+
+	virtual ~Fixture() {}
+	virtual void run() = 0;
+};
+
+struct Benchmark
+{
+	const char* m_kernel;
+	int32_t m_size;
+
+	// Items processed by one run(), for a given size.
+	int64_t (*m_items)( int32_t pSize );
+
+	// Bytes of state read and written per item.
+	double m_bytesPerItem;
+
+	Fixture* (*m_create)( int32_t pSize );
+};
+
+struct Result
+{
+	std::string m_name;
+	double m_nsPerItem;
+	double m_bytesPerSecond;
+	double m_allocations;   // Per run.
+
+	// Per item, or -1 where the counters are unavailable.
+	double m_l1MissesPerItem;
+	double m_lastLevelMissesPerItem;
+};
+
+int64_t itemsPerSize( int32_t pSize )
+{
+	return pSize;
+}
+
+int64_t pixelsPerSide( int32_t pSize )
+{
+	return (int64_t) pSize * pSize;
+}
+
+//
+// Kernels...
+//
+
+class UpdateFixture : public Fixture
+{
+public:
+
+	UpdateFixture( int32_t pSize ) : m_flakes( pSize ) { m_flakes.spawn( 1 ); }
+
+	virtual void run()
+	{
+		m_flakes.update( FrameTimeStep );
+		g_sink = m_flakes.getPositions()[0];
+	}
+
+private:
+
+	SnowFlakes m_flakes;
+};
+
+class CompactUpdateFixture : public Fixture
+{
+public:
+
+	CompactUpdateFixture( int32_t pSize ) : m_flakes( pSize ) { m_flakes.spawn( 1 ); }
+
+	virtual void run()
+	{
+		m_flakes.update( FrameTimeStep );
+		g_sink = m_flakes.getX()[0];
+	}
+
+private:
+
+	CompactSnowFlakes m_flakes;
+};
+
+class BlockUpdateFixture : public Fixture
+{
+public:
+
+	BlockUpdateFixture( int32_t pSize ) : m_flakes( pSize ) { m_flakes.spawn( 1 ); }
+
+	virtual void run()
+	{
+		m_flakes.update( FrameTimeStep );
+		g_sink = m_flakes.getHotBlocks()[0].x[0];
+	}
+
+private:
+
+	BlockSnowFlakes m_flakes;
+};
+
+typedef ParticleSystem<DynamicCapacity, SwayFeature, FallFeature, RespawnFeature> FlakeParticles;
+typedef ParticleSystem<10000, SwayFeature, FallFeature, RespawnFeature> FixedFlakeParticles;
+typedef ParticleSystem<DynamicCapacity, SwayFeature, FallFeature, WindFeature, NoiseFeature, FadeFeature,
+		RespawnFeature> WeatherParticles;
+
+// Features without parameters take no space in the system.
+static_assert( sizeof(FlakeParticles) == sizeof(ParticleSystem<DynamicCapacity>),
+		"Empty particle features should not add to the system's size" );
+
+void configureWeather( WeatherParticles* pParticles )
+{
+	pParticles->getFeature<WindFeature>().setVelocity( 0.05f );
+	pParticles->getFeature<NoiseFeature>().setAmplitude( 0.001f );
+	pParticles->getFeature<FadeFeature>().setDistance( 1.0f );
+}
+
+// What ParticleSystem saves: every behaviour in one loop, with a switch
+// for each optional one, here all off. The flags are members, so the
+// compiler cannot take the tests out of the loop.
+class RuntimeFeatureFlakes : public ParticleStorage<DynamicCapacity>
+{
+public:
+
+	RuntimeFeatureFlakes( int32_t pCount ) :
+			ParticleStorage<DynamicCapacity>( pCount ),
+			m_wind( false ),
+			m_noise( false ),
+			m_fade( false ),
+			m_windVelocity( 0.0f ),
+			m_noiseAmplitude( 0.0f ),
+			m_frame( 0 )
+	{
+		FlakeParticles lSpawned( pCount );
+		lSpawned.spawn( 1 );
+
+		memcpy( m_pos, lSpawned.getPositions(), pCount * 2 * sizeof(float) );
+		memcpy( m_vel, lSpawned.getVelocities(), pCount * 2 * sizeof(float) );
+		memcpy( m_col, lSpawned.getColors(), pCount * 4 * sizeof(float) );
+		memcpy( m_size, lSpawned.getSizes(), pCount * sizeof(float) );
+		memcpy( m_timeSinceLastTurn, lSpawned.getTurnTimers(), pCount * sizeof(float) );
+	}
+
+	const float* getPositions() const { return m_pos; }
+
+	void update( float pElapsed )
+	{
+		++m_frame;
+
+		for( int32_t i = 0; i < m_count; ++i )
+		{
+			float* lPos = &m_pos[i * 2];
+			float* lVel = &m_vel[i * 2];
+
+			m_timeSinceLastTurn[i] += pElapsed;
+
+			if( m_timeSinceLastTurn[i] >= TimeTillTurn )
+			{
+				lVel[0] = -lVel[0];
+				m_timeSinceLastTurn[i] = m_random.nextFloat( -5.0, 0.0f );
+			}
+
+			lPos[0] += lVel[0] * (m_timeSinceLastTurn[i] * TimeTillTurnNormalizedUnit);
+			lPos[1] += lVel[1];
+
+			if( m_wind )
+				lPos[0] += m_windVelocity * pElapsed;
+
+			if( m_noise )
+				lPos[0] += (float) (((uint32_t) i * 0x85ebca6bu ^ m_frame) >> 8) * m_noiseAmplitude;
+
+			if( m_fade )
+				m_col[i * 4 + 3] = lPos[1] + (ViewMaxY + 0.2f);
+
+			if( lPos[1] < -(ViewMaxY + 0.2f) ||
+				lPos[0] < -(ViewMaxX + 0.2f) || lPos[0] > (ViewMaxX + 0.2f) )
+			{
+				lPos[0] = m_random.nextFloat( -ViewMaxX, ViewMaxX );
+				lPos[1] = 3.1f;
+			}
+		}
+	}
+
+private:
+
+	bool m_wind;
+	bool m_noise;
+	bool m_fade;
+	float m_windVelocity;
+	float m_noiseAmplitude;
+	uint32_t m_frame;
+
+	Random m_random;
+};
+
+template<class T>
+class ParticleUpdateFixture : public Fixture
+{
+public:
+
+	ParticleUpdateFixture( int32_t pSize ) : m_particles( pSize ) { m_particles.spawn( 1 ); }
+
+	virtual void run()
+	{
+		m_particles.update( FrameTimeStep );
+		g_sink = m_particles.getPositions()[0];
+	}
+
+protected:
+
+	T m_particles;
+};
+
+class WeatherUpdateFixture : public ParticleUpdateFixture<WeatherParticles>
+{
+public:
+
+	WeatherUpdateFixture( int32_t pSize ) : ParticleUpdateFixture<WeatherParticles>( pSize )
+	{
+		configureWeather( &m_particles );
+	}
+};
+
+class RuntimeFeatureUpdateFixture : public Fixture
+{
+public:
+
+	RuntimeFeatureUpdateFixture( int32_t pSize ) : m_flakes( pSize ) {}
+
+	virtual void run()
+	{
+		m_flakes.update( FrameTimeStep );
+		g_sink = m_flakes.getPositions()[0];
+	}
+
+private:
+
+	RuntimeFeatureFlakes m_flakes;
+};
+
+// The fixed capacity system is too large for the stack, and its size is
+// its capacity.
+class FixedParticleUpdateFixture : public Fixture
+{
+public:
+
+	FixedParticleUpdateFixture( int32_t ) : m_particles( new FixedFlakeParticles() ) { m_particles->spawn( 1 ); }
+	~FixedParticleUpdateFixture() { delete m_particles; }
+
+	virtual void run()
+	{
+		m_particles->update( FrameTimeStep );
+		g_sink = m_particles->getPositions()[0];
+	}
+
+private:
+
+	FixedParticleUpdateFixture( const FixedParticleUpdateFixture& );
+	FixedParticleUpdateFixture& operator = ( const FixedParticleUpdateFixture& );
+
+	FixedFlakeParticles* m_particles;
+};
+
+// Every spawned flake is in view, so all of them are copied.
+class PackVisibleFixture : public Fixture
+{
+public:
+
+	PackVisibleFixture( int32_t pSize ) :
+			m_flakes( pSize ),
+			m_projection( Affine2f::createOrthographicProjection( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY ) )
+	{
+		m_flakes.spawn( 1 );
+	}
+
+	virtual void run()
+	{
+		g_sink = (float) m_culler.cull( m_flakes, m_projection, 480, 800 );
+	}
+
+private:
+
+	SnowFlakes m_flakes;
+	FlakeCuller m_culler;
+	Affine2f m_projection;
+};
+
+// One row of a sprite pSize pixels wide over a 64 texel wide texture.
+class BlendSpriteRowFixture : public Fixture
+{
+public:
+
+	BlendSpriteRowFixture( int32_t pSize ) : m_row( pSize ), m_texels( 64 )
+	{
+		for( size_t i = 0; i < m_texels.size(); ++i )
+			m_texels[i] = g_random.next();
+
+		m_color[0] = m_color[1] = m_color[2] = m_color[3] = 0.5f / 255.0f;
+	}
+
+	virtual void run()
+	{
+		// Saturated pixels cost the same, so the row is not reset.
+		int32_t lSize = (int32_t) m_row.size();
+		getKernels().m_blendSpriteRow( &m_row[0], 0, lSize, &m_texels[0], (int32_t) m_texels.size(),
+				lSize * 0.5f, 1.0f / lSize, m_color );
+		g_sink = (float) m_row[0];
+	}
+
+private:
+
+	std::vector<uint32_t> m_row;
+	std::vector<uint32_t> m_texels;
+	float m_color[4];
+};
+
+// The generator every random number of the simulation comes from.
+class RandomFloatFixture : public Fixture
+{
+public:
+
+	RandomFloatFixture( int32_t pSize ) : m_values( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_values.size(); ++i )
+			m_values[i] = m_random.nextFloat( -1.0f, 1.0f );
+
+		g_sink = m_values[0];
+	}
+
+private:
+
+	Random m_random;
+	std::vector<float> m_values;
+};
+
+// Cross product, normalize and dot product, the usual mix in lighting and
+// camera code.
+class Vector3fFixture : public Fixture
+{
+public:
+
+	Vector3fFixture( int32_t pSize ) :
+			m_a( pSize ),
+			m_b( pSize ),
+			m_out( pSize )
+	{
+		for( int32_t i = 0; i < pSize; ++i )
+		{
+			m_a[i].set( g_random.nextFloat( -1.0f, 1.0f ), g_random.nextFloat( -1.0f, 1.0f ), g_random.nextFloat( 0.1f, 1.0f ) );
+			m_b[i].set( g_random.nextFloat( 0.1f, 1.0f ), g_random.nextFloat( -1.0f, 1.0f ), g_random.nextFloat( -1.0f, 1.0f ) );
+		}
+	}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+		{
+			Vector3f lNormal = Vector3f::crossProduct( m_a[i], m_b[i] );
+			lNormal.normalize();
+			m_out[i] = lNormal * Vector3f::dotProduct( m_a[i], m_b[i] );
+		}
+
+		g_sink = m_out[0].x;
+	}
+
+private:
+
+	std::vector<Vector3f> m_a, m_b, m_out;
+};
+
+// Matrix4x4f's rotate, scale and translate methods replace the matrix
+// rather than add to it, so the parts are multiplied together.
+// p + v * t + a * (t * t / 2) per item, the integration step of a
+// particle, written three ways: with the inline operators, with every
+// operator an out-of-line call the way vector3f.cpp used to have them, and
+// with the expression templates.
+class Vector3fIntegrateFixture : public Fixture
+{
+public:
+
+	Vector3fIntegrateFixture( int32_t pSize ) :
+			m_position( pSize ),
+			m_velocity( pSize ),
+			m_acceleration( pSize ),
+			m_out( pSize )
+	{
+		for( int32_t i = 0; i < pSize; ++i )
+		{
+			m_position[i].set( g_random.nextFloat( -2.0f, 2.0f ), g_random.nextFloat( -3.0f, 3.0f ), 0.0f );
+			m_velocity[i].set( g_random.nextFloat( -0.5f, 0.5f ), g_random.nextFloat( -1.0f, 0.0f ), 0.0f );
+			m_acceleration[i].set( g_random.nextFloat( -0.1f, 0.1f ), -0.98f, 0.0f );
+		}
+	}
+
+	virtual void run()
+	{
+		const float t = FrameTimeStep;
+		const float lHalfTSquared = t * t * 0.5f;
+
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = m_position[i] + m_velocity[i] * t + m_acceleration[i] * lHalfTSquared;
+
+		g_sink = m_out[0].x;
+	}
+
+protected:
+
+	std::vector<Vector3f> m_position, m_velocity, m_acceleration, m_out;
+};
+
+__attribute__((noinline)) Vector3f outOfLineAdd( const Vector3f& a, const Vector3f& b ) { return a + b; }
+__attribute__((noinline)) Vector3f outOfLineScale( const Vector3f& a, float s ) { return a * s; }
+
+class Vector3fIntegrateOutOfLineFixture : public Vector3fIntegrateFixture
+{
+public:
+
+	Vector3fIntegrateOutOfLineFixture( int32_t pSize ) : Vector3fIntegrateFixture( pSize ) {}
+
+	virtual void run()
+	{
+		const float t = FrameTimeStep;
+		const float lHalfTSquared = t * t * 0.5f;
+
+		for( size_t i = 0; i < m_out.size(); ++i )
+		{
+			m_out[i] = outOfLineAdd( outOfLineAdd( m_position[i], outOfLineScale( m_velocity[i], t ) ),
+					outOfLineScale( m_acceleration[i], lHalfTSquared ) );
+		}
+
+		g_sink = m_out[0].x;
+	}
+};
+
+class Vector3fIntegrateExpressionFixture : public Vector3fIntegrateFixture
+{
+public:
+
+	Vector3fIntegrateExpressionFixture( int32_t pSize ) : Vector3fIntegrateFixture( pSize ) {}
+
+	virtual void run()
+	{
+		const float t = FrameTimeStep;
+		const float lHalfTSquared = t * t * 0.5f;
+
+		for( size_t i = 0; i < m_out.size(); ++i )
+		{
+			m_out[i] = evaluate<Vector3f>( expression( m_acceleration[i] ) * lHalfTSquared +
+					(expression( m_velocity[i] ) * t + expression( m_position[i] )) );
+		}
+
+		g_sink = m_out[0].x;
+	}
+};
+
+Matrix4x4f createRandomTransform()
+{
+	Matrix4x4f lRotateX, lRotateY, lRotateZ, lScale, lTranslate;
+	lRotateX.rotate_x( g_random.nextFloat( 0.0f, 360.0f ) );
+	lRotateY.rotate_y( g_random.nextFloat( 0.0f, 360.0f ) );
+	lRotateZ.rotate_z( g_random.nextFloat( 0.0f, 360.0f ) );
+	lScale.scale( Vector3f( g_random.nextFloat( 0.5f, 2.0f ), g_random.nextFloat( 0.5f, 2.0f ), g_random.nextFloat( 0.5f, 2.0f ) ) );
+	lTranslate.translate( Vector3f( g_random.nextFloat( -10.0f, 10.0f ), g_random.nextFloat( -10.0f, 10.0f ), g_random.nextFloat( -10.0f, 10.0f ) ) );
+	return Matrix4x4f::multiplyReference( &lTranslate, &lRotateZ ) * lRotateY * lRotateX * lScale;
+}
+
+class MatrixFixture : public Fixture
+{
+public:
+
+	MatrixFixture( int32_t pSize ) :
+			m_a( pSize ),
+			m_b( pSize ),
+			m_out( pSize )
+	{
+		for( int32_t i = 0; i < pSize; ++i )
+		{
+			m_a[i] = createRandomTransform();
+			m_b[i] = createRandomTransform();
+		}
+	}
+
+protected:
+
+	std::vector<Matrix4x4f> m_a, m_b, m_out;
+};
+
+class MatrixMultiplyFixture : public MatrixFixture
+{
+public:
+
+	MatrixMultiplyFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = m_a[i] * m_b[i];
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+class MatrixInvertFixture : public MatrixFixture
+{
+public:
+
+	MatrixInvertFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = Matrix4x4f::invertMatrix( &m_a[i] );
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+class MatrixInvertAffineFixture : public MatrixFixture
+{
+public:
+
+	MatrixInvertAffineFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = Matrix4x4f::invertAffine( &m_a[i] );
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+class MatrixTransposeFixture : public MatrixFixture
+{
+public:
+
+	MatrixTransposeFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = Matrix4x4f::transpose( &m_a[i] );
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+// The scalar code the SIMD versions are checked against, to show what they
+// gain.
+class MatrixMultiplyReferenceFixture : public MatrixFixture
+{
+public:
+
+	MatrixMultiplyReferenceFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = Matrix4x4f::multiplyReference( &m_a[i], &m_b[i] );
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+class MatrixInvertReferenceFixture : public MatrixFixture
+{
+public:
+
+	MatrixInvertReferenceFixture( int32_t pSize ) : MatrixFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_out.size(); ++i )
+			m_out[i] = Matrix4x4f::invertMatrixReference( &m_a[i] );
+
+		g_sink = m_out[0].m[0];
+	}
+};
+
+// Flake positions (SoA, packed x, y like SnowFlakes keeps them, or packed
+// x, y, z) through one transform, on this thread or on a pool of every
+// core.
+class PointTransformFixture : public Fixture
+{
+public:
+
+	PointTransformFixture( int32_t pSize, int32_t pThreadCount ) :
+			m_matrix( createRandomTransform() ),
+			m_in( pSize * 3 ),
+			m_out( pSize * 3 ),
+			m_size( pSize ),
+			m_pool( pThreadCount )
+	{
+		for( size_t i = 0; i < m_in.size(); ++i )
+			m_in[i] = g_random.nextFloat( -ViewMaxY, ViewMaxY );
+	}
+
+protected:
+
+	Matrix4x4f m_matrix;
+	std::vector<float> m_in, m_out;
+	int32_t m_size;
+	WorkerPool m_pool;
+};
+
+class TransformPointsFixture : public PointTransformFixture
+{
+public:
+
+	TransformPointsFixture( int32_t pSize ) : PointTransformFixture( pSize, 1 ) {}
+
+	virtual void run()
+	{
+		transformPoints( m_matrix, &m_in[0], &m_in[m_size], &m_in[m_size * 2],
+				&m_out[0], &m_out[m_size], &m_out[m_size * 2], m_size, NULL );
+		g_sink = m_out[0];
+	}
+};
+
+class TransformPackedPoints2DFixture : public PointTransformFixture
+{
+public:
+
+	TransformPackedPoints2DFixture( int32_t pSize ) : PointTransformFixture( pSize, 1 ) {}
+
+	virtual void run()
+	{
+		transformPackedPoints2D( m_matrix, &m_in[0], &m_out[0], m_size, NULL );
+		g_sink = m_out[0];
+	}
+};
+
+class TransformPackedPointsFixture : public PointTransformFixture
+{
+public:
+
+	TransformPackedPointsFixture( int32_t pSize ) : PointTransformFixture( pSize, 1 ) {}
+
+	virtual void run()
+	{
+		transformPackedPoints( m_matrix, &m_in[0], &m_out[0], m_size, NULL );
+		g_sink = m_out[0];
+	}
+};
+
+class TransformPackedPoints2DPoolFixture : public PointTransformFixture
+{
+public:
+
+	TransformPackedPoints2DPoolFixture( int32_t pSize ) :
+			PointTransformFixture( pSize, (int32_t) std::thread::hardware_concurrency() )
+	{
+	}
+
+	virtual void run()
+	{
+		transformPackedPoints2D( m_matrix, &m_in[0], &m_out[0], m_size, &m_pool );
+		g_sink = m_out[0];
+	}
+};
+
+// One point at a time through Matrix4x4f::transformPoint(), for comparison.
+class TransformPointLoopFixture : public PointTransformFixture
+{
+public:
+
+	TransformPointLoopFixture( int32_t pSize ) : PointTransformFixture( pSize, 1 ) {}
+
+	virtual void run()
+	{
+		for( int32_t i = 0; i < m_size; ++i )
+		{
+			Vector3f lPoint( m_in[i * 3 + 0], m_in[i * 3 + 1], m_in[i * 3 + 2] );
+			m_matrix.transformPoint( &lPoint );
+			m_out[i * 3 + 0] = lPoint.x;
+			m_out[i * 3 + 1] = lPoint.y;
+			m_out[i * 3 + 2] = lPoint.z;
+		}
+
+		g_sink = m_out[0];
+	}
+};
+
+// A sine and cosine per flake, for a sway or a rotation, from libm, from
+// sinCos() one at a time and from sinCosArray().
+class SinCosFixture : public Fixture
+{
+public:
+
+	SinCosFixture( int32_t pSize ) : m_angles( pSize ), m_sin( pSize ), m_cos( pSize )
+	{
+		for( int32_t i = 0; i < pSize; ++i )
+			m_angles[i] = g_random.nextFloat( -100.0f, 100.0f );
+	}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_angles.size(); ++i )
+		{
+			m_sin[i] = sinf( m_angles[i] );
+			m_cos[i] = cosf( m_angles[i] );
+		}
+
+		g_sink = m_sin[0] + m_cos[0];
+	}
+
+protected:
+
+	std::vector<float> m_angles, m_sin, m_cos;
+};
+
+class FastSinCosFixture : public SinCosFixture
+{
+public:
+
+	FastSinCosFixture( int32_t pSize ) : SinCosFixture( pSize ) {}
+
+	virtual void run()
+	{
+		for( size_t i = 0; i < m_angles.size(); ++i )
+			sinCos( m_angles[i], &m_sin[i], &m_cos[i] );
+
+		g_sink = m_sin[0] + m_cos[0];
+	}
+};
+
+class SinCosArrayFixture : public SinCosFixture
+{
+public:
+
+	SinCosArrayFixture( int32_t pSize ) : SinCosFixture( pSize ) {}
+
+	virtual void run()
+	{
+		sinCosArray( &m_angles[0], &m_sin[0], &m_cos[0], (int32_t) m_angles.size() );
+		g_sink = m_sin[0] + m_cos[0];
+	}
+};
+
+// An empty zone per item, which is the overhead a zone adds to the code it
+// wraps.
+class ProfilerZoneFixture : public Fixture
+{
+public:
+
+	ProfilerZoneFixture( int32_t pSize ) : m_size( pSize ) {}
+
+	virtual void run()
+	{
+		for( int32_t i = 0; i < m_size; ++i )
+		{
+			GUILDHALL_PROFILE_ZONE( "Benchmark zone" );
+			g_sink = (float) i;
+		}
+	}
+
+private:
+
+	int32_t m_size;
+};
+
+// Texture only exposes decoding to subclasses.
+class DecodeTexture : public Texture
+{
+public:
+
+	DecodeTexture( const char* pPath ) : Texture( NULL, pPath ) {}
+
+	uint8_t* decode() { return loadImage(); }
+};
+
+bool writeTestImage( const std::string& pPath, int32_t pSize )
+{
+	FILE* lFile = fopen( pPath.c_str(), "wb" );
+
+	if( lFile == NULL )
+		return false;
+
+	png_structp lPngPtr = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+	png_infop lInfoPtr = png_create_info_struct( lPngPtr );
+
+	if( setjmp( png_jmpbuf(lPngPtr) ) )
+	{
+		png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+		fclose( lFile );
+		return false;
+	}
+
+	png_init_io( lPngPtr, lFile );
+	png_set_IHDR( lPngPtr, lInfoPtr, pSize, pSize, 8, PNG_COLOR_TYPE_RGBA,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+	png_write_info( lPngPtr, lInfoPtr );
+
+	// Same soft gradients with a little noise as png_decode_bench.
+	std::vector<png_byte> lRow( pSize * 4 );
+
+	for( int32_t y = 0; y < pSize; ++y )
+	{
+		for( int32_t x = 0; x < pSize; ++x )
+		{
+			lRow[x * 4 + 0] = (png_byte)(x * 255 / pSize);
+			lRow[x * 4 + 1] = (png_byte)(y * 255 / pSize);
+			lRow[x * 4 + 2] = (png_byte)(g_random.next() & 0x1f);
+			lRow[x * 4 + 3] = 0xff;
+		}
+
+		png_write_row( lPngPtr, &lRow[0] );
+	}
+
+	png_write_end( lPngPtr, NULL );
+	png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+	fclose( lFile );
+	return true;
+}
+
+class PngDecodeFixture : public Fixture
+{
+public:
+
+	PngDecodeFixture( int32_t pSize )
+	{
+		const char* lTempDir = getenv( "TMPDIR" );
+		char lName[64];
+		snprintf( lName, sizeof(lName), "/snowflakes_micro_%d.png", pSize );
+		m_path = std::string( lTempDir ? lTempDir : "/tmp" ) + lName;
+
+		if( !writeTestImage( m_path, pSize ) )
+		{
+			fprintf( stderr, "Unable to write %s\n", m_path.c_str() );
+			exit( EXIT_FAILURE );
+		}
+	}
+
+	~PngDecodeFixture()
+	{
+		remove( m_path.c_str() );
+	}
+
+	virtual void run()
+	{
+		DecodeTexture lTexture( m_path.c_str() );
+		uint8_t* lPixels = lTexture.decode();
+
+		if( lPixels == NULL )
+		{
+			fprintf( stderr, "Unable to decode %s\n", m_path.c_str() );
+			exit( EXIT_FAILURE );
+		}
+
+		g_sink = lPixels[0];
+		freeMemory( lPixels );
+	}
+
+private:
+
+	std::string m_path;
+};
+
+template<class T>
+Fixture* create( int32_t pSize )
+{
+	return new T( pSize );
+}
+
+// Bytes per item: the float update streams position, velocity and turn
+// timer in and out, from separate arrays or from blocks, and the compact
+// one reads 8 bytes of fixed point position, velocity and turn start and
+// writes the 4 of position back. Packing reads and writes position, colour
+// and size; a blended pixel reads a texel and reads and writes the colour
+// buffer.
+const Benchmark Benchmarks[] =
+{
+	{ "update", 200, itemsPerSize, 40.0, create<UpdateFixture> },
+	{ "update", 1000, itemsPerSize, 40.0, create<UpdateFixture> },
+	{ "update", 10000, itemsPerSize, 40.0, create<UpdateFixture> },
+	{ "update", 100000, itemsPerSize, 40.0, create<UpdateFixture> },
+	{ "update", 1000000, itemsPerSize, 40.0, create<UpdateFixture> },
+	{ "particles", 10000, itemsPerSize, 40.0, create< ParticleUpdateFixture<FlakeParticles> > },
+	{ "particles", 100000, itemsPerSize, 40.0, create< ParticleUpdateFixture<FlakeParticles> > },
+	{ "particles_fixed", 10000, itemsPerSize, 40.0, create<FixedParticleUpdateFixture> },
+	{ "particles_runtime_flags", 10000, itemsPerSize, 40.0, create<RuntimeFeatureUpdateFixture> },
+	{ "particles_runtime_flags", 100000, itemsPerSize, 40.0, create<RuntimeFeatureUpdateFixture> },
+	{ "particles_weather", 10000, itemsPerSize, 44.0, create<WeatherUpdateFixture> },
+	{ "particles_weather", 100000, itemsPerSize, 44.0, create<WeatherUpdateFixture> },
+	{ "update_blocks", 200, itemsPerSize, 40.0, create<BlockUpdateFixture> },
+	{ "update_blocks", 1000, itemsPerSize, 40.0, create<BlockUpdateFixture> },
+	{ "update_blocks", 10000, itemsPerSize, 40.0, create<BlockUpdateFixture> },
+	{ "update_blocks", 100000, itemsPerSize, 40.0, create<BlockUpdateFixture> },
+	{ "update_blocks", 1000000, itemsPerSize, 40.0, create<BlockUpdateFixture> },
+	{ "pack_visible", 10000, itemsPerSize, 56.0, create<PackVisibleFixture> },
+	{ "pack_visible", 100000, itemsPerSize, 56.0, create<PackVisibleFixture> },
+	{ "blend_sprite_row", 16, itemsPerSize, 12.0, create<BlendSpriteRowFixture> },
+	{ "blend_sprite_row", 64, itemsPerSize, 12.0, create<BlendSpriteRowFixture> },
+	{ "update_compact", 200, itemsPerSize, 12.0, create<CompactUpdateFixture> },
+	{ "update_compact", 1000, itemsPerSize, 12.0, create<CompactUpdateFixture> },
+	{ "update_compact", 10000, itemsPerSize, 12.0, create<CompactUpdateFixture> },
+	{ "update_compact", 100000, itemsPerSize, 12.0, create<CompactUpdateFixture> },
+	{ "update_compact", 1000000, itemsPerSize, 12.0, create<CompactUpdateFixture> },
+	{ "random_float", 200, itemsPerSize, 4.0, create<RandomFloatFixture> },
+	{ "random_float", 10000, itemsPerSize, 4.0, create<RandomFloatFixture> },
+	{ "random_float", 1000000, itemsPerSize, 4.0, create<RandomFloatFixture> },
+	{ "vector3f_cross_normalize_dot", 200, itemsPerSize, 36.0, create<Vector3fFixture> },
+	{ "vector3f_cross_normalize_dot", 10000, itemsPerSize, 36.0, create<Vector3fFixture> },
+	{ "vector3f_cross_normalize_dot", 1000000, itemsPerSize, 36.0, create<Vector3fFixture> },
+	{ "vector3f_integrate", 10000, itemsPerSize, 48.0, create<Vector3fIntegrateFixture> },
+	{ "vector3f_integrate_out_of_line", 10000, itemsPerSize, 48.0, create<Vector3fIntegrateOutOfLineFixture> },
+	{ "vector3f_integrate_expression", 10000, itemsPerSize, 48.0, create<Vector3fIntegrateExpressionFixture> },
+	{ "matrix4x4f_multiply", 200, itemsPerSize, 192.0, create<MatrixMultiplyFixture> },
+	{ "matrix4x4f_multiply", 10000, itemsPerSize, 192.0, create<MatrixMultiplyFixture> },
+	{ "matrix4x4f_invert", 200, itemsPerSize, 128.0, create<MatrixInvertFixture> },
+	{ "matrix4x4f_invert", 10000, itemsPerSize, 128.0, create<MatrixInvertFixture> },
+	{ "matrix4x4f_invert_affine", 200, itemsPerSize, 128.0, create<MatrixInvertAffineFixture> },
+	{ "matrix4x4f_invert_affine", 10000, itemsPerSize, 128.0, create<MatrixInvertAffineFixture> },
+	{ "matrix4x4f_transpose", 200, itemsPerSize, 128.0, create<MatrixTransposeFixture> },
+	{ "matrix4x4f_transpose", 10000, itemsPerSize, 128.0, create<MatrixTransposeFixture> },
+	{ "matrix4x4f_multiply_reference", 200, itemsPerSize, 192.0, create<MatrixMultiplyReferenceFixture> },
+	{ "matrix4x4f_multiply_reference", 10000, itemsPerSize, 192.0, create<MatrixMultiplyReferenceFixture> },
+	{ "matrix4x4f_invert_reference", 200, itemsPerSize, 128.0, create<MatrixInvertReferenceFixture> },
+	{ "matrix4x4f_invert_reference", 10000, itemsPerSize, 128.0, create<MatrixInvertReferenceFixture> },
+	{ "transform_point_loop", 100000, itemsPerSize, 24.0, create<TransformPointLoopFixture> },
+	{ "transform_points", 10000, itemsPerSize, 24.0, create<TransformPointsFixture> },
+	{ "transform_points", 100000, itemsPerSize, 24.0, create<TransformPointsFixture> },
+	{ "transform_packed_points", 100000, itemsPerSize, 24.0, create<TransformPackedPointsFixture> },
+	{ "transform_packed_points_2d", 10000, itemsPerSize, 16.0, create<TransformPackedPoints2DFixture> },
+	{ "transform_packed_points_2d", 100000, itemsPerSize, 16.0, create<TransformPackedPoints2DFixture> },
+	{ "transform_packed_points_2d", 1000000, itemsPerSize, 16.0, create<TransformPackedPoints2DFixture> },
+	{ "transform_packed_points_2d_pool", 100000, itemsPerSize, 16.0, create<TransformPackedPoints2DPoolFixture> },
+	{ "transform_packed_points_2d_pool", 1000000, itemsPerSize, 16.0, create<TransformPackedPoints2DPoolFixture> },
+	{ "sincos_libm", 10000, itemsPerSize, 12.0, create<SinCosFixture> },
+	{ "sincos", 10000, itemsPerSize, 12.0, create<FastSinCosFixture> },
+	{ "sincos_array", 10000, itemsPerSize, 12.0, create<SinCosArrayFixture> },
+	{ "sincos_array", 1000000, itemsPerSize, 12.0, create<SinCosArrayFixture> },
+	{ "profiler_zone", 1000, itemsPerSize, 24.0, create<ProfilerZoneFixture> },
+	{ "png_decode", 256, pixelsPerSide, 4.0, create<PngDecodeFixture> },
+	{ "png_decode", 1024, pixelsPerSide, 4.0, create<PngDecodeFixture> },
+};
+
+//
+// Agreement of the SIMD Matrix4x4f code with the scalar references...
+//
+
+// The largest difference between two matrices, in units of FLT_EPSILON
+// times their largest element (one ULP of it, give or take a factor of
+// two). Measured against the largest element rather than each one, since
+// cancellation leaves small elements with large relative errors in both.
+double matrixError( const Matrix4x4f& pResult, const Matrix4x4f& pReference )
+{
+	float lScale = 1.0f;
+
+	for( int32_t i = 0; i < 16; ++i )
+		lScale = std::max( lScale, fabsf( pReference.m[i] ) );
+
+	double lError = 0.0;
+
+	for( int32_t i = 0; i < 16; ++i )
+		lError = std::max( lError, fabs( (double) pResult.m[i] - pReference.m[i] ) / (FLT_EPSILON * lScale) );
+
+	return lError;
+}
+
+struct MatrixCheck
+{
+	const char* m_name;
+	double m_maxError;
+	double m_error;
+};
+
+// Multiplies and transposes are exact; the inverses round differently.
+status checkMatrices()
+{
+	MatrixCheck lChecks[] =
+	{
+		{ "multiply", 0.0, 0.0 },
+		{ "transpose", 0.0, 0.0 },
+		{ "invert", 16.0, 0.0 },
+		{ "invert_affine", 16.0, 0.0 },
+	};
+
+#if GUILDHALL_SIMD_NEON
+	// NEON may fuse the multiply-adds, which rounds once instead of twice.
+	lChecks[0].m_maxError = 4.0;
+#endif
+
+	for( int32_t i = 0; i < 10000; ++i )
+	{
+		Matrix4x4f lA = createRandomTransform();
+		Matrix4x4f lB = createRandomTransform();
+
+		lChecks[0].m_error = std::max( lChecks[0].m_error,
+				matrixError( lA * lB, Matrix4x4f::multiplyReference( &lA, &lB ) ) );
+		lChecks[1].m_error = std::max( lChecks[1].m_error,
+				matrixError( Matrix4x4f::transpose( &lA ), Matrix4x4f::transposeReference( &lA ) ) );
+		lChecks[2].m_error = std::max( lChecks[2].m_error,
+				matrixError( Matrix4x4f::invertMatrix( &lA ), Matrix4x4f::invertMatrixReference( &lA ) ) );
+		lChecks[3].m_error = std::max( lChecks[3].m_error,
+				matrixError( Matrix4x4f::invertAffine( &lA ), Matrix4x4f::invertAffineReference( &lA ) ) );
+	}
+
+	status lStatus = STATUS_OK;
+
+	for( size_t i = 0; i < sizeof(lChecks) / sizeof(lChecks[0]); ++i )
+	{
+		bool lFailed = lChecks[i].m_error > lChecks[i].m_maxError;
+		printf( "matrix4x4f_%s agrees with the reference within %.2f ULP (at most %.0f)%s\n",
+				lChecks[i].m_name, lChecks[i].m_error, lChecks[i].m_maxError, lFailed ? "  MISMATCH" : "" );
+
+		if( lFailed )
+			lStatus = STATUS_ERROR;
+	}
+
+	return lStatus;
+}
+
+// Every batch transform against Matrix4x4f::transformPoint(), over a
+// count that leaves a partial group of four and spans several chunks of
+// a pool.
+status checkPointTransforms()
+{
+	const int32_t lCount = PointTransformChunkSize * 3 + 7;
+	Matrix4x4f lMatrix = createRandomTransform();
+	std::vector<float> lIn( lCount * 3 ), lExpected( lCount * 3 ), lExpected2D( lCount * 2 );
+
+	for( int32_t i = 0; i < lCount * 3; ++i )
+		lIn[i] = g_random.nextFloat( -ViewMaxY, ViewMaxY );
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		Vector3f lPoint( lIn[i * 3 + 0], lIn[i * 3 + 1], lIn[i * 3 + 2] );
+		lMatrix.transformPoint( &lPoint );
+		lExpected[i * 3 + 0] = lPoint.x;
+		lExpected[i * 3 + 1] = lPoint.y;
+		lExpected[i * 3 + 2] = lPoint.z;
+
+		lPoint = Vector3f( lIn[i * 3 + 0], lIn[i * 3 + 1], 0.0f );
+		lMatrix.transformPoint( &lPoint );
+		lExpected2D[i * 2 + 0] = lPoint.x;
+		lExpected2D[i * 2 + 1] = lPoint.y;
+	}
+
+	WorkerPool lPool( 4 );
+	WorkerPool* lPools[2] = { NULL, &lPool };
+	int32_t lMismatches = 0;
+
+	for( int32_t p = 0; p < 2; ++p )
+	{
+		std::vector<float> lSoA( lCount * 3 ), lOut( lCount * 3 );
+
+		for( int32_t i = 0; i < lCount; ++i )
+			for( int32_t c = 0; c < 3; ++c )
+				lSoA[c * lCount + i] = lIn[i * 3 + c];
+
+		transformPoints( lMatrix, &lSoA[0], &lSoA[lCount], &lSoA[lCount * 2],
+				&lOut[0], &lOut[lCount], &lOut[lCount * 2], lCount, lPools[p] );
+
+		for( int32_t i = 0; i < lCount; ++i )
+			for( int32_t c = 0; c < 3; ++c )
+				lMismatches += (lOut[c * lCount + i] != lExpected[i * 3 + c]);
+
+		transformPoints2D( lMatrix, &lSoA[0], &lSoA[lCount], &lOut[0], &lOut[lCount], lCount, lPools[p] );
+
+		for( int32_t i = 0; i < lCount; ++i )
+			for( int32_t c = 0; c < 2; ++c )
+				lMismatches += (lOut[c * lCount + i] != lExpected2D[i * 2 + c]);
+
+		// In place.
+		lOut = lIn;
+		transformPackedPoints( lMatrix, &lOut[0], &lOut[0], lCount, lPools[p] );
+		lMismatches += (memcmp( &lOut[0], &lExpected[0], lCount * 3 * sizeof(float) ) != 0);
+
+		std::vector<float> lPacked2D( lCount * 2 );
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			lPacked2D[i * 2 + 0] = lIn[i * 3 + 0];
+			lPacked2D[i * 2 + 1] = lIn[i * 3 + 1];
+		}
+
+		transformPackedPoints2D( lMatrix, &lPacked2D[0], &lOut[0], lCount, lPools[p] );
+		lMismatches += (memcmp( &lOut[0], &lExpected2D[0], lCount * 2 * sizeof(float) ) != 0);
+	}
+
+	// An Affine2f through its overloads against Affine2f::transformPoint(),
+	// and composed with its inverse against the identity.
+	Affine2f lRotation, lScale, lTranslation;
+	lRotation.rotate( g_random.nextFloat( 0.0f, 360.0f ) );
+	lScale.scale( Vector2f( g_random.nextFloat( 0.5f, 2.0f ), g_random.nextFloat( 0.5f, 2.0f ) ) );
+	lTranslation.translate( Vector2f( g_random.nextFloat( -ViewMaxX, ViewMaxX ), g_random.nextFloat( -ViewMaxY, ViewMaxY ) ) );
+	Affine2f lAffine = lTranslation * lRotation * lScale;
+
+	std::vector<float> lPacked2D( lCount * 2 ), lOut( lCount * 2 );
+
+	for( int32_t i = 0; i < lCount * 2; ++i )
+		lPacked2D[i] = lIn[i];
+
+	transformPackedPoints2D( lAffine, &lPacked2D[0], &lOut[0], lCount, NULL );
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		Vector2f lPoint = lAffine.transformPoint( Vector2f( lPacked2D[i * 2 + 0], lPacked2D[i * 2 + 1] ) );
+		lMismatches += (lOut[i * 2 + 0] != lPoint.x || lOut[i * 2 + 1] != lPoint.y);
+	}
+
+	Affine2f lIdentity = Affine2f::invert( &lAffine ) * lAffine;
+
+	for( int32_t i = 0; i < 6; ++i )
+		lMismatches += (fabsf( lIdentity.m[i] - Affine2f().m[i] ) > 1.0e-5f);
+
+	printf( "transform_points agree with Matrix4x4f::transformPoint%s\n", lMismatches ? "  MISMATCH" : "" );
+	return (lMismatches == 0) ? STATUS_OK : STATUS_ERROR;
+}
+
+// In units of the spacing of floats at the exact result.
+double ulpError( float pResult, double pExact )
+{
+	if( isnan( pExact ) )
+		return isnan( pResult ) ? 0.0 : DBL_MAX;
+
+	float lRounded = (float) pExact;
+	double lUlp = (double) nextafterf( fabsf( lRounded ), INFINITY ) - fabs( (double) lRounded );
+	return fabs( pResult - pExact ) / lUlp;
+}
+
+// sinCos() and sinCosArray() against libm's double sin and cos, over the
+// whole range they compute themselves, over a few turns either side of 0
+// and past the range, where they hand over to libm.
+status checkSinCos()
+{
+	const double lBound = 3.0;
+	const int32_t lCount = 300003;
+	std::vector<float> lAngles( lCount ), lSin( lCount ), lCos( lCount );
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		if( i % 3 == 0 )
+			lAngles[i] = g_random.nextFloat( -SinCosRangeLimit, SinCosRangeLimit );
+		else if( i % 3 == 1 )
+			lAngles[i] = g_random.nextFloat( -8.0f * (float) M_PI, 8.0f * (float) M_PI );
+		else
+			lAngles[i] = g_random.nextFloat( -1.0e6f, 1.0e6f );
+	}
+
+	lAngles[0] = 0.0f;
+	lAngles[1] = -0.0f;
+	lAngles[2] = INFINITY;
+	lAngles[3] = NAN;
+
+	sinCosArray( &lAngles[0], &lSin[0], &lCos[0], lCount );
+
+	double lError = 0.0;
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		float lScalarSin, lScalarCos;
+		sinCos( lAngles[i], &lScalarSin, &lScalarCos );
+
+		double lExactSin = sin( (double) lAngles[i] );
+		double lExactCos = cos( (double) lAngles[i] );
+
+		lError = std::max( lError, ulpError( lSin[i], lExactSin ) );
+		lError = std::max( lError, ulpError( lCos[i], lExactCos ) );
+		lError = std::max( lError, ulpError( lScalarSin, lExactSin ) );
+		lError = std::max( lError, ulpError( lScalarCos, lExactCos ) );
+	}
+
+	bool lAgrees = (lError <= lBound);
+	printf( "sincos agrees with libm within %.2f ULP (at most %.0f)%s\n", lError, lBound, lAgrees ? "" : "  MISMATCH" );
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+// CompactSnowFlakes against SnowFlakes over ten seconds: before every step
+// the compact state is assigned from the float one, both take the step and
+// the positions are compared in pixels of the 480 by 800 reference view.
+// Flakes that turn or respawn in either, or whose timer is within two
+// ticks of turning, are left out, since a tick's rounding can tip those
+// either way.
+status checkCompactFlakes()
+{
+	const double lBound = 1.0 / 16.0;
+	const float lPixelsPerUnitX = 480.0f / (2.0f * ViewMaxX);
+	const float lPixelsPerUnitY = 800.0f / (2.0f * ViewMaxY);
+	const float lTick = 1.0f / (1 << CompactSnowFlakes::TimeShift);
+	const int32_t lCount = 10003;
+
+	SnowFlakes lFlakes( lCount );
+	CompactSnowFlakes lCompact( lCount );
+	std::vector<float> lBefore( lCount * 2 ), lPositions( lCount * 2 ), lColors( lCount * 4 ), lSizes( lCount );
+	std::vector<float> lTimers( lCount );
+	int64_t lCompared = 0;
+	int64_t lSkipped = 0;
+	double lError = 0.0;
+
+	lFlakes.spawn( 1 );
+
+	for( int32_t lStep = 0; lStep < 600; ++lStep )
+	{
+		lCompact.assign( lFlakes );
+		memcpy( &lBefore[0], lFlakes.getPositions(), lCount * 2 * sizeof(float) );
+		memcpy( &lTimers[0], lFlakes.getTurnTimers(), lCount * sizeof(float) );
+
+		lFlakes.update( FrameTimeStep );
+		lCompact.update( FrameTimeStep );
+		lCompact.decodeRenderState( &lPositions[0], &lColors[0], &lSizes[0] );
+
+		const float* lExpected = lFlakes.getPositions();
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			bool lTurned = lFlakes.getTurnTimers()[i] < lTimers[i] ||
+					fabsf( lTimers[i] + FrameTimeStep - TimeTillTurn ) < 2.0f * lTick;
+			bool lRespawned = fabsf( lExpected[i * 2 + 1] - lBefore[i * 2 + 1] ) > 0.1f ||
+					fabsf( lPositions[i * 2 + 1] - lBefore[i * 2 + 1] ) > 0.1f;
+
+			if( lTurned || lRespawned )
+			{
+				++lSkipped;
+				continue;
+			}
+
+			lError = std::max( lError, (double) fabsf( lPositions[i * 2 + 0] - lExpected[i * 2 + 0] ) * lPixelsPerUnitX );
+			lError = std::max( lError, (double) fabsf( lPositions[i * 2 + 1] - lExpected[i * 2 + 1] ) * lPixelsPerUnitY );
+			++lCompared;
+		}
+	}
+
+	bool lAgrees = (lError <= lBound);
+	printf( "compact flakes agree with float within %.4f pixels (at most %.4f, %lld flake steps compared, %lld turning or respawning)%s\n",
+			lError, lBound, (long long) lCompared, (long long) lSkipped, lAgrees ? "" : "  MISMATCH" );
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+// CompactSnowFlakes against SnowFlakes over five seconds from a single
+// assign(), so that the rounding adds up. Each step can move a flake half
+// a unit in the last place of its quantised velocity and of the rounded x
+// step further from the float one, plus half a float ulp on the float
+// side. The x step is the velocity scaled by the time since the turn over
+// TimeTillTurn, which runs from -5/3 after a wait to 1, and which the
+// rounded timestep and turn time put off by a little more every step. A
+// flake is compared until it first turns or respawns in either.
+status checkCompactDrift()
+{
+	const int32_t lSteps = 300;
+	const float lPixelsPerUnitX = 480.0f / (2.0f * ViewMaxX);
+	const float lPixelsPerUnitY = 800.0f / (2.0f * ViewMaxY);
+	const float lTick = 1.0f / (1 << CompactSnowFlakes::TimeShift);
+	const double lFloatStep = ldexp( 1.0, -22 );
+	const double lLargestScale = 5.0 / TimeTillTurn;
+	const double lStepX = (ldexp( 1.0, -CompactSnowFlakes::VelocityXShift - 1 ) * lLargestScale +
+			ldexp( 1.0, -CompactSnowFlakes::PositionShift - 1 ) + ldexp( 1.0, -19 ) + lFloatStep) * lPixelsPerUnitX;
+	const double lStepY = (ldexp( 1.0, -CompactSnowFlakes::VelocityYShift - 1 ) + lFloatStep) * lPixelsPerUnitY;
+	const double lTimeUnit = ldexp( 1.0, -CompactSnowFlakes::TimeShift );
+	const double lClockError = fabs( rint( FrameTimeStep / lTimeUnit ) * lTimeUnit - FrameTimeStep );
+	const int32_t lCount = 10003;
+
+	SnowFlakes lFlakes( lCount );
+	CompactSnowFlakes lCompact( lCount );
+	std::vector<float> lBefore( lCount * 2 ), lPositions( lCount * 2 ), lColors( lCount * 4 ), lSizes( lCount );
+	std::vector<float> lTimers( lCount );
+	std::vector<uint8_t> lCompared( lCount, 1 );
+	double lWorst = 0.0;
+	double lErrorX = 0.0;
+	double lErrorY = 0.0;
+
+	// Summed over the steps so far: how far off the x step's time scale was.
+	double lScaleError = 0.0;
+
+	lFlakes.spawn( 1 );
+	lCompact.assign( lFlakes );
+
+	const float* lVelocities = lFlakes.getVelocities();
+
+	for( int32_t lStep = 1; lStep <= lSteps; ++lStep )
+	{
+		lScaleError += (lTimeUnit * 0.5 + lStep * lClockError) / TimeTillTurn + ldexp( 1.0, -14 );
+
+		memcpy( &lBefore[0], lFlakes.getPositions(), lCount * 2 * sizeof(float) );
+		memcpy( &lTimers[0], lFlakes.getTurnTimers(), lCount * sizeof(float) );
+
+		lFlakes.update( FrameTimeStep );
+		lCompact.update( FrameTimeStep );
+		lCompact.decodeRenderState( &lPositions[0], &lColors[0], &lSizes[0] );
+
+		const float* lExpected = lFlakes.getPositions();
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			if( !lCompared[i] )
+				continue;
+
+			bool lTurned = lFlakes.getTurnTimers()[i] < lTimers[i] ||
+					fabsf( lTimers[i] + FrameTimeStep - TimeTillTurn ) < 2.0f * lTick;
+			bool lRespawned = fabsf( lExpected[i * 2 + 1] - lBefore[i * 2 + 1] ) > 0.1f ||
+					fabsf( lPositions[i * 2 + 1] - lBefore[i * 2 + 1] ) > 0.1f;
+
+			if( lTurned || lRespawned )
+			{
+				lCompared[i] = 0;
+				continue;
+			}
+
+			double lX = fabsf( lPositions[i * 2 + 0] - lExpected[i * 2 + 0] ) * lPixelsPerUnitX;
+			double lY = fabsf( lPositions[i * 2 + 1] - lExpected[i * 2 + 1] ) * lPixelsPerUnitY;
+
+			lErrorX = std::max( lErrorX, lX );
+			lErrorY = std::max( lErrorY, lY );
+			double lBoundX = (lStep + 1) * lStepX + fabsf( lVelocities[i * 2 + 0] ) * lScaleError * lPixelsPerUnitX;
+			double lBoundY = (lStep + 1) * lStepY;
+
+			lWorst = std::max( lWorst, std::max( lX / lBoundX, lY / lBoundY ) );
+		}
+	}
+
+	int32_t lRemaining = 0;
+
+	for( int32_t i = 0; i < lCount; ++i )
+		lRemaining += lCompared[i];
+
+	bool lAgrees = (lWorst <= 1.0);
+	printf( "compact flakes drift from float by at most %.4f x and %.4f y pixels in %d steps, %.2f of the bound (%d flakes never turned or respawned)%s\n",
+			lErrorX, lErrorY, lSteps, lWorst, lRemaining, lAgrees ? "" : "  MISMATCH" );
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+// BlockSnowFlakes against SnowFlakes over ten seconds from the same seed,
+// turns and respawns included, which must match bit for bit. The count
+// leaves the last block partly used.
+status checkBlockFlakes()
+{
+	const int32_t lCount = 10003;
+
+	SnowFlakes lFlakes( lCount );
+	BlockSnowFlakes lBlocks( lCount );
+	std::vector<float> lPositions( lCount * 2 ), lColors( lCount * 4 ), lSizes( lCount );
+
+	lFlakes.spawn( 1 );
+	lBlocks.spawn( 1 );
+
+	for( int32_t lStep = 0; lStep < 600; ++lStep )
+	{
+		lFlakes.update( FrameTimeStep );
+		lBlocks.update( FrameTimeStep );
+	}
+
+	lBlocks.copyRenderState( &lPositions[0], &lColors[0], &lSizes[0] );
+
+	bool lAgrees = memcmp( &lPositions[0], lFlakes.getPositions(), lCount * 2 * sizeof(float) ) == 0 &&
+			memcmp( &lColors[0], lFlakes.getColors(), lCount * 4 * sizeof(float) ) == 0 &&
+			memcmp( &lSizes[0], lFlakes.getSizes(), lCount * sizeof(float) ) == 0;
+
+	printf( "block flakes %s\n", lAgrees ? "match the float flakes after 600 steps" : "MISMATCH the float flakes" );
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+template<class T>
+bool matchesFlakes( const T& pParticles, const SnowFlakes& pFlakes, bool pColors )
+{
+	int32_t lCount = pFlakes.getCount();
+
+	return memcmp( pParticles.getPositions(), pFlakes.getPositions(), lCount * 2 * sizeof(float) ) == 0 &&
+			memcmp( pParticles.getVelocities(), pFlakes.getVelocities(), lCount * 2 * sizeof(float) ) == 0 &&
+			memcmp( pParticles.getTurnTimers(), pFlakes.getTurnTimers(), lCount * sizeof(float) ) == 0 &&
+			(!pColors || memcmp( pParticles.getColors(), pFlakes.getColors(), lCount * 4 * sizeof(float) ) == 0) &&
+			memcmp( pParticles.getSizes(), pFlakes.getSizes(), lCount * sizeof(float) ) == 0;
+}
+
+// The SnowFlakes configuration of ParticleSystem, fixed and dynamic,
+// against SnowFlakes over ten seconds, which must match bit for bit; and
+// the weather configuration with no wind or noise, whose flakes must move
+// the same (only their alpha fades).
+status checkParticles()
+{
+	SnowFlakes lFlakes( 10000 );
+	FlakeParticles lParticles( 10000 );
+	FixedFlakeParticles* lFixed = new FixedFlakeParticles();
+	WeatherParticles lWeather( 10000 );
+
+	lFlakes.spawn( 1 );
+	lParticles.spawn( 1 );
+	lFixed->spawn( 1 );
+	lWeather.spawn( 1 );
+
+	for( int32_t lStep = 0; lStep < 600; ++lStep )
+	{
+		lFlakes.update( FrameTimeStep );
+		lParticles.update( FrameTimeStep );
+		lFixed->update( FrameTimeStep );
+		lWeather.update( FrameTimeStep );
+	}
+
+	bool lAgrees = matchesFlakes( lParticles, lFlakes, true ) && matchesFlakes( *lFixed, lFlakes, true ) &&
+			matchesFlakes( lWeather, lFlakes, false );
+	delete lFixed;
+
+	printf( "particle systems %s\n", lAgrees ? "match the float flakes after 600 steps" : "MISMATCH the float flakes" );
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+// Every kernel variant the CPU can run against the scalar one: stepping
+// flake blocks and packing the visible flakes must match exactly, blends
+// may differ by one where SSE rounds a half to even. Packing the flakes
+// one at a time, which only runs the scalar tail, must also keep the same
+// ones as packing them all at once.
+status checkKernelVariants()
+{
+	const Kernels* lScalar = getScalarKernels();
+	const int32_t lCount = 10003;
+	const int32_t lRowSize = 61;
+	bool lAgrees = true;
+
+	std::vector<float> lPositions( lCount * 2 ), lColors( lCount * 4 ), lSizes( lCount );
+
+	for( int32_t i = 0; i < lCount; ++i )
+	{
+		// A third of them outside the view.
+		lPositions[i * 2 + 0] = g_random.nextFloat( -1.5f * ViewMaxX, 1.5f * ViewMaxX );
+		lPositions[i * 2 + 1] = g_random.nextFloat( -1.5f * ViewMaxY, 1.5f * ViewMaxY );
+		lColors[i * 4 + 0] = lColors[i * 4 + 1] = lColors[i * 4 + 2] = lColors[i * 4 + 3] = g_random.nextFloat( 0.0f, 1.0f );
+		lSizes[i] = g_random.nextFloat( 3.0f, 6.0f );
+	}
+
+	// A tilted, off centre view, so that every term of the transform and
+	// the order they are summed in count.
+	Affine2f lTilt, lShift;
+	lTilt.rotate( 7.0f );
+	lShift.translate( Vector2f( 0.3f, -0.2f ) );
+	Affine2f lProjection = Affine2f::createOrthographicProjection( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY ) *
+			lTilt * lShift;
+
+	// Every seventh flake within a few ulps of the right edge of the view,
+	// where rounding decides.
+	for( int32_t i = 0; i < lCount; i += 7 )
+	{
+		const float* m = lProjection.m;
+		float y = lPositions[i * 2 + 1] * 0.5f;
+		float x = (lSizes[i] * (1.0f / 480) + 1.0f - (y * m[2] + m[4])) / m[0];
+
+		for( int32_t lUlps = (i / 7) % 9 - 4; lUlps != 0; lUlps += (lUlps < 0) ? 1 : -1 )
+			x = nextafterf( x, (lUlps < 0) ? -FLT_MAX : FLT_MAX );
+
+		lPositions[i * 2 + 0] = x;
+		lPositions[i * 2 + 1] = y;
+	}
+
+	std::vector<uint32_t> lTexels( 64 ), lRow( lRowSize );
+
+	for( size_t i = 0; i < lTexels.size(); ++i )
+		lTexels[i] = g_random.next();
+
+	for( int32_t i = 0; i < lRowSize; ++i )
+		lRow[i] = g_random.next();
+
+	const float lColor[4] = { 0.9f / 255.0f, 0.7f / 255.0f, 0.5f / 255.0f, 0.3f / 255.0f };
+
+	std::vector<float> lExpectedPositions( lCount * 2 ), lExpectedColors( lCount * 4 ), lExpectedSizes( lCount );
+	int32_t lExpectedVisible = lScalar->m_packVisibleFlakes( &lPositions[0], &lColors[0], &lSizes[0], lCount,
+			lProjection.m, 480, 800, &lExpectedPositions[0], &lExpectedColors[0], &lExpectedSizes[0] );
+
+	std::vector<uint32_t> lExpectedRow( lRow );
+	lScalar->m_blendSpriteRow( &lExpectedRow[0], 3, lRowSize - 2, &lTexels[0], 64, lRowSize * 0.5f, 1.0f / 50.0f, lColor );
+
+	for( int32_t v = 0; v < KERNEL_VARIANT_COUNT; ++v )
+	{
+		const Kernels* lKernels = getKernelsForVariant( (KernelVariant) v );
+
+		if( lKernels == NULL )
+			continue;
+
+		// Stepping, through BlockSnowFlakes.
+		const Kernels* lSelected = &getKernels();
+		selectKernelVariant( (KernelVariant) v );
+
+		SnowFlakes lFlakes( lCount );
+		BlockSnowFlakes lBlocks( lCount );
+		lFlakes.spawn( 2 );
+		lBlocks.spawn( 2 );
+
+		for( int32_t lStep = 0; lStep < 300; ++lStep )
+		{
+			lFlakes.update( FrameTimeStep );
+			lBlocks.update( FrameTimeStep );
+		}
+
+		selectKernelVariant( lSelected->m_variant );
+
+		std::vector<float> lBlockPositions( lCount * 2 ), lBlockColors( lCount * 4 ), lBlockSizes( lCount );
+		lBlocks.copyRenderState( &lBlockPositions[0], &lBlockColors[0], &lBlockSizes[0] );
+		bool lStepAgrees = memcmp( &lBlockPositions[0], lFlakes.getPositions(), lCount * 2 * sizeof(float) ) == 0;
+
+		// Packing.
+		std::vector<float> lOutPositions( lCount * 2 ), lOutColors( lCount * 4 ), lOutSizes( lCount );
+		int32_t lVisible = lKernels->m_packVisibleFlakes( &lPositions[0], &lColors[0], &lSizes[0], lCount,
+				lProjection.m, 480, 800, &lOutPositions[0], &lOutColors[0], &lOutSizes[0] );
+		bool lPackAgrees = lVisible == lExpectedVisible &&
+				memcmp( &lOutPositions[0], &lExpectedPositions[0], lVisible * 2 * sizeof(float) ) == 0 &&
+				memcmp( &lOutColors[0], &lExpectedColors[0], lVisible * 4 * sizeof(float) ) == 0 &&
+				memcmp( &lOutSizes[0], &lExpectedSizes[0], lVisible * sizeof(float) ) == 0;
+
+		std::vector<float> lSinglePositions( lCount * 2 ), lSingleColors( lCount * 4 ), lSingleSizes( lCount );
+		int32_t lSingleVisible = 0;
+
+		for( int32_t i = 0; i < lCount; ++i )
+		{
+			lSingleVisible += lKernels->m_packVisibleFlakes( &lPositions[i * 2], &lColors[i * 4], &lSizes[i], 1,
+					lProjection.m, 480, 800, &lSinglePositions[lSingleVisible * 2], &lSingleColors[lSingleVisible * 4],
+					&lSingleSizes[lSingleVisible] );
+		}
+
+		bool lTailAgrees = lSingleVisible == lVisible &&
+				memcmp( &lSinglePositions[0], &lOutPositions[0], lVisible * 2 * sizeof(float) ) == 0;
+
+		// Blending.
+		std::vector<uint32_t> lBlendedRow( lRow );
+		lKernels->m_blendSpriteRow( &lBlendedRow[0], 3, lRowSize - 2, &lTexels[0], 64, lRowSize * 0.5f, 1.0f / 50.0f, lColor );
+		int32_t lBlendError = 0;
+
+		for( int32_t i = 0; i < lRowSize; ++i )
+		{
+			for( int32_t c = 0; c < 32; c += 8 )
+			{
+				int32_t lDifference = (int32_t) ((lBlendedRow[i] >> c) & 0xff) - (int32_t) ((lExpectedRow[i] >> c) & 0xff);
+				lBlendError = std::max( lBlendError, abs( lDifference ) );
+			}
+		}
+
+		bool lVariantAgrees = lStepAgrees && lPackAgrees && lTailAgrees && lBlendError <= 1;
+		printf( "%s kernels: step %s, pack %s, tail %s, blend within %d of scalar%s\n", getKernelVariantName( (KernelVariant) v ),
+				lStepAgrees ? "matches" : "differs", lPackAgrees ? "matches" : "differs",
+				lTailAgrees ? "matches" : "differs", lBlendError,
+				lVariantAgrees ? "" : "  MISMATCH" );
+
+		lAgrees = lAgrees && lVariantAgrees;
+	}
+
+	return lAgrees ? STATUS_OK : STATUS_ERROR;
+}
+
+//
+// Harness...
+//
+
+// Each sample is a batch of runs lasting at least this long, so that timer
+// resolution does not matter even for the smallest sizes.
+const double MinBatchTime = 0.01;
+const int32_t MinSamples = 5;
+
+Result measure( const Benchmark& pBenchmark, double pMinTime )
+{
+	Fixture* lFixture = pBenchmark.m_create( pBenchmark.m_size );
+	int64_t lItems = pBenchmark.m_items( pBenchmark.m_size );
+
+	// Warms the caches and finds out how many runs make up a batch.
+	double lStart = getCurrentTimeInSeconds();
+	lFixture->run();
+	double lRunTime = getCurrentTimeInSeconds() - lStart;
+	int64_t lBatch = (lRunTime > 0.0) ? (int64_t) ceil( MinBatchTime / lRunTime ) : 1000;
+
+	CacheMissCounter lL1Misses( L1MissType, L1MissConfig );
+	CacheMissCounter lLastLevelMisses( LastLevelMissType, LastLevelMissConfig );
+	uint64_t lL1MissesBefore = lL1Misses.read();
+	uint64_t lLastLevelMissesBefore = lLastLevelMisses.read();
+
+	std::vector<double> lSamples;
+	uint64_t lAllocations = 0;
+	int64_t lRuns = 0;
+	double lTotal = 0.0;
+
+	while( lTotal < pMinTime || (int32_t) lSamples.size() < MinSamples )
+	{
+		uint64_t lAllocationsBefore = g_allocations.load( std::memory_order_relaxed );
+		lStart = getCurrentTimeInSeconds();
+
+		for( int64_t i = 0; i < lBatch; ++i )
+			lFixture->run();
+
+		double lTime = getCurrentTimeInSeconds() - lStart;
+		lAllocations += g_allocations.load( std::memory_order_relaxed ) - lAllocationsBefore;
+		lRuns += lBatch;
+		lTotal += lTime;
+		lSamples.push_back( lTime * 1.0e9 / (lBatch * lItems) );
+	}
+
+	// Misses include the harness's own, a few per batch.
+	uint64_t lL1MissCount = lL1Misses.read() - lL1MissesBefore;
+	uint64_t lLastLevelMissCount = lLastLevelMisses.read() - lLastLevelMissesBefore;
+
+	delete lFixture;
+
+	// The median is less sensitive to a stray context switch than the mean.
+	std::sort( lSamples.begin(), lSamples.end() );
+
+	char lName[128];
+	snprintf( lName, sizeof(lName), "%s/%d", pBenchmark.m_kernel, pBenchmark.m_size );
+
+	Result lResult;
+	lResult.m_name = lName;
+	lResult.m_nsPerItem = lSamples[lSamples.size() / 2];
+	lResult.m_bytesPerSecond = pBenchmark.m_bytesPerItem * 1.0e9 / lResult.m_nsPerItem;
+	lResult.m_allocations = AllocationsCounted ? (double) lAllocations / lRuns : -1.0;
+	lResult.m_l1MissesPerItem = lL1Misses.isAvailable() ? (double) lL1MissCount / (lRuns * lItems) : -1.0;
+	lResult.m_lastLevelMissesPerItem = lLastLevelMisses.isAvailable() ?
+			(double) lLastLevelMissCount / (lRuns * lItems) : -1.0;
+	return lResult;
+}
+
+status writeResults( const char* pPath, const std::vector<Result>& pResults )
+{
+	FILE* lFile = fopen( pPath, "w" );
+
+	if( lFile == NULL )
+		return STATUS_ERROR;
+
+	// One benchmark per line, which is also what readBaseline() relies on.
+	fprintf( lFile, "{\n" );
+	fprintf( lFile, "  \"benchmarks\": [\n" );
+
+	for( size_t i = 0; i < pResults.size(); ++i )
+	{
+		const Result& lResult = pResults[i];
+		fprintf( lFile, "    { \"name\": \"%s\", \"ns_per_item\": %.4f, \"bytes_per_second\": %.0f,"
+				" \"allocations\": %.2f, \"l1_misses_per_item\": %.4f, \"llc_misses_per_item\": %.4f }%s\n",
+				lResult.m_name.c_str(), lResult.m_nsPerItem, lResult.m_bytesPerSecond, lResult.m_allocations,
+				lResult.m_l1MissesPerItem, lResult.m_lastLevelMissesPerItem, (i + 1 < pResults.size()) ? "," : "" );
+	}
+
+	fprintf( lFile, "  ]\n" );
+	fprintf( lFile, "}\n" );
+	fclose( lFile );
+	return STATUS_OK;
+}
+
+void printMissesPerItem( double pMisses )
+{
+	if( pMisses < 0.0 )
+		printf( " %10s", "-" );
+	else
+		printf( " %10.4f", pMisses );
+}
+
+// Reads the ns_per_item of every benchmark in a file written by
+// writeResults().
+status readBaseline( const char* pPath, std::map<std::string, double>* pBaseline )
+{
+	FILE* lFile = fopen( pPath, "r" );
+
+	if( lFile == NULL )
+		return STATUS_ERROR;
+
+	char lLine[512];
+
+	while( fgets( lLine, sizeof(lLine), lFile ) != NULL )
+	{
+		const char* lName = strstr( lLine, "\"name\": \"" );
+		const char* lTime = strstr( lLine, "\"ns_per_item\": " );
+
+		if( lName == NULL || lTime == NULL )
+			continue;
+
+		lName += strlen( "\"name\": \"" );
+		const char* lNameEnd = strchr( lName, '"' );
+
+		if( lNameEnd != NULL )
+			(*pBaseline)[std::string( lName, lNameEnd )] = atof( lTime + strlen( "\"ns_per_item\": " ) );
+	}
+
+	fclose( lFile );
+	return STATUS_OK;
+}
+
+}
+
+int main( int argc, char** argv )
+{
+	const char* lFilter = NULL;
+	const char* lOutput = NULL;
+	const char* lBaselinePath = NULL;
+	double lMinTime = 0.25;
+	double lThreshold = 10.0;
+	const char* lKernels = NULL;
+	bool lCheckOnly = false;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc )
+			lFilter = argv[++i];
+		else if( strcmp( argv[i], "--min-time" ) == 0 && i + 1 < argc )
+			lMinTime = atof( argv[++i] );
+		else if( strcmp( argv[i], "--output" ) == 0 && i + 1 < argc )
+			lOutput = argv[++i];
+		else if( strcmp( argv[i], "--baseline" ) == 0 && i + 1 < argc )
+			lBaselinePath = argv[++i];
+		else if( strcmp( argv[i], "--threshold" ) == 0 && i + 1 < argc )
+			lThreshold = atof( argv[++i] );
+		else if( strcmp( argv[i], "--kernels" ) == 0 && i + 1 < argc )
+			lKernels = argv[++i];
+		else if( strcmp( argv[i], "--check" ) == 0 )
+			lCheckOnly = true;
+		else
+		{
+			fprintf( stderr, "Usage: %s [--filter TEXT] [--min-time SECONDS] [--check] [--output results.json]\n"
+					"       [--baseline baseline.json] [--threshold PERCENT] [--kernels VARIANT]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::map<std::string, double> lBaseline;
+
+	if( lBaselinePath != NULL && readBaseline( lBaselinePath, &lBaseline ) != STATUS_OK )
+	{
+		fprintf( stderr, "Unable to read %s\n", lBaselinePath );
+		return EXIT_FAILURE;
+	}
+
+	if( lKernels != NULL && selectKernelVariant( findKernelVariant( lKernels ) ) != STATUS_OK )
+	{
+		fprintf( stderr, "The %s kernels are not available on this CPU\n", lKernels );
+		return EXIT_FAILURE;
+	}
+
+	if( checkMatrices() != STATUS_OK )
+	{
+		fprintf( stderr, "The SIMD matrix code disagrees with the scalar reference\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkPointTransforms() != STATUS_OK )
+	{
+		fprintf( stderr, "The batch point transforms disagree with Matrix4x4f::transformPoint\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkSinCos() != STATUS_OK )
+	{
+		fprintf( stderr, "sinCos disagrees with libm\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkBlockFlakes() != STATUS_OK )
+	{
+		fprintf( stderr, "The block flakes disagree with the float ones\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkParticles() != STATUS_OK )
+	{
+		fprintf( stderr, "The particle systems disagree with the float flakes\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkKernelVariants() != STATUS_OK )
+	{
+		fprintf( stderr, "A kernel variant disagrees with the scalar one\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkCompactFlakes() != STATUS_OK )
+	{
+		fprintf( stderr, "The fixed point flakes disagree with the float ones\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( checkCompactDrift() != STATUS_OK )
+	{
+		fprintf( stderr, "The fixed point flakes drift further from the float ones than their rounding allows\n" );
+		return EXIT_FAILURE;
+	}
+
+	if( lCheckOnly )
+		return EXIT_SUCCESS;
+
+	printf( "\nkernels: %s\n\n", getKernelVariantName( getKernels().m_variant ) );
+
+	std::vector<Result> lResults;
+	int32_t lRegressions = 0;
+
+	printf( "%-40s %12s %14s %12s %10s %10s", "benchmark", "ns/item", "bytes/s", "allocs/run", "L1 miss", "LLC miss" );
+	printf( lBaselinePath != NULL ? " %10s\n" : "\n", "change" );
+
+	for( size_t i = 0; i < sizeof(Benchmarks) / sizeof(Benchmarks[0]); ++i )
+	{
+		char lName[128];
+		snprintf( lName, sizeof(lName), "%s/%d", Benchmarks[i].m_kernel, Benchmarks[i].m_size );
+
+		if( lFilter != NULL && strstr( lName, lFilter ) == NULL )
+			continue;
+
+		Result lResult = measure( Benchmarks[i], lMinTime );
+		lResults.push_back( lResult );
+
+		printf( "%-40s %12.3f %14.4g %12.2f", lName, lResult.m_nsPerItem, lResult.m_bytesPerSecond,
+				lResult.m_allocations );
+		printMissesPerItem( lResult.m_l1MissesPerItem );
+		printMissesPerItem( lResult.m_lastLevelMissesPerItem );
+
+		std::map<std::string, double>::const_iterator lOld = lBaseline.find( lResult.m_name );
+
+		if( lOld != lBaseline.end() && lOld->second > 0.0 )
+		{
+			double lChange = (lResult.m_nsPerItem / lOld->second - 1.0) * 100.0;
+			bool lRegressed = lChange > lThreshold;
+			printf( " %+9.1f%%%s", lChange, lRegressed ? "  REGRESSION" : "" );
+
+			if( lRegressed )
+				++lRegressions;
+		}
+
+		printf( "\n" );
+	}
+
+	if( lOutput != NULL && writeResults( lOutput, lResults ) != STATUS_OK )
+	{
+		fprintf( stderr, "Unable to write %s\n", lOutput );
+		return EXIT_FAILURE;
+	}
+
+	if( lRegressions > 0 )
+	{
+		fprintf( stderr, "%d benchmark(s) regressed by more than %.1f%%\n", lRegressions, lThreshold );
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+//
+// png_decode_bench.cpp
+// SnowFlakes
+//
+// Compares the chunked (one Resource::read per libpng request) and the
+// in-memory (bufferized resource plus read cursor) PNG decode paths of
+// Texture::loadImage on the host.
+//
+// Usage: png_decode_bench [-n iterations] [image.png ...]
+//
+// When no images are given, a set of large RGBA test images is written to
+// the temporary directory first.
+//
+
+#include "memory_tracker.h"
+#include "texture.h"
+
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+using namespace guildhall;
+
+namespace {
+
+// Texture only exposes decoding to subclasses.
+class DecodeTexture : public Texture
+{
+public:
+
+	DecodeTexture( const char* pPath ) : Texture( NULL, pPath ) {}
+
+	uint8_t* decode() { return loadImage(); }
+};
+
+double getCurrentTimeInSeconds()
+{
+	timespec lTimeVal;
+	clock_gettime( CLOCK_MONOTONIC, &lTimeVal );
+	return lTimeVal.tv_sec + (lTimeVal.tv_nsec * 1.0e-9);
+}
+
+bool writeTestImage( const std::string& pPath, uint32_t pSize )
+{
+	FILE* lFile = fopen( pPath.c_str(), "wb" );
+
+	if( lFile == NULL )
+		return false;
+
+	png_structp lPngPtr = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+	png_infop lInfoPtr = png_create_info_struct( lPngPtr );
+
+	if( setjmp( png_jmpbuf(lPngPtr) ) )
+	{
+		png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+		fclose( lFile );
+		return false;
+	}
+
+	png_init_io( lPngPtr, lFile );
+	png_set_IHDR( lPngPtr, lInfoPtr, pSize, pSize, 8, PNG_COLOR_TYPE_RGBA,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+	png_write_info( lPngPtr, lInfoPtr );
+
+	// Soft gradients with a little noise, roughly what a background or
+	// atlas compresses like.
+	std::vector<png_byte> lRow( pSize * 4 );
+
+	for( uint32_t y = 0; y < pSize; ++y )
+	{
+		for( uint32_t x = 0; x < pSize; ++x )
+		{
+			lRow[x * 4 + 0] = (png_byte)(x * 255 / pSize);
+			lRow[x * 4 + 1] = (png_byte)(y * 255 / pSize);
+			lRow[x * 4 + 2] = (png_byte)(rand() & 0x1f);
+			lRow[x * 4 + 3] = 0xff;
+		}
+
+		png_write_row( lPngPtr, &lRow[0] );
+	}
+
+	png_write_end( lPngPtr, NULL );
+	png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+	fclose( lFile );
+	return true;
+}
+
+double timeDecode( const char* pPath, bool pInMemory, int pIterations )
+{
+	double lBest = 1.0e9;
+
+	for( int i = 0; i < pIterations; ++i )
+	{
+		DecodeTexture lTexture( pPath );
+		lTexture.setInMemoryDecode( pInMemory );
+
+		double lStart = getCurrentTimeInSeconds();
+		uint8_t* lImage = lTexture.decode();
+		double lTime = getCurrentTimeInSeconds() - lStart;
+
+		if( lImage == NULL )
+			return -1.0;
+
+		freeMemory( lImage );
+
+		if( lTime < lBest )
+			lBest = lTime;
+	}
+
+	return lBest;
+}
+
+}
+
+int main( int argc, char** argv )
+{
+	int lIterations = 10;
+	std::vector<std::string> lPaths;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "-n" ) == 0 && i + 1 < argc )
+			lIterations = atoi( argv[++i] );
+		else
+			lPaths.push_back( argv[i] );
+	}
+
+	if( lPaths.empty() )
+	{
+		const char* lTempDir = getenv( "TMPDIR" );
+		std::string lBase = std::string( lTempDir ? lTempDir : "/tmp" ) + "/snowflakes_bench_";
+		const uint32_t lSizes[] = { 1024, 2048, 4096 };
+
+		for( size_t i = 0; i < sizeof(lSizes) / sizeof(lSizes[0]); ++i )
+		{
+			char lName[32];
+			snprintf( lName, sizeof(lName), "%u.png", lSizes[i] );
+			std::string lPath = lBase + lName;
+
+			if( !writeTestImage( lPath, lSizes[i] ) )
+			{
+				fprintf( stderr, "Unable to write %s\n", lPath.c_str() );
+				return EXIT_FAILURE;
+			}
+
+			lPaths.push_back( lPath );
+		}
+	}
+
+	printf( "%-40s %12s %12s %8s\n", "image", "chunked ms", "memory ms", "speedup" );
+
+	for( size_t i = 0; i < lPaths.size(); ++i )
+	{
+		double lChunked = timeDecode( lPaths[i].c_str(), false, lIterations );
+		double lMemory = timeDecode( lPaths[i].c_str(), true, lIterations );
+
+		if( lChunked < 0.0 || lMemory < 0.0 )
+		{
+			fprintf( stderr, "Unable to decode %s\n", lPaths[i].c_str() );
+			return EXIT_FAILURE;
+		}
+
+		printf( "%-40s %12.3f %12.3f %7.2fx\n", lPaths[i].c_str(),
+				lChunked * 1000.0, lMemory * 1000.0, lChunked / lMemory );
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,754 @@
+//
+// headless_snow.cpp
+// SnowFlakes
+//
+// Runs the Android simulation and OpenGL ES 2.0 draw path against an
+// offscreen EGL pbuffer (Mesa llvmpipe works) and writes per-frame timings
+// as JSON. This is the end-to-end benchmark for renderer changes. With
+// --renderer software the frames are drawn by SoftwareRenderer instead,
+// and no EGL context is needed. OpenGL ES frames also report the GPU time
+// of the draw pass when the driver has timer queries.
+// Built with GUILDHALL_PROFILER, --trace writes the profiler zones of the
+// run as a Chrome trace.
+//
+// --record writes the seed and timesteps of the run to a simulation log,
+// see SimulationRecorder. --replay runs the steps of such a log instead of
+// --duration seconds (and with its flake count), and fails when the flakes
+// diverge from the recording.
+//
+// --cache keeps linked OpenGL ES programs in the given directory, as the
+// app does (see ProgramCache).
+//
+// --check-allocations N fails the run when any frame after the first N
+// allocates through the engine's memory tracker (see memory_tracker.h),
+// and names the category of each such allocation.
+//
+// --frames N runs that many frames instead of --duration seconds. --image
+// writes the last frame as a PNG, and --compare fails the run when any
+// channel of it is further than --tolerance (2 by default) from the given
+// reference image, which is how both renderers are checked against the
+// golden image.
+//
+// --check-streaming ROWS[,ROWS...] draws nothing: it loads --texture whole
+// and then streamed in bands of each of the given numbers of rows (see
+// Texture::setStreamBandRows()), reads every texture back through a
+// framebuffer and fails unless all of them are byte for byte the same.
+//
+// Usage: headless_snow [--flakes N] [--width W] [--height H]
+//                      [--duration SECONDS] [--frames N]
+//                      [--texture snow.png]
+//                      [--renderer gles2|software] [--threads N]
+//                      [--cache DIRECTORY]
+//                      [--output timings.json] [--trace trace.json]
+//                      [--seed N] [--record run.sfr] [--replay run.sfr]
+//                      [--check-allocations FRAMES]
+//                      [--image frame.png] [--compare reference.png]
+//                      [--tolerance N]
+//                      [--check-streaming ROWS[,ROWS...]]
+//
+
+#include "memory_tracker.h"
+#include "png_image_loader.h"
+#include "profiler.h"
+#include "program_cache.h"
+#include "shader_variants.h"
+#include "simulation_log.h"
+#include "snow_renderer.h"
+#include "snowflakes.h"
+#include "software_renderer.h"
+#include "texture.h"
+#include "timer.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <png.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace guildhall;
+
+namespace {
+
+// The simulation always advances by one 60 Hz frame so that runs are
+// comparable no matter how fast frames are produced.
+const float FrameTimeStep = 1.0f / 60.0f;
+
+enum RendererType
+{
+	RENDERER_GLES2,
+	RENDERER_SOFTWARE
+};
+
+struct Options
+{
+	int32_t m_flakes;
+	int32_t m_width;
+	int32_t m_height;
+	double m_duration;
+	const char* m_texture;
+	const char* m_output;
+	RendererType m_renderer;
+	int32_t m_threads;
+	const char* m_cache;
+	const char* m_trace;
+	uint32_t m_seed;
+	const char* m_record;
+	const char* m_replay;
+	int32_t m_warmUpFrames;   // Before allocations are checked, or -1.
+	int32_t m_frames;         // Instead of m_duration, unless 0.
+	const char* m_image;
+	const char* m_compare;
+	int32_t m_tolerance;      // Per channel, for m_compare.
+	const char* m_checkStreaming;
+};
+
+struct FrameTiming
+{
+	double m_update;
+	double m_draw;
+	double m_gpu;
+	double m_gpuPass;
+	double m_frame;
+	double m_pixelsPerSecond;
+	float m_culledPercentage;
+};
+
+struct HeadlessContext
+{
+	EGLDisplay m_display;
+	EGLSurface m_surface;
+	EGLContext m_context;
+};
+
+bool parseOptions( int argc, char** argv, Options* pOptions )
+{
+	pOptions->m_flakes = 200;
+	pOptions->m_width = 480;
+	pOptions->m_height = 800;
+	pOptions->m_duration = 5.0;
+	pOptions->m_texture = "../Android/SnowFlakes/assets/snow.png";
+	pOptions->m_output = NULL;
+	pOptions->m_renderer = RENDERER_GLES2;
+	pOptions->m_threads = 4;
+	pOptions->m_cache = NULL;
+	pOptions->m_trace = NULL;
+	pOptions->m_seed = 1;
+	pOptions->m_record = NULL;
+	pOptions->m_replay = NULL;
+	pOptions->m_warmUpFrames = -1;
+	pOptions->m_frames = 0;
+	pOptions->m_image = NULL;
+	pOptions->m_compare = NULL;
+	pOptions->m_tolerance = 2;
+	pOptions->m_checkStreaming = NULL;
+
+	for( int i = 1; i < argc; ++i )
+	{
+		if( i + 1 >= argc )
+			return false;
+
+		const char* lValue = argv[++i];
+
+		if( strcmp( argv[i - 1], "--flakes" ) == 0 )
+			pOptions->m_flakes = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--width" ) == 0 )
+			pOptions->m_width = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--height" ) == 0 )
+			pOptions->m_height = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--duration" ) == 0 )
+			pOptions->m_duration = atof( lValue );
+		else if( strcmp( argv[i - 1], "--frames" ) == 0 )
+			pOptions->m_frames = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--texture" ) == 0 )
+			pOptions->m_texture = lValue;
+		else if( strcmp( argv[i - 1], "--output" ) == 0 )
+			pOptions->m_output = lValue;
+		else if( strcmp( argv[i - 1], "--threads" ) == 0 )
+			pOptions->m_threads = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--cache" ) == 0 )
+			pOptions->m_cache = lValue;
+		else if( strcmp( argv[i - 1], "--trace" ) == 0 )
+			pOptions->m_trace = lValue;
+		else if( strcmp( argv[i - 1], "--seed" ) == 0 )
+			pOptions->m_seed = (uint32_t) strtoul( lValue, NULL, 10 );
+		else if( strcmp( argv[i - 1], "--record" ) == 0 )
+			pOptions->m_record = lValue;
+		else if( strcmp( argv[i - 1], "--replay" ) == 0 )
+			pOptions->m_replay = lValue;
+		else if( strcmp( argv[i - 1], "--check-allocations" ) == 0 )
+			pOptions->m_warmUpFrames = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--image" ) == 0 )
+			pOptions->m_image = lValue;
+		else if( strcmp( argv[i - 1], "--compare" ) == 0 )
+			pOptions->m_compare = lValue;
+		else if( strcmp( argv[i - 1], "--tolerance" ) == 0 )
+			pOptions->m_tolerance = atoi( lValue );
+		else if( strcmp( argv[i - 1], "--check-streaming" ) == 0 )
+			pOptions->m_checkStreaming = lValue;
+		else if( strcmp( argv[i - 1], "--renderer" ) == 0 )
+		{
+			if( strcmp( lValue, "gles2" ) == 0 )
+				pOptions->m_renderer = RENDERER_GLES2;
+			else if( strcmp( lValue, "software" ) == 0 )
+				pOptions->m_renderer = RENDERER_SOFTWARE;
+			else
+				return false;
+		}
+		else
+			return false;
+	}
+
+	return pOptions->m_flakes > 0 && pOptions->m_width > 0 && pOptions->m_height > 0 && pOptions->m_duration > 0.0 &&
+			pOptions->m_threads > 0 && pOptions->m_frames >= 0 && pOptions->m_tolerance >= 0 &&
+			(pOptions->m_checkStreaming == NULL || pOptions->m_renderer == RENDERER_GLES2);
+}
+
+std::atomic<uint64_t> g_steadyStateAllocations( 0 );
+
+// The allocation hook of --check-allocations, once the warm-up is over.
+void countSteadyStateAllocation( MemoryCategory pCategory, size_t pBytes )
+{
+	g_steadyStateAllocations.fetch_add( 1, std::memory_order_relaxed );
+	fprintf( stderr, "Allocation of %zu bytes (%s) in a steady state frame.\n", pBytes,
+			getMemoryCategoryName( pCategory ) );
+}
+
+EGLDisplay getHeadlessDisplay()
+{
+	// Prefers Mesa's surfaceless platform, which needs neither X nor a GPU.
+	PFNEGLGETPLATFORMDISPLAYEXTPROC lGetPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+
+	if( lGetPlatformDisplay != NULL )
+	{
+		EGLDisplay lDisplay = lGetPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+
+		if( lDisplay != EGL_NO_DISPLAY )
+			return lDisplay;
+	}
+
+	return eglGetDisplay( EGL_DEFAULT_DISPLAY );
+}
+
+status createContext( const Options& pOptions, HeadlessContext* pContext )
+{
+	const EGLint lConfigAttribs[] =
+	{
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+		EGL_BLUE_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_RED_SIZE, 8,
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_NONE
+	};
+
+	const EGLint lSurfaceAttribs[] =
+	{
+		EGL_WIDTH, pOptions.m_width,
+		EGL_HEIGHT, pOptions.m_height,
+		EGL_NONE
+	};
+
+	const EGLint lContextAttribs[] =
+	{
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE
+	};
+
+	EGLConfig lConfig;
+	EGLint lConfigCount = 0;
+
+	pContext->m_display = getHeadlessDisplay();
+
+	if( pContext->m_display == EGL_NO_DISPLAY || !eglInitialize( pContext->m_display, NULL, NULL ) )
+		return STATUS_ERROR;
+
+	if( !eglChooseConfig( pContext->m_display, lConfigAttribs, &lConfig, 1, &lConfigCount ) || lConfigCount < 1 )
+		return STATUS_ERROR;
+
+	eglBindAPI( EGL_OPENGL_ES_API );
+
+	pContext->m_surface = eglCreatePbufferSurface( pContext->m_display, lConfig, lSurfaceAttribs );
+	pContext->m_context = eglCreateContext( pContext->m_display, lConfig, EGL_NO_CONTEXT, lContextAttribs );
+
+	if( pContext->m_surface == EGL_NO_SURFACE || pContext->m_context == EGL_NO_CONTEXT )
+		return STATUS_ERROR;
+
+	if( !eglMakeCurrent( pContext->m_display, pContext->m_surface, pContext->m_surface, pContext->m_context ) )
+		return STATUS_ERROR;
+
+	return STATUS_OK;
+}
+
+void destroyContext( HeadlessContext* pContext )
+{
+	eglMakeCurrent( pContext->m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+	eglDestroyContext( pContext->m_display, pContext->m_context );
+	eglDestroySurface( pContext->m_display, pContext->m_surface );
+	eglTerminate( pContext->m_display );
+}
+
+status writeTimings( const Options& pOptions, const char* pRenderer, const std::vector<FrameTiming>& pTimings )
+{
+	FILE* lFile = (pOptions.m_output != NULL) ? fopen( pOptions.m_output, "w" ) : stdout;
+
+	if( lFile == NULL )
+		return STATUS_ERROR;
+
+	fprintf( lFile, "{\n" );
+	fprintf( lFile, "  \"renderer\": \"%s\",\n", pRenderer );
+	fprintf( lFile, "  \"flakes\": %d,\n", pOptions.m_flakes );
+	fprintf( lFile, "  \"width\": %d,\n", pOptions.m_width );
+	fprintf( lFile, "  \"height\": %d,\n", pOptions.m_height );
+	fprintf( lFile, "  \"duration\": %.3f,\n", pOptions.m_duration );
+	fprintf( lFile, "  \"frames\": [\n" );
+
+	for( size_t i = 0; i < pTimings.size(); ++i )
+	{
+		const FrameTiming& lTiming = pTimings[i];
+		fprintf( lFile, "    { \"update_ms\": %.4f, \"draw_ms\": %.4f, \"gpu_ms\": %.4f, \"frame_ms\": %.4f,"
+				" \"culled_percent\": %.2f", lTiming.m_update * 1000.0, lTiming.m_draw * 1000.0,
+				lTiming.m_gpu * 1000.0, lTiming.m_frame * 1000.0, lTiming.m_culledPercentage );
+
+		if( pOptions.m_renderer == RENDERER_SOFTWARE )
+			fprintf( lFile, ", \"pixels_per_second\": %.0f", lTiming.m_pixelsPerSecond );
+		else if( pOptions.m_renderer == RENDERER_GLES2 && lTiming.m_gpuPass >= 0.0 )
+			fprintf( lFile, ", \"gpu_pass_ms\": %.4f", lTiming.m_gpuPass * 1000.0 );
+
+		fprintf( lFile, " }%s\n", (i + 1 < pTimings.size()) ? "," : "" );
+	}
+
+	fprintf( lFile, "  ]\n" );
+	fprintf( lFile, "}\n" );
+
+	if( lFile != stdout )
+		fclose( lFile );
+
+	return STATUS_OK;
+}
+
+// pPixels are RGBA, bottom row first, as both renderers produce them.
+status writeImage( const char* pPath, const std::vector<uint32_t>& pPixels, int32_t pWidth, int32_t pHeight )
+{
+	FILE* lFile = fopen( pPath, "wb" );
+
+	if( lFile == NULL )
+		return STATUS_ERROR;
+
+	png_structp lPngPtr = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+	png_infop lInfoPtr = png_create_info_struct( lPngPtr );
+
+	if( setjmp( png_jmpbuf(lPngPtr) ) )
+	{
+		png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+		fclose( lFile );
+		return STATUS_ERROR;
+	}
+
+	png_init_io( lPngPtr, lFile );
+	png_set_IHDR( lPngPtr, lInfoPtr, pWidth, pHeight, 8, PNG_COLOR_TYPE_RGBA,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+	png_write_info( lPngPtr, lInfoPtr );
+
+	std::vector<png_byte> lRow( pWidth * 4 );
+
+	for( int32_t y = pHeight - 1; y >= 0; --y )
+	{
+		for( int32_t x = 0; x < pWidth; ++x )
+		{
+			uint32_t lPixel = pPixels[y * pWidth + x];
+
+			for( int32_t c = 0; c < 4; ++c )
+				lRow[x * 4 + c] = (png_byte)(lPixel >> (c * 8));
+		}
+
+		png_write_row( lPngPtr, &lRow[0] );
+	}
+
+	png_write_end( lPngPtr, NULL );
+	png_destroy_write_struct( &lPngPtr, &lInfoPtr );
+	fclose( lFile );
+	return STATUS_OK;
+}
+
+// Fails when any channel of pPixels is further than pTolerance from the
+// reference image.
+status compareImage( const char* pPath, const std::vector<uint32_t>& pPixels, int32_t pWidth, int32_t pHeight,
+		int32_t pTolerance )
+{
+	PngImageLoader lImageLoader( NULL );
+	Image lReference;
+
+	if( lImageLoader.load( pPath, &lReference ) != STATUS_OK )
+		return STATUS_ERROR;
+
+	if( lReference.m_width != pWidth || lReference.m_height != pHeight )
+	{
+		fprintf( stderr, "%s is %dx%d, the frame %dx%d.\n", pPath, lReference.m_width, lReference.m_height,
+				pWidth, pHeight );
+		return STATUS_ERROR;
+	}
+
+	int32_t lLargest = 0;
+	int32_t lDiffering = 0;
+
+	for( size_t i = 0; i < pPixels.size(); ++i )
+	{
+		int32_t lPixelLargest = 0;
+
+		for( int32_t c = 0; c < 4; ++c )
+		{
+			int32_t lDifference = abs( (int32_t)((pPixels[i] >> (c * 8)) & 0xff) -
+					(int32_t)((lReference.m_texels[i] >> (c * 8)) & 0xff) );
+
+			if( lDifference > lPixelLargest )
+				lPixelLargest = lDifference;
+		}
+
+		if( lPixelLargest > pTolerance )
+			++lDiffering;
+
+		if( lPixelLargest > lLargest )
+			lLargest = lPixelLargest;
+	}
+
+	fprintf( stderr, "%d pixels differ from %s by more than %d per channel, the most by %d.\n", lDiffering, pPath,
+			pTolerance, lLargest );
+
+	return (lDiffering == 0) ? STATUS_OK : STATUS_ERROR;
+}
+
+// Loads pPath with the given band size (0 for the whole image at once) and
+// reads the texture back as RGBA.
+status loadAndReadBack( const char* pPath, int32_t pBandRows, std::vector<uint8_t>* pTexels )
+{
+	Texture lTexture( NULL, pPath );
+	lTexture.setStreamBandRows( pBandRows );
+
+	if( lTexture.load() != STATUS_OK )
+		return STATUS_ERROR;
+
+	// Texture keeps its name to itself, but apply() binds it.
+	GLint lTextureId = 0;
+	lTexture.apply();
+	glGetIntegerv( GL_TEXTURE_BINDING_2D, &lTextureId );
+
+	GLuint lFramebuffer = 0;
+	glGenFramebuffers( 1, &lFramebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, lFramebuffer );
+	glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, (GLuint) lTextureId, 0 );
+
+	status lResult = STATUS_ERROR;
+
+	if( glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE )
+	{
+		pTexels->assign( lTexture.getWidth() * lTexture.getHeight() * 4, 0 );
+		glReadPixels( 0, 0, lTexture.getWidth(), lTexture.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, &(*pTexels)[0] );
+
+		if( glGetError() == GL_NO_ERROR )
+			lResult = STATUS_OK;
+	}
+	else
+	{
+		fprintf( stderr, "Unable to read %s back through a framebuffer.\n", pPath );
+	}
+
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	glDeleteFramebuffers( 1, &lFramebuffer );
+	lTexture.unload();
+	return lResult;
+}
+
+// --check-streaming: pBandRows is a comma separated list of band sizes.
+status checkStreaming( const char* pPath, const char* pBandRows )
+{
+	std::vector<uint8_t> lWhole;
+	std::vector<uint8_t> lStreamed;
+
+	if( loadAndReadBack( pPath, 0, &lWhole ) != STATUS_OK )
+		return STATUS_ERROR;
+
+	status lResult = STATUS_OK;
+	const char* lNext = pBandRows;
+
+	while( *lNext != '\0' )
+	{
+		char* lEnd = NULL;
+		long lRows = strtol( lNext, &lEnd, 10 );
+
+		if( lEnd == lNext || lRows <= 0 || (*lEnd != ',' && *lEnd != '\0') )
+		{
+			fprintf( stderr, "Bad band size list: %s\n", pBandRows );
+			return STATUS_ERROR;
+		}
+
+		lNext = (*lEnd == ',') ? lEnd + 1 : lEnd;
+
+		if( loadAndReadBack( pPath, (int32_t) lRows, &lStreamed ) != STATUS_OK )
+			return STATUS_ERROR;
+
+		size_t lDiffering = 0;
+
+		for( size_t i = 0; i < lWhole.size() && i < lStreamed.size(); ++i )
+		{
+			if( lWhole[i] != lStreamed[i] )
+				++lDiffering;
+		}
+
+		if( lStreamed.size() != lWhole.size() )
+			lDiffering = lWhole.size();
+
+		fprintf( stderr, "Bands of %ld rows: %zu of %zu bytes differ from the whole image.\n", lRows, lDiffering,
+				lWhole.size() );
+
+		if( lDiffering != 0 )
+			lResult = STATUS_ERROR;
+	}
+
+	return lResult;
+}
+
+}
+
+int main( int argc, char** argv )
+{
+	Options lOptions;
+
+	if( !parseOptions( argc, argv, &lOptions ) )
+	{
+		fprintf( stderr, "Usage: %s [--flakes N] [--width W] [--height H] [--duration SECONDS]"
+				" [--texture snow.png] [--renderer gles2|software] [--threads N]"
+				" [--cache DIRECTORY] [--output timings.json]"
+				" [--trace trace.json] [--seed N] [--record run.sfr] [--replay run.sfr]"
+				" [--check-allocations FRAMES] [--frames N] [--image frame.png]"
+				" [--compare reference.png] [--tolerance N] [--check-streaming ROWS[,ROWS...]]\n", argv[0] );
+		return EXIT_FAILURE;
+	}
+
+	GUILDHALL_PROFILE_THREAD( "Main" );
+
+	// A replay simulates the flakes of the recording.
+	SimulationPlayer lPlayer;
+
+	if( lOptions.m_replay != NULL )
+	{
+		if( lPlayer.open( lOptions.m_replay ) != STATUS_OK || lPlayer.getFlakeCount() <= 0 )
+			return EXIT_FAILURE;
+
+		lOptions.m_flakes = lPlayer.getFlakeCount();
+		lOptions.m_seed = lPlayer.getSeed();
+	}
+
+	HeadlessContext lContext;
+	bool lUsesEgl = (lOptions.m_renderer == RENDERER_GLES2);
+
+	if( lUsesEgl && createContext( lOptions, &lContext ) != STATUS_OK )
+	{
+		fprintf( stderr, "Unable to create an offscreen EGL context (0x%x).\n", eglGetError() );
+		return EXIT_FAILURE;
+	}
+
+	if( lOptions.m_checkStreaming != NULL )
+	{
+		status lStreamingChecked = checkStreaming( lOptions.m_texture, lOptions.m_checkStreaming );
+		destroyContext( &lContext );
+		return (lStreamingChecked == STATUS_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	ProgramCache lProgramCache( lOptions.m_cache );
+	ShaderVariants lShaderVariants( &lProgramCache );
+	Texture lTexture( NULL, lOptions.m_texture );
+	PngImageLoader lImageLoader( NULL );
+	Image lImage;
+	SnowFlakes lSnowFlakes( lOptions.m_flakes );
+	SnowRenderer lSnowRenderer;
+	SoftwareRenderer lSoftwareRenderer( lOptions.m_threads );
+	Renderer* lRenderer;
+	status lInitialized;
+
+	if( lOptions.m_renderer == RENDERER_SOFTWARE )
+	{
+		lRenderer = &lSoftwareRenderer;
+		lInitialized = lImageLoader.load( lOptions.m_texture, &lImage );
+
+		if( lInitialized == STATUS_OK )
+			lInitialized = lSoftwareRenderer.initialize( lImage, lOptions.m_width, lOptions.m_height );
+	}
+	else
+	{
+		lRenderer = &lSnowRenderer;
+		lInitialized = lTexture.load();
+
+		if( lInitialized == STATUS_OK )
+			lInitialized = lSnowRenderer.initialize( &lShaderVariants, &lTexture, lOptions.m_width, lOptions.m_height );
+	}
+
+	if( lInitialized != STATUS_OK )
+	{
+		if( lUsesEgl )
+			destroyContext( &lContext );
+
+		return EXIT_FAILURE;
+	}
+
+	SimulationRecorder lRecorder;
+
+	if( lOptions.m_record != NULL && lRecorder.open( lOptions.m_record, lOptions.m_flakes, lOptions.m_seed ) != STATUS_OK )
+	{
+		if( lUsesEgl )
+			destroyContext( &lContext );
+
+		return EXIT_FAILURE;
+	}
+
+	// A fixed seed, so that every run simulates the same flakes.
+	lSnowFlakes.spawn( lOptions.m_seed );
+
+	std::vector<FrameTiming> lTimings;
+	std::vector<SimulationEvent> lEvents;
+	bool lDiverged = false;
+	double lStart = getCurrentTimeInSeconds();
+	double lNow = lStart;
+
+	while( lPlayer.isOpen() || ((lOptions.m_frames > 0) ? (int32_t) lTimings.size() < lOptions.m_frames :
+			lNow - lStart < lOptions.m_duration) )
+	{
+		FrameTiming lTiming;
+		double lFrameStart = lNow;
+		float lElapsed = FrameTimeStep;
+
+		lEvents.clear();
+
+		if( (int32_t) lTimings.size() == lOptions.m_warmUpFrames )
+			setAllocationHook( countSteadyStateAllocation );
+
+		if( lPlayer.isOpen() && !lPlayer.nextStep( &lElapsed, &lEvents ) )
+			break;
+
+		// Nothing in the simulation reacts to events yet, they only pass
+		// through to a new recording.
+		for( size_t i = 0; i < lEvents.size(); ++i )
+			lRecorder.recordEvent( lEvents[i] );
+
+		lSnowFlakes.update( lElapsed );
+		double lUpdated = getCurrentTimeInSeconds();
+
+		lRenderer->draw( lSnowFlakes );
+		double lSubmitted = getCurrentTimeInSeconds();
+
+		{
+			GUILDHALL_PROFILE_ZONE( "Finish" );
+
+			// Waits for the frame to finish; without timer queries this is
+			// the closest measure of the GPU side available.
+			if( lUsesEgl )
+			{
+				glFinish();
+				eglSwapBuffers( lContext.m_display, lContext.m_surface );
+			}
+		}
+
+		GUILDHALL_PROFILE_FRAME();
+		lNow = getCurrentTimeInSeconds();
+
+		// After glFinish() the pass's timer query is always available,
+		// unless a disjoint event threw it away.
+		lTiming.m_gpuPass = -1.0;
+
+		if( lUsesEgl )
+		{
+			GpuTimer& lGpuTimer = lSnowRenderer.getGpuTimer();
+			GpuTimerStats lBefore, lAfter;
+
+			lGpuTimer.getStats( &lBefore );
+			lGpuTimer.collect();
+			lGpuTimer.getStats( &lAfter );
+
+			if( lAfter.m_samples != lBefore.m_samples )
+				lTiming.m_gpuPass = lGpuTimer.getLastTime();
+		}
+
+		lTiming.m_update = lUpdated - lFrameStart;
+		lTiming.m_draw = lSubmitted - lUpdated;
+		lTiming.m_gpu = lNow - lSubmitted;
+		lTiming.m_frame = lNow - lFrameStart;
+		lTiming.m_pixelsPerSecond = lSoftwareRenderer.getPixelsPerSecond();
+		lTiming.m_culledPercentage = lRenderer->getCulledPercentage();
+		lTimings.push_back( lTiming );
+
+		// Outside of the timings, checksums are not free.
+		lRecorder.recordStep( lElapsed, lSnowFlakes );
+
+		if( lPlayer.isOpen() && lPlayer.verify( lSnowFlakes ) != STATUS_OK )
+			lDiverged = true;
+	}
+
+	setAllocationHook( NULL );
+	status lRecorded = lRecorder.close();
+
+	const char* lRendererName = "software";
+
+	if( lUsesEgl )
+		lRendererName = (const char*) glGetString( GL_RENDERER );
+
+	status lResult = writeTimings( lOptions, lRendererName, lTimings );
+
+	if( lDiverged || lRecorded != STATUS_OK )
+		lResult = STATUS_ERROR;
+
+	if( lOptions.m_image != NULL || lOptions.m_compare != NULL )
+	{
+		// A pbuffer's swap leaves its colour buffer alone, so it still
+		// holds the last frame.
+		std::vector<uint32_t> lPixels( lOptions.m_width * lOptions.m_height );
+
+		if( lUsesEgl )
+			glReadPixels( 0, 0, lOptions.m_width, lOptions.m_height, GL_RGBA, GL_UNSIGNED_BYTE, &lPixels[0] );
+		else
+			lPixels.assign( lSoftwareRenderer.getPixels(), lSoftwareRenderer.getPixels() + lPixels.size() );
+
+		if( lOptions.m_image != NULL && writeImage( lOptions.m_image, lPixels, lOptions.m_width,
+				lOptions.m_height ) != STATUS_OK )
+		{
+			fprintf( stderr, "Unable to write %s\n", lOptions.m_image );
+			lResult = STATUS_ERROR;
+		}
+
+		if( lOptions.m_compare != NULL && compareImage( lOptions.m_compare, lPixels, lOptions.m_width,
+				lOptions.m_height, lOptions.m_tolerance ) != STATUS_OK )
+			lResult = STATUS_ERROR;
+	}
+
+	if( lOptions.m_warmUpFrames >= 0 )
+	{
+		uint64_t lAllocations = g_steadyStateAllocations.load();
+		int32_t lFrames = (int32_t) lTimings.size() - lOptions.m_warmUpFrames;
+
+		fprintf( stderr, "%llu allocations in %d frames after the first %d.\n", (unsigned long long) lAllocations,
+				(lFrames > 0) ? lFrames : 0, lOptions.m_warmUpFrames );
+
+		if( lAllocations > 0 )
+			lResult = STATUS_ERROR;
+	}
+
+#ifdef GUILDHALL_PROFILER
+	if( lResult == STATUS_OK && lOptions.m_trace != NULL )
+		lResult = Profiler::writeChromeTrace( lOptions.m_trace );
+#endif
+
+	lRenderer->release();
+	lTexture.unload();
+
+	if( lUsesEgl )
+	{
+		lShaderVariants.release();
+		destroyContext( &lContext );
+	}
+
+	return (lResult == STATUS_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
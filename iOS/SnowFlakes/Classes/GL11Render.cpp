@@ -10,6 +10,9 @@
 #include <OpenGLES/ES1/glext.h>
 #include "GL11Render.hpp"
 #include "IResourceLoader.hpp"
+#include <time.h>
+
+using namespace guildhall;
 
 GL11Renderer::GL11Renderer() :
     m_framebuffer( 0 ),
@@ -19,7 +22,10 @@ GL11Renderer::GL11Renderer() :
     m_vertexBufferId( 0 ),
     m_colorBufferId( 0 ),
     m_pointSizeBufferId( 0 ),
-    m_resourceLoader(  CreateResourceLoader() )
+    m_resourceLoader(  CreateResourceLoader() ),
+    m_snowTextureDecoded( false ),
+    m_simulation( MaxSnowFlakes ),
+    m_flakes( 0 )
 {
     // Create and bind the color buffer so that the caller can allocate its space.
     glGenRenderbuffersOES( 1, &m_colorRenderbuffer );
@@ -28,6 +34,14 @@ GL11Renderer::GL11Renderer() :
 
 GL11Renderer::~GL11Renderer()
 {
+    m_simulation.stop();
+
+    if( m_textureThread.joinable() )
+        m_textureThread.join();
+
+    delete m_resourceLoader;
+    m_resourceLoader = 0;
+
     if( m_snowTextureId )
 	{
 		glDeleteTextures( 1, &m_snowTextureId );
@@ -127,39 +141,28 @@ void GL11Renderer::Initialize( int width, int height )
     glBindTexture( GL_TEXTURE_2D, m_snowTextureId );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-    TextureDescription desc = m_resourceLoader->LoadPngImage( "snow.png" );
-    GLvoid* pixels = m_resourceLoader->GetImageData();
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, desc.Width, desc.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels );
-    m_resourceLoader->UnloadImage();
+
+    // Start with a single white texel so the first frame does not have
+    // to wait for the PNG to be decoded.
+    const unsigned char white[4] = { 0xff, 0xff, 0xff, 0xff };
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white );
+
+    m_textureThread = thread( &GL11Renderer::DecodeSnowTexture, this );
 
     //
     // VBO Setup for Snow Flakes...
     //
-    
-    for( int i = 0; i < MaxSnowFlakes; ++i )
-    {
-		m_pos[i][0] = RandomFloat( -ViewMaxX, ViewMaxX );
-        m_pos[i][1] = RandomFloat( -ViewMaxY, ViewMaxY );
-        
-		m_vel[i][0] = RandomFloat( -0.004f, 0.004f ); // Flakes move side to side
-		m_vel[i][1] = RandomFloat( -0.01f, -0.008f ); // Flakes fall down
-        
-		m_col[i][0] = 1.0f;
-		m_col[i][1] = 1.0f;
-		m_col[i][2] = 1.0f;
-		m_col[i][3] = 1.0f; //RandomFloat( 0.6f, 1.0f ); // It seems that Doodle Jump snow does not use alpha.
-        
-        m_size[i] = RandomFloat( 3.0, 6.0f );
-        
-        // It looks strange if the flakes all turn at the same time, so
-        // lets vary their turn times with a random negative value.
-        m_timeSinceLastTurn[i] = RandomFloat( -5.0, 0.0f );
-	}
+
+    // Spawns the flakes and steps them on their own thread from here on.
+    // The first snapshot is published before start() returns, so there is
+    // always one to draw.
+    m_simulation.start( (uint32_t) time( NULL ) );
+    m_flakes = &m_simulation.acquire();
 
     // VBO for vertex positions.
     glGenBuffers( 1, &m_vertexBufferId );
     glBindBuffer( GL_ARRAY_BUFFER, m_vertexBufferId );
-    glBufferData( GL_ARRAY_BUFFER, sizeof(m_pos), m_pos, GL_DYNAMIC_DRAW );
+    glBufferData( GL_ARRAY_BUFFER, MaxSnowFlakes * 2 * sizeof(float), m_flakes->getPositions(), GL_DYNAMIC_DRAW );
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     
 // TODO: Due to the possibility of cache misses, it might be a little faster to
@@ -169,13 +172,13 @@ void GL11Renderer::Initialize( int width, int height )
     // VBO for vertex colors.
     glGenBuffers( 1, &m_colorBufferId );
     glBindBuffer( GL_ARRAY_BUFFER, m_colorBufferId );
-    glBufferData( GL_ARRAY_BUFFER, sizeof(m_col), m_col, GL_STATIC_DRAW );
+    glBufferData( GL_ARRAY_BUFFER, MaxSnowFlakes * 4 * sizeof(float), m_flakes->getColors(), GL_STATIC_DRAW );
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     
     // VBO for point sizes of point sprites.
     glGenBuffers( 1, &m_pointSizeBufferId );
     glBindBuffer( GL_ARRAY_BUFFER, m_pointSizeBufferId );
-    glBufferData( GL_ARRAY_BUFFER, sizeof(m_size), m_size, GL_STATIC_DRAW );
+    glBufferData( GL_ARRAY_BUFFER, MaxSnowFlakes * sizeof(float), m_flakes->getSizes(), GL_STATIC_DRAW );
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
  
     //
@@ -188,40 +191,55 @@ void GL11Renderer::Initialize( int width, int height )
     // a flat 2D game space that is 2 units wide and 3 units high.
     glMatrixMode( GL_PROJECTION );
     glOrthof( -ViewMaxX, +ViewMaxX, -ViewMaxY, +ViewMaxY, -1, 1 );
+
+    ResetHandoffStats();
 }
 
 
-void GL11Renderer::Update( float timeStep )
+void GL11Renderer::DecodeSnowTexture()
+{
+    m_resourceLoader->load( "snow.png", &m_snowImage );
+    m_snowTextureDecoded.store( true, memory_order_release );
+}
+
+void GL11Renderer::UploadSnowTexture()
 {
-	for( int i = 0; i < MaxSnowFlakes; ++i )
+    m_textureThread.join();
+
+    // Keeps the white placeholder if the image could not be loaded.
+    if( !m_snowImage.m_texels.empty() )
     {
-        // Keep track of how long it has been since this flake turned
-        // or changed direction.
-        m_timeSinceLastTurn[i] += timeStep;
-
-        if( m_timeSinceLastTurn[i] >= TimeTillTurn )
-        {
-            // Change or invert direction!
-            m_vel[i][0] = -(m_vel[i][0]);
-            m_timeSinceLastTurn[i] = RandomFloat( -5.0, 0.0f );
-        }
-        
-        // Speed up the flake up as it leaves the last turn and prepares for next turn.
-        float turnVelocityModifier = m_timeSinceLastTurn[i] * TimeTillTurnNormalizedUnit;
-        
-        // Apply some velocity to simulate gravity and wind.
-		m_pos[i][0] += (m_vel[i][0] * turnVelocityModifier); // Side to side
-		m_pos[i][1] += m_vel[i][1]; // Gravity
-        
-        // But, if the snow flake goes off the bottom or strays too far
-        // left or right - respawn it back to the top.
-        if( m_pos[i][1] < -(ViewMaxY + 0.2f) ||
-            m_pos[i][0] < -(ViewMaxX + 0.2f) || m_pos[i][0] > (ViewMaxX + 0.2f) )
-        {
-            m_pos[i][0] = RandomFloat( -ViewMaxX, ViewMaxX );
-            m_pos[i][1] = 3.1;
-        }
-	}
+        glBindTexture( GL_TEXTURE_2D, m_snowTextureId );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, m_snowImage.m_width, m_snowImage.m_height, 0,
+                      GL_RGBA, GL_UNSIGNED_BYTE, &m_snowImage.m_texels[0] );
+    }
+
+    vector<uint32_t>().swap( m_snowImage.m_texels );
+}
+
+void GL11Renderer::BeginFrame()
+{
+    if( m_textureThread.joinable() && m_snowTextureDecoded.load( memory_order_acquire ) )
+        UploadSnowTexture();
+
+    // Always the newest complete snapshot, however far the simulation
+    // has got in the meantime.
+    m_flakes = &m_simulation.acquire();
+}
+
+void GL11Renderer::EndFrame()
+{
+    m_simulation.present();
+}
+
+void GL11Renderer::GetHandoffStats( HandoffStats* stats ) const
+{
+    m_simulation.getStats( stats );
+}
+
+void GL11Renderer::ResetHandoffStats()
+{
+    m_simulation.resetStats();
 }
 
 void GL11Renderer::Render() const
@@ -247,16 +265,16 @@ void GL11Renderer::Render() const
     glEnableClientState( GL_COLOR_ARRAY );
     glEnableClientState( GL_POINT_SIZE_ARRAY_OES );
     
+    // Colors and sizes never change after spawning, so only the
+    // positions go up again.
     glBindBuffer( GL_ARRAY_BUFFER, m_vertexBufferId );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, MaxSnowFlakes * 2 * sizeof(float), m_pos );
+    glBufferSubData( GL_ARRAY_BUFFER, 0, MaxSnowFlakes * 2 * sizeof(float), m_flakes->getPositions() );
     glVertexPointer( 2, GL_FLOAT, 0, 0 );
 
     glBindBuffer( GL_ARRAY_BUFFER, m_colorBufferId );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, MaxSnowFlakes * 4 * sizeof(float), m_col );
     glColorPointer( 4, GL_FLOAT, 0, 0 );
 
     glBindBuffer( GL_ARRAY_BUFFER, m_pointSizeBufferId );
-    glBufferSubData( GL_ARRAY_BUFFER, 0, MaxSnowFlakes * sizeof(float), m_size );
     glPointSizePointerOES( GL_FLOAT, sizeof(GL_FLOAT), (GLvoid*)(sizeof(GL_FLOAT)));
 
     glDrawArrays( GL_POINTS, 0, MaxSnowFlakes );
@@ -8,22 +8,16 @@
 
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <thread>
 
-using namespace std;
+#include "IResourceLoader.hpp"
+#include "simulation_thread.h"
 
-// The Game's view size or area is 2 units wide and 3 units high.
-const float ViewMaxX = 2;
-const float ViewMaxY = 3;
+using namespace std;
 
 const int MaxSnowFlakes = 200;
 
-// Each snow flake will wait 3 seconds - then turn or change direction.
-const float TimeTillTurn = 3.0f;
-const float TimeTillTurnNormalizedUnit = 1.0f / TimeTillTurn;
-
-class IResourceLoader;
-
 // The GL11Renderer class is home to our C++/OpenGL ES 1.1 code.
 // This is where the magic happens!
 class GL11Renderer
@@ -34,11 +28,22 @@ public:
     ~GL11Renderer();
     
     void Initialize( int width, int height );
+
+    // A frame is BeginFrame(), Render(), EndFrame() and then the present.
+    // BeginFrame() takes the newest snapshot the simulation thread has
+    // published; EndFrame() records how old it is at present.
+    void BeginFrame();
     void Render() const;
-    void Update( float timeStep );
+    void EndFrame();
+
+    void GetHandoffStats( guildhall::HandoffStats* stats ) const;
+    void ResetHandoffStats();
  
 private:
 
+    void DecodeSnowTexture();
+    void UploadSnowTexture();
+
     GLuint m_framebuffer;
     GLuint m_colorRenderbuffer;
     GLuint m_depthRenderbuffer;
@@ -49,18 +54,17 @@ private:
     GLuint m_vertexBufferId;
     GLuint m_colorBufferId;
     GLuint m_pointSizeBufferId;
-    
-    float m_pos[MaxSnowFlakes][2];
-    float m_vel[MaxSnowFlakes][2];
-    float m_col[MaxSnowFlakes][4];
-    float m_size[MaxSnowFlakes];
-    float m_timeSinceLastTurn[MaxSnowFlakes];
 
     IResourceLoader* m_resourceLoader;
-};
 
-inline float RandomFloat( float min, float max )
-{
-	float r = (float)rand() / (float)RAND_MAX;
-	return min + r * (max - min);
-}
+    // The snow texture is decoded on a background thread and uploaded by
+    // BeginFrame() once ready; until then a white placeholder texel is used.
+    thread m_textureThread;
+    atomic<bool> m_snowTextureDecoded;
+    guildhall::Image m_snowImage;
+
+    // The flakes are stepped by the engine on their own thread; Render()
+    // draws the snapshot BeginFrame() took.
+    guildhall::SimulationThread m_simulation;
+    const guildhall::SnowFlakes* m_flakes;
+};
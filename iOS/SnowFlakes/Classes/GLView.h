@@ -17,8 +17,7 @@
 
     EAGLContext* m_context;
     GL11Renderer* m_renderingEngine;
-    IResourceLoader* m_resourceLoader;
-    float m_timestamp;
+    CFTimeInterval m_statsTimestamp;
 }
 
 - (void) drawView: (CADisplayLink*) displayLink;
@@ -9,6 +9,9 @@
 #import "GLView.h"
 #import "GL11Render.hpp"
 
+// How often the simulation to render handoff stats are logged.
+static const CFTimeInterval HandoffStatsInterval = 5.0;
+
 @implementation GLView
 
 + (Class) layerClass
@@ -56,7 +59,7 @@
         m_renderingEngine->Initialize( CGRectGetWidth(frame), CGRectGetHeight(frame) );
         
         [self drawView: nil];
-        m_timestamp = CACurrentMediaTime();
+        m_statsTimestamp = CACurrentMediaTime();
 
         CADisplayLink* displayLink;
         displayLink = [CADisplayLink displayLinkWithTarget:self
@@ -70,18 +73,42 @@
     return self;
 }
 
-- (void) drawView: (CADisplayLink*) displayLink
+- (void) dealloc
 {
-    if( displayLink != nil )
-    {
-        float elapsedSeconds = displayLink.timestamp - m_timestamp;
-        m_timestamp = displayLink.timestamp;
-        m_renderingEngine->Update( elapsedSeconds );
-    }
+    // The renderer deletes its GL objects, so its context must be current.
+    [EAGLContext setCurrentContext:m_context];
+    delete m_renderingEngine;
 
+    [EAGLContext setCurrentContext:nil];
+    [m_context release];
+    [super dealloc];
+}
+
+- (void) drawView: (CADisplayLink*) displayLink
+{
+    // The flakes are stepped on the renderer's simulation thread, so a
+    // frame only draws the newest snapshot.
+    m_renderingEngine->BeginFrame();
     m_renderingEngine->Render();
-    
+    m_renderingEngine->EndFrame();
+
     [m_context presentRenderbuffer:GL_RENDERBUFFER];
+
+    if( displayLink != nil && displayLink.timestamp - m_statsTimestamp >= HandoffStatsInterval )
+    {
+        guildhall::HandoffStats stats;
+        m_renderingEngine->GetHandoffStats( &stats );
+
+        if( stats.m_presented > 0 )
+        {
+            NSLog( @"Snapshots: %u published, %u dropped; frames: %u presented, %u duplicated; age %.2f ms average, %.2f ms max",
+                   stats.m_published, stats.m_dropped, stats.m_presented, stats.m_duplicated,
+                   stats.m_ageTotal * 1000.0 / stats.m_presented, stats.m_ageMax * 1000.0 );
+        }
+
+        m_renderingEngine->ResetHandoffStats();
+        m_statsTimestamp = displayLink.timestamp;
+    }
 }
 
 @end
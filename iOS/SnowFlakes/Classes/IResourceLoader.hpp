@@ -9,6 +9,7 @@
 #pragma once
 
 #include <string>
+#include "image.h"
 using std::string;
 
 enum TextureFormat
@@ -40,7 +41,9 @@ struct TextureDescription
 // are imported/included in the wrong order. To work around this, we can use
 // an Interface to postpone building of the actual ResourceLoader class until
 // certain imports/includes are complete.
-struct IResourceLoader
+//
+// It is also the engine's ImageLoader on iOS.
+struct IResourceLoader : public guildhall::ImageLoader
 {
     virtual ~IResourceLoader() {}
 
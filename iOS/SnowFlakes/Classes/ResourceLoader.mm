@@ -40,7 +40,8 @@ public:
 
         int bpp = description.BitsPerComponent / 2;
         int byteCount = description.Width * description.Height * bpp;
-        unsigned char* data = ( unsigned char* ) calloc( byteCount, 1 );
+        NSMutableData* pixels = [[NSMutableData alloc] initWithLength:byteCount];
+        void* data = [pixels mutableBytes];
         
         CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
         CGBitmapInfo bitmapInfo = kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big;
@@ -56,13 +57,18 @@ public:
         CGContextDrawImage( context, rect, uiImage.CGImage );
         CGContextRelease( context );
         
-        m_imageData = [NSData dataWithBytesNoCopy:data length:byteCount freeWhenDone:YES];
+        [m_imageData release];
+        m_imageData = pixels;
         
         return description;
     }
     
+    // May be called from a background thread, so it drains its own
+    // autorelease pool and keeps the image data retained until UnloadImage().
     TextureDescription LoadPngImage( const string& file )
     {
+        @autoreleasepool {
+
         NSString* basePath = [NSString stringWithUTF8String:file.c_str()];
         NSString* resourcePath = [[NSBundle mainBundle] resourcePath];
         NSString* fullPath = [resourcePath stringByAppendingPathComponent:basePath];
@@ -73,8 +79,8 @@ public:
         CGImageRef cgImage = uiImage.CGImage;
 
         CFDataRef dataRef = CGDataProviderCopyData( CGImageGetDataProvider( cgImage ) );
-        m_imageData = [NSData dataWithData:(NSData*) dataRef];
-        CFRelease( dataRef );
+        [m_imageData release];
+        m_imageData = (NSData*) dataRef;
         
         TextureDescription description;
         description.Width = CGImageGetWidth( cgImage );
@@ -100,8 +106,56 @@ public:
         description.BitsPerComponent = CGImageGetBitsPerComponent( cgImage );
 
         return description;
+
+        }
     }
     
+    // guildhall::ImageLoader. Expands 8 bit PNGs to RGBA and flips them
+    // bottom row first, the layout the engine works with.
+    guildhall::status load( const char* path, guildhall::Image* image )
+    {
+        TextureDescription description = LoadPngImage( path );
+        const unsigned char* data = (const unsigned char*) GetImageData();
+        int channels = 0;
+
+        switch( description.Format )
+        {
+            case TextureFormatGray: channels = 1; break;
+            case TextureFormatGrayAlpha: channels = 2; break;
+            case TextureFormatRgb: channels = 3; break;
+            case TextureFormatRgba: channels = 4; break;
+            default: break;
+        }
+
+        if( data == 0 || channels == 0 || description.BitsPerComponent != 8 )
+        {
+            UnloadImage();
+            return guildhall::STATUS_ERROR;
+        }
+
+        image->m_width = description.Width;
+        image->m_height = description.Height;
+        image->m_texels.resize( description.Width * description.Height );
+
+        for( int y = 0; y < description.Height; ++y )
+        {
+            const unsigned char* source = data + (description.Height - 1 - y) * description.Width * channels;
+            uint32_t* texel = &image->m_texels[y * description.Width];
+
+            for( int x = 0; x < description.Width; ++x, source += channels )
+            {
+                uint32_t r = source[0];
+                uint32_t g = (channels >= 3) ? source[1] : r;
+                uint32_t b = (channels >= 3) ? source[2] : r;
+                uint32_t a = (channels == 4) ? source[3] : (channels == 2) ? source[1] : 0xff;
+                texel[x] = r | (g << 8) | (b << 16) | (a << 24);
+            }
+        }
+
+        UnloadImage();
+        return guildhall::STATUS_OK;
+    }
+
     void* GetImageData()
     {
         return (void*)[m_imageData bytes];
@@ -109,6 +163,7 @@ public:
     
     void UnloadImage()
     {
+        [m_imageData release];
         m_imageData = 0;
     }
     